@@ -61,6 +61,9 @@ extern std::string BioFVM_URL;
 #include "BioFVM_vector.h" 
 #include "BioFVM_vector.h" 
 #include "BioFVM_mesh.h"
+#include "BioFVM_density_storage.h"
+#include "BioFVM_simd.h"
+#include "BioFVM_multigrid.h"
 #include "BioFVM_microenvironment.h"
 #include "BioFVM_solvers.h"
 #include "BioFVM_basic_agent.h" 
@@ -357,8 +357,6 @@ void MultiCellDS_Metadata::sync_to_microenvironment( Microenvironment& M )
 
 void MultiCellDS_Metadata::add_to_open_xml_pugi( double current_simulation_time , pugi::xml_document& xml_dom )
 {
-	static bool metadata_initialized_in_dom = false; 
-	
 	// update the current runtime 
 	RUNTIME_TOC();
 	BioFVM_metadata.current_runtime = runtime_stopwatch_value(); 
@@ -374,7 +372,9 @@ void MultiCellDS_Metadata::add_to_open_xml_pugi( double current_simulation_time
 	// Find the root.  
 	pugi::xml_node root = xml_dom.child( "MultiCellDS");
 	
-	// if the root is non-empty, just update the times. 
+	// if the root is non-empty, just update the times. (Check the DOM itself, so 
+	// that each document is set up once, whichever simulation it belongs to.) 
+	bool metadata_initialized_in_dom = root.child( "metadata" ).child( "current_time" ); 
 	if( metadata_initialized_in_dom )
 	{
 		// simulation time 
@@ -462,8 +462,6 @@ void MultiCellDS_Metadata::add_to_open_xml_pugi( double current_simulation_time
 	node.append_child( pugi::node_pcdata ).set_value( buffer ); 
 	
 	delete [] buffer; 
-	
-	metadata_initialized_in_dom = true; 
 }
 
 /* setting up the main MultiCellDS tree structure */ 
@@ -522,7 +520,7 @@ void add_BioFVM_substrates_to_open_xml_pugi( pugi::xml_document& xml_dom , std::
 	pugi::xml_node root = biofvm_doc.child( "MultiCellDS" );
 	pugi::xml_node node = root.child( "microenvironment" ); 
 	
-	static bool BioFVM_substrates_initialized_in_dom = false; 
+	bool BioFVM_substrates_initialized_in_dom = node.child( "domain" ); 
 	
 	// if the TME has not yet been initialized in the DOM, create all the 
 	// right data elements, and populate the meshes. 
@@ -732,8 +730,6 @@ void add_BioFVM_substrates_to_open_xml_pugi( pugi::xml_document& xml_dom , std::
 		}
 		node = node.parent(); 
 		
-		BioFVM_substrates_initialized_in_dom = true; 
-		
 		delete [] buffer; 
 		
 		return; 
@@ -800,21 +796,14 @@ void add_BioFVM_agents_to_open_xml_pugi( pugi::xml_document& xml_dom, std::strin
 	// Let's reduce memory allocations and sprintf calls. 
 	// This reduces execution time by around 30%. (e.g., write time for 1,000,000 cells decreases from 
 	// 45 to 30 seconds on an older machine. 
-	static char* temp; 
-	static bool initialized = false; 
+	char temp [1024]; 
 	
-	static char rate_chars [1024]; 
-	static char volume_chars [1024]; 
-	static char diffusion_chars [1024]; 
-	if( !initialized )
-	{ 
-		temp = new char [1024]; 
-		initialized = true; 
-		
-		sprintf( rate_chars, "1/%s" , M.time_units.c_str() ); 
-		sprintf( volume_chars, "%s^3" , M.spatial_units.c_str() ); 
-		sprintf( diffusion_chars , "%s^2/%s", M.spatial_units.c_str() , M.time_units.c_str() ); 
-	}
+	char rate_chars [1024]; 
+	char volume_chars [1024]; 
+	char diffusion_chars [1024]; 
+	sprintf( rate_chars, "1/%s" , M.time_units.c_str() ); 
+	sprintf( volume_chars, "%s^3" , M.spatial_units.c_str() ); 
+	sprintf( diffusion_chars , "%s^2/%s", M.spatial_units.c_str() , M.time_units.c_str() ); 
 
 	node = node.child( "cell_populations" ); 
 	if( !node )
@@ -1322,7 +1311,10 @@ void read_microenvironment_from_MultiCellDS_xml( Microenvironment& M_destination
 
 				// now, read the actual data 
 				for( int i=start_row; i < rows ; i++ )
-				{ fread( (char*) &( M_destination.density_vector(j)[i-start_row] ) , sizeof(double) , 1 , fp ); }
+				{
+					fread( (char*) &temp , sizeof(double) , 1 , fp ); 
+					M_destination.density_vector(j)[i-start_row] = temp; 
+				}
 			} 
 			
 			fclose( fp );
@@ -1331,9 +1323,11 @@ void read_microenvironment_from_MultiCellDS_xml( Microenvironment& M_destination
 		{
 			// attempt to read it in as XML data, voxel by voxel 
 			node = node.child( "density_vector" ); 
+			std::vector<double> temp_density; 
 			for( int j=0 ; j < M_destination.mesh.voxels.size() ; j++ )
 			{
-				csv_to_vector( node.first_child().value() , M_destination.density_vector(j)  ); 
+				csv_to_vector( node.first_child().value() , temp_density ); 
+				M_destination.density_vector(j) = temp_density; 
 				if( node.next_sibling( "density_vector" ) ) 
 				{ node = node.next_sibling( "density_vector" ); }		
 			}
@@ -53,21 +53,24 @@
 namespace BioFVM{
 
 std::vector<Basic_Agent*> all_basic_agents(0); 
+// the next agent ID (kept with the agent list, rather than as a static in the constructor) 
+int max_basic_agent_ID = 0; 
 
 Basic_Agent::Basic_Agent()
 {
 	//give the agent a unique ID  
-	static int max_basic_agent_ID = 0; 
 	ID = max_basic_agent_ID; // 
 	max_basic_agent_ID++; 
 	// initialize position and velocity
 	is_active=true;
 	
 	volume = 1.0; 
+	source_sink_generation = 1; 
+	source_sink_checked_generation = 0; 
 	
-	position.assign( 3 , 0.0 ); 
-	velocity.assign( 3 , 0.0 );
-	previous_velocity.assign( 3 , 0.0 ); 
+	position = Vec3(); 
+	velocity = Vec3();
+	previous_velocity = Vec3(); 
 	// link into the microenvironment, if one is defined 
 	secretion_rates= new std::vector<double>(0);
 	uptake_rates= new std::vector<double>(0);
@@ -123,20 +126,57 @@ void Basic_Agent::set_internal_uptake_constants( double dt )
 	//   p(n+1)*temp2 =  p(n) + temp1
 	//   p(n+1) = (  p(n) + temp1 )/temp2
 	//int nearest_voxel= current_voxel_index;
-	double internal_constant_to_discretize_the_delta_approximation = dt * volume / ( (microenvironment->voxels(current_voxel_index)).volume ) ; // needs a fix 
-
-	// temp1 = dt*(V_cell/V_voxel)*S*T 
-	cell_source_sink_solver_temp1.assign( (*secretion_rates).size() , 0.0 ); 
-	cell_source_sink_solver_temp1 += *secretion_rates; 
-	cell_source_sink_solver_temp1 *= *saturation_densities; 
-	cell_source_sink_solver_temp1 *= internal_constant_to_discretize_the_delta_approximation; 
-
-	// temp2 = 1 + dt*(V_cell/V_voxel)*( S + U )
-	cell_source_sink_solver_temp2.assign( (*secretion_rates).size() , 1.0 ); 
-	axpy( &(cell_source_sink_solver_temp2) , internal_constant_to_discretize_the_delta_approximation , *secretion_rates );
-	axpy( &(cell_source_sink_solver_temp2) , internal_constant_to_discretize_the_delta_approximation , *uptake_rates );	
+	double voxel_volume = (microenvironment->voxels(current_voxel_index)).volume; 
+	double internal_constant_to_discretize_the_delta_approximation = dt * volume / voxel_volume ; // needs a fix 
+
+	int number_of_substrates = (*secretion_rates).size(); 
+	cell_source_sink_coefficients.resize( 2*number_of_substrates ); 
+	double* temp1 = cell_source_sink_coefficients.data(); 
+	double* temp2 = temp1 + number_of_substrates; 
+	
+	for( int i=0; i < number_of_substrates ; i++ )
+	{
+		// temp1 = dt*(V_cell/V_voxel)*S*T 
+		temp1[i] = (*secretion_rates)[i] * (*saturation_densities)[i]; 
+		temp1[i] *= internal_constant_to_discretize_the_delta_approximation; 
+		
+		// temp2 = 1 + dt*(V_cell/V_voxel)*( S + U )
+		temp2[i] = 1.0; 
+		temp2[i] += internal_constant_to_discretize_the_delta_approximation * (*secretion_rates)[i]; 
+		temp2[i] += internal_constant_to_discretize_the_delta_approximation * (*uptake_rates)[i]; 
+	}
+	
+	// remember the inputs, to detect when these change 
+	cell_source_sink_inputs = *secretion_rates; 
+	cell_source_sink_inputs.insert( cell_source_sink_inputs.end() , uptake_rates->begin() , uptake_rates->end() ); 
+	cell_source_sink_inputs.insert( cell_source_sink_inputs.end() , saturation_densities->begin() , saturation_densities->end() ); 
+	cell_source_sink_inputs.push_back( volume ); 
+	cell_source_sink_inputs.push_back( voxel_volume ); 
+	cell_source_sink_inputs.push_back( dt ); 
+	
+	source_sink_checked_generation = source_sink_generation; 
+	return; 
+}
+
+bool Basic_Agent::source_sink_inputs_changed( double dt )
+{
+	int number_of_substrates = (*secretion_rates).size(); 
+	if( cell_source_sink_inputs.size() != 3*number_of_substrates + 3 )
+	{ return true; }
+	
+	const double* inputs = cell_source_sink_inputs.data(); 
+	for( int i=0; i < number_of_substrates ; i++ )
+	{
+		if( inputs[i] != (*secretion_rates)[i] || 
+			inputs[number_of_substrates+i] != (*uptake_rates)[i] || 
+			inputs[2*number_of_substrates+i] != (*saturation_densities)[i] )
+		{ return true; }
+	}
+	inputs += 3*number_of_substrates; 
 	
-	volume_is_changed = false; 
+	return inputs[0] != volume || 
+		inputs[1] != (microenvironment->voxels(current_voxel_index)).volume || 
+		inputs[2] != dt; 
 }
 
 void Basic_Agent::register_microenvironment( Microenvironment* microenvironment_in )
@@ -146,9 +186,11 @@ void Basic_Agent::register_microenvironment( Microenvironment* microenvironment_
 	saturation_densities->resize( microenvironment->density_vector(0).size() , 0.0 );
 	uptake_rates->resize( microenvironment->density_vector(0).size() , 0.0 );	
 
-	// some solver temporary variables 
-	cell_source_sink_solver_temp1.resize( microenvironment->density_vector(0).size() , 0.0 );
-	cell_source_sink_solver_temp2.resize( microenvironment->density_vector(0).size() , 1.0 );
+	// some solver temporary variables: temp1 = 0, temp2 = 1 
+	cell_source_sink_coefficients.assign( microenvironment->density_vector(0).size() , 0.0 );
+	cell_source_sink_coefficients.resize( 2*microenvironment->density_vector(0).size() , 1.0 );
+	cell_source_sink_inputs.clear(); 
+	source_sink_generation++; 
 	return; 
 }
 
@@ -160,6 +202,40 @@ Basic_Agent::~Basic_Agent()
  return; 
 }
 
+void Basic_Agent::write_snapshot( Snapshot_Buffer& buffer )
+{
+	buffer.write_value( ID ); 
+	buffer.write_value( type ); 
+	buffer.write_vector( position ); 
+	buffer.write_vector( velocity ); 
+	buffer.write_vector( previous_velocity ); 
+	buffer.write_value( volume ); 
+	buffer.write_value( is_active ); 
+	buffer.write_value( selected_microenvironment ); 
+	buffer.write_value( current_voxel_index ); 
+	buffer.write_value( current_microenvironment_voxel_index ); 
+	return; 
+}
+
+bool Basic_Agent::read_snapshot( Snapshot_Buffer& buffer )
+{
+	buffer.read_value( ID ); 
+	buffer.read_value( type ); 
+	buffer.read_vector( position ); 
+	buffer.read_vector( velocity ); 
+	buffer.read_vector( previous_velocity ); 
+	buffer.read_value( volume ); 
+	buffer.read_value( is_active ); 
+	buffer.read_value( selected_microenvironment ); 
+	buffer.read_value( current_voxel_index ); 
+	buffer.read_value( current_microenvironment_voxel_index ); 
+	
+	// recompute the secretion / uptake coefficients at the next use 
+	source_sink_generation++; 
+	
+	return !buffer.read_failed; 
+}
+
 Basic_Agent* create_basic_agent( void )
 {
 	Basic_Agent* pNew; 
@@ -209,20 +285,20 @@ int Basic_Agent::get_current_voxel_index( void )
 	return current_voxel_index;
 }
 
-std::vector<double>& Basic_Agent::nearest_density_vector( void ) 
+Density_Vector Basic_Agent::nearest_density_vector( void ) 
 {  
 	return microenvironment->nearest_density_vector( current_voxel_index ); 
 }
 
 
 // directly access the gradient of substrate n nearest to the cell 
-std::vector<double>& Basic_Agent::nearest_gradient( int substrate_index )
+gradient Basic_Agent::nearest_gradient( int substrate_index )
 {
-	return microenvironment->gradient_vector(current_voxel_index)[substrate_index]; 
+	return microenvironment->substrate_gradient(current_voxel_index,substrate_index); 
 }
 
 	// directly access a vector of gradients, one gradient per substrate 
-std::vector<gradient>& Basic_Agent::nearest_gradient_vector( void )
+std::vector<gradient> Basic_Agent::nearest_gradient_vector( void )
 {
 	return microenvironment->gradient_vector(current_voxel_index); 
 }
@@ -231,7 +307,8 @@ std::vector<gradient>& Basic_Agent::nearest_gradient_vector( void )
 void Basic_Agent::set_total_volume(double volume)
 {
 	this->volume = volume;
-	volume_is_changed = true;
+	// the cell's rates are often changed together with its volume, so check all the inputs 
+	source_sink_generation++; 
 }
 
 double Basic_Agent::get_total_volume()
@@ -243,13 +320,26 @@ void Basic_Agent::simulate_secretion_and_uptake( Microenvironment* pS, double dt
 	if(!is_active)
 	{ return; }
 	
-	if( volume_is_changed )
+	// refresh the coefficients only if their inputs changed 
+	if( source_sink_checked_generation != source_sink_generation || cell_source_sink_inputs.back() != dt )
+	{
+		if( source_sink_inputs_changed( dt ) )
+		{ set_internal_uptake_constants( dt ); }
+		source_sink_checked_generation = source_sink_generation; 
+	}
+	
+	Density_Vector density = (*pS)(current_voxel_index); 
+	int number_of_substrates = cell_source_sink_coefficients.size() / 2; 
+	const double* temp1 = cell_source_sink_coefficients.data(); 
+	const double* temp2 = temp1 + number_of_substrates; 
+	for( int i=0; i < number_of_substrates ; i++ )
 	{
-		set_internal_uptake_constants(dt);
-		volume_is_changed = false;
+		// substrates at steady state are left untouched (see Microenvironment::set_steady_state_detection), 
+		// and quasi-steady substrates include the cells in their steady-state solve 
+		if( pS->substrate_is_frozen(i) || pS->substrate_is_quasi_steady(i) )
+		{ continue; }
+		density[i] = ( density[i] + temp1[i] ) / temp2[i]; 
 	}
-	(*pS)(current_voxel_index) += cell_source_sink_solver_temp1; 
-	(*pS)(current_voxel_index) /= cell_source_sink_solver_temp2; 
 
 	return; 
 }
@@ -65,13 +65,22 @@ class Basic_Agent
 	
 	int current_microenvironment_voxel_index;
 	double volume;
-	bool volume_is_changed;
 	int current_voxel_index;	
 	
+	/*! bumped whenever the secretion / uptake inputs may have changed (e.g., by set_total_volume). 
+	    The coefficients are checked against their inputs, and refreshed only if these 
+	    actually changed, the next time they are used. */ 
+	unsigned int source_sink_generation; 
+	unsigned int source_sink_checked_generation; 
+	bool source_sink_inputs_changed( double dt ); 
+	
  protected:
-	std::vector<double> cell_source_sink_solver_temp1;
-	std::vector<double> cell_source_sink_solver_temp2;
-	std::vector<double> previous_velocity; 
+	/*! secretion / uptake coefficients, stored contiguously as [ temp1 | temp2 ] with one entry 
+	    per substrate each (see set_internal_uptake_constants), and the inputs they were computed from: 
+	    [ secretion rates | uptake rates | saturation densities | volume | voxel volume | dt ] */ 
+	std::vector<double> cell_source_sink_coefficients; 
+	std::vector<double> cell_source_sink_inputs; 
+	Vec3 previous_velocity; 
 	bool is_active;
 	
  public:
@@ -94,8 +103,8 @@ class Basic_Agent
 	bool assign_position(double x, double y, double z);
 	bool assign_position(std::vector<double> new_position);
 	
-	std::vector<double> position;  
-	std::vector<double> velocity; 
+	Vec3 position;  
+	Vec3 velocity; 
 	void update_position( double dt );
 	
 	Basic_Agent(); 
@@ -106,16 +115,22 @@ class Basic_Agent
 
 	int get_current_voxel_index( void ); 
 	// directly access the substrate vector at the nearest voxel at the indicated microenvironment 
-	std::vector<double>& nearest_density_vector( int microenvironment_index ); // not implemented!
-	std::vector<double>& nearest_density_vector( void );
+	Density_Vector nearest_density_vector( int microenvironment_index ); // not implemented!
+	Density_Vector nearest_density_vector( void );
 	
 	// directly access the gradient of substrate n nearest to the cell 
-	std::vector<double>& nearest_gradient( int substrate_index );
+	gradient nearest_gradient( int substrate_index );
 	// directly access a vector of gradients, one gradient per substrate 
-	std::vector<gradient>& nearest_gradient_vector( void ); 
+	std::vector<gradient> nearest_gradient_vector( void ); 
+	
+	// save / restore the agent's kinematic and voxel state in a binary snapshot 
+	// (the rate vectors belong to the owner, e.g., a PhysiCell phenotype) 
+	void write_snapshot( Snapshot_Buffer& buffer ); 
+	bool read_snapshot( Snapshot_Buffer& buffer ); 
 };
 
 extern std::vector<Basic_Agent*> all_basic_agents; 
+extern int max_basic_agent_ID; 
 
 Basic_Agent* create_basic_agent( void );
 void delete_basic_agent( int ); 
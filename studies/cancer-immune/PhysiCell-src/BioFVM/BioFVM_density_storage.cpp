@@ -0,0 +1,197 @@
+/*
+#############################################################################
+# If you use BioFVM in your project, please cite BioFVM and the version     #
+# number, such as below:                                                    #
+#                                                                           #
+# We solved the diffusion equations using BioFVM (Version 1.1.7) [1]        #
+#                                                                           #
+# [1] A. Ghaffarizadeh, S.H. Friedman, and P. Macklin, BioFVM: an efficient #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the BioFVM Project              #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#include "BioFVM_density_storage.h"
+#include <iostream>
+#include <utility>
+
+namespace BioFVM{
+
+Density_Vector& Density_Vector::operator=( const std::vector<double>& v )
+{
+	for( int i=0; i < length ; i++ )
+	{ data[i*stride] = v[i]; }
+	return *this; 
+}
+
+Density_Vector& Density_Vector::operator=( const Density_Vector& v )
+{
+	for( int i=0; i < length ; i++ )
+	{ data[i*stride] = v[i]; }
+	return *this; 
+}
+
+void Density_Vector::operator+=( const std::vector<double>& v )
+{
+	for( int i=0; i < length ; i++ )
+	{ data[i*stride] += v[i]; }
+	return; 
+}
+
+void Density_Vector::operator-=( const std::vector<double>& v )
+{
+	for( int i=0; i < length ; i++ )
+	{ data[i*stride] -= v[i]; }
+	return; 
+}
+
+void Density_Vector::operator*=( const std::vector<double>& v )
+{
+	for( int i=0; i < length ; i++ )
+	{ data[i*stride] *= v[i]; }
+	return; 
+}
+
+void Density_Vector::operator/=( const std::vector<double>& v )
+{
+	for( int i=0; i < length ; i++ )
+	{ data[i*stride] /= v[i]; }
+	return; 
+}
+
+void Density_Vector::operator*=( double a )
+{
+	for( int i=0; i < length ; i++ )
+	{ data[i*stride] *= a; }
+	return; 
+}
+
+Density_Vector::operator std::vector<double>( void ) const
+{
+	std::vector<double> output( length ); 
+	for( int i=0; i < length ; i++ )
+	{ output[i] = data[i*stride]; }
+	return output; 
+}
+
+std::ostream& operator<<( std::ostream& os , const Density_Vector& v )
+{
+	for( int i=0; i < v.size(); i++ )
+	{ os << v[i] << " " ; }
+	return os; 
+}
+
+Density_Storage::Density_Storage()
+{
+	voxel_count = 0; 
+	density_count = 0; 
+	layout = density_layout_voxel_major; 
+	return; 
+}
+
+void Density_Storage::assign( int number_of_voxels , const std::vector<double>& value )
+{
+	voxel_count = number_of_voxels; 
+	density_count = value.size(); 
+	data.resize( (size_t) voxel_count * density_count ); 
+
+	int vs = voxel_stride(); 
+	int ss = substrate_stride(); 
+	for( int n=0; n < voxel_count ; n++ )
+	{
+		for( int q=0; q < density_count ; q++ )
+		{ data[ n*vs + q*ss ] = value[q]; }
+	}
+	return; 
+}
+
+void Density_Storage::add_density( double value )
+{
+	aligned_density_vector new_data( (size_t) voxel_count * (density_count+1) ); 
+	
+	// new strides, after adding a substrate 
+	int new_vs = ( layout == density_layout_voxel_major ) ? density_count+1 : 1; 
+	int new_ss = ( layout == density_layout_voxel_major ) ? 1 : voxel_count; 
+
+	int vs = voxel_stride(); 
+	int ss = substrate_stride(); 
+	for( int n=0; n < voxel_count ; n++ )
+	{
+		for( int q=0; q < density_count ; q++ )
+		{ new_data[ n*new_vs + q*new_ss ] = data[ n*vs + q*ss ]; }
+		new_data[ n*new_vs + density_count*new_ss ] = value; 
+	}
+	
+	data.swap( new_data ); 
+	density_count++; 
+	return; 
+}
+
+void Density_Storage::set_layout( int new_layout )
+{
+	if( new_layout == layout )
+	{ return; }
+
+	aligned_density_vector new_data( data.size() ); 
+	int vs = voxel_stride(); 
+	int ss = substrate_stride(); 
+	
+	layout = new_layout; 
+	int new_vs = voxel_stride(); 
+	int new_ss = substrate_stride(); 
+
+	for( int n=0; n < voxel_count ; n++ )
+	{
+		for( int q=0; q < density_count ; q++ )
+		{ new_data[ n*new_vs + q*new_ss ] = data[ n*vs + q*ss ]; }
+	}
+	
+	data.swap( new_data ); 
+	return; 
+}
+
+void Density_Storage::swap( Density_Storage& other )
+{
+	data.swap( other.data ); 
+	std::swap( voxel_count , other.voxel_count ); 
+	std::swap( density_count , other.density_count ); 
+	std::swap( layout , other.layout ); 
+	return; 
+}
+
+};
@@ -0,0 +1,189 @@
+/*
+#############################################################################
+# If you use BioFVM in your project, please cite BioFVM and the version     #
+# number, such as below:                                                    #
+#                                                                           #
+# We solved the diffusion equations using BioFVM (Version 1.1.7) [1]        #
+#                                                                           #
+# [1] A. Ghaffarizadeh, S.H. Friedman, and P. Macklin, BioFVM: an efficient #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the BioFVM Project              #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#ifndef __BioFVM_density_storage_h__
+#define __BioFVM_density_storage_h__
+
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+namespace BioFVM{
+
+/* a minimal allocator that aligns blocks to a cache line (and hence to any SIMD width), 
+   so that std::vector can own buffers that the solvers stream through */ 
+
+template <class T, std::size_t alignment = 64>
+class Aligned_Allocator
+{
+ public:
+	typedef T value_type; 
+	template <class U> struct rebind { typedef Aligned_Allocator<U,alignment> other; }; 
+
+	Aligned_Allocator() {}
+	template <class U> Aligned_Allocator( const Aligned_Allocator<U,alignment>& ) {}
+
+	T* allocate( std::size_t n )
+	{
+		// over-allocate, and store the original pointer just before the aligned block 
+		void* raw = std::malloc( n*sizeof(T) + alignment + sizeof(void*) ); 
+		if( raw == NULL )
+		{ throw std::bad_alloc(); }
+		std::uintptr_t address = (std::uintptr_t) raw + sizeof(void*); 
+		address = ( address + alignment - 1 ) & ~( (std::uintptr_t) alignment - 1 ); 
+		((void**) address)[-1] = raw; 
+		return (T*) address; 
+	}
+	void deallocate( T* p , std::size_t /*n*/ )
+	{
+		if( p )
+		{ std::free( ((void**) p)[-1] ); }
+	}
+};
+
+template <class T, class U, std::size_t A>
+bool operator==( const Aligned_Allocator<T,A>& , const Aligned_Allocator<U,A>& ) { return true; }
+template <class T, class U, std::size_t A>
+bool operator!=( const Aligned_Allocator<T,A>& , const Aligned_Allocator<U,A>& ) { return false; }
+
+typedef std::vector< double , Aligned_Allocator<double> > aligned_vector; 
+
+/* precision of the stored substrate densities and gradients. Building with 
+   -DBIOFVM_SINGLE_PRECISION_DENSITIES stores them as float, which halves the memory 
+   and bandwidth of the diffusion sweeps. Solver coefficients stay double, and the 
+   LOD solvers still eliminate (and accumulate) in double precision. */ 
+
+#ifdef BIOFVM_SINGLE_PRECISION_DENSITIES
+typedef float density_type; 
+#else
+typedef double density_type; 
+#endif 
+
+typedef std::vector< density_type , Aligned_Allocator<density_type> > aligned_density_vector; 
+
+/* density layouts: 
+   voxel_major:     [voxel][substrate] (each voxel's substrates are contiguous) 
+   substrate_major: [substrate][voxel] (each substrate field is contiguous) */ 
+
+static const int density_layout_voxel_major = 0; 
+static const int density_layout_substrate_major = 1; 
+
+/*! A lightweight (non-owning) view of the substrate vector at one voxel. Copying 
+    a Density_Vector copies the view; assigning to it copies values into the 
+    underlying storage. Convert to std::vector<double> to keep a private copy. */
+
+class Density_Vector
+{
+ private:
+	density_type* data; 
+	int length; 
+	int stride; 
+
+ public:
+	Density_Vector( density_type* data_in , int length_in , int stride_in )
+	: data( data_in ), length( length_in ), stride( stride_in ) {}
+	Density_Vector( const Density_Vector& copy_me ) = default; 
+
+	density_type& operator[]( int i ) { return data[i*stride]; }
+	const density_type& operator[]( int i ) const { return data[i*stride]; }
+	int size( void ) const { return length; }
+
+	Density_Vector& operator=( const std::vector<double>& v ); 
+	Density_Vector& operator=( const Density_Vector& v ); 
+	
+	void operator+=( const std::vector<double>& v ); 
+	void operator-=( const std::vector<double>& v ); 
+	void operator*=( const std::vector<double>& v ); 
+	void operator/=( const std::vector<double>& v ); 
+	void operator*=( double a ); 
+	
+	operator std::vector<double>( void ) const; 
+};
+
+std::ostream& operator<<( std::ostream& os , const Density_Vector& v ); 
+
+/*! Contiguous storage of all substrate densities on all voxels, in a single 
+    aligned buffer. Element (n,q) is at data[ n*voxel_stride() + q*substrate_stride() ]. */
+
+class Density_Storage
+{
+ private:
+	aligned_density_vector data; 
+	int voxel_count; 
+	int density_count; 
+	int layout; 
+	
+ public:
+	Density_Storage(); 
+	
+	void assign( int number_of_voxels , const std::vector<double>& value ); 
+	void add_density( double value ); // appends a substrate to every voxel 
+	void set_layout( int new_layout ); // reorders the data if needed 
+	
+	int get_layout( void ) const { return layout; } 
+	int number_of_voxels( void ) const { return voxel_count; } 
+	int number_of_densities( void ) const { return density_count; } 
+
+	int voxel_stride( void ) const 
+	{ return layout == density_layout_voxel_major ? density_count : 1; } 
+	int substrate_stride( void ) const 
+	{ return layout == density_layout_voxel_major ? 1 : voxel_count; } 
+
+	density_type* pointer( void ) { return data.data(); } 
+	density_type& value( int n , int q ) { return data[ n*voxel_stride() + q*substrate_stride() ]; }
+	Density_Vector operator()( int n )
+	{ return Density_Vector( data.data() + n*voxel_stride() , density_count , substrate_stride() ); } 
+	
+	void swap( Density_Storage& other ); 
+};
+
+};
+
+#endif
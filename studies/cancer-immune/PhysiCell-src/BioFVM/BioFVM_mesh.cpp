@@ -877,10 +877,16 @@ void Cartesian_Mesh::resize_uniform( double x_start, double x_end, double y_star
 { return resize( x_start, x_end, y_start, y_end, z_start, z_end , dx_new, dx_new , dx_new ); }
 
 int Cartesian_Mesh::nearest_voxel_index( std::vector<double>& position )
+{ return nearest_voxel_index( position[0] , position[1] , position[2] ); }
+
+int Cartesian_Mesh::nearest_voxel_index( const Vec3& position )
+{ return nearest_voxel_index( position[0] , position[1] , position[2] ); }
+
+int Cartesian_Mesh::nearest_voxel_index( double x , double y , double z )
 {
-	int i = (int) floor( (position[0]-bounding_box[0])/dx ); 
-	int j = (int) floor( (position[1]-bounding_box[1])/dy ); 
-	int k = (int) floor( (position[2]-bounding_box[2])/dz ); 
+	int i = (int) floor( (x-bounding_box[0])/dx ); 
+	int j = (int) floor( (y-bounding_box[1])/dy ); 
+	int k = (int) floor( (z-bounding_box[2])/dz ); 
 
 	//  add some bounds checking -- truncate to inside the computational domain   
 
@@ -50,6 +50,7 @@
 #include "BioFVM_solvers.h"
 #include "BioFVM_vector.h"
 #include <cmath>
+#include <omp.h>
 
 #include "BioFVM_basic_agent.h"
 
@@ -114,6 +115,18 @@ Microenvironment::Microenvironment()
 	bulk_source_sink_solver_setup_done = false; 
 	thomas_setup_done = false; 
 	diffusion_solver_setup_done = false; 
+	explicit_max_weight_sum = 0.0; 
+	thomas_kernel = select_batched_thomas_kernel(); 
+	thomas_scratch_length = 0; 
+	fused_cell_sources_and_sinks = false; 
+	gradient_epoch = 1; 
+	zero_gradient = Vec3(); 
+	diffusion_step_count = 0; 
+	steady_state_tolerance = 0.0; 
+	steady_state_source_tolerance = 0.01; 
+	steady_state_check_interval = 100; 
+	quasi_steady_interval = 6.0; 
+	quasi_steady_elapsed_time = 0.0; 
 
 	diffusion_decay_solver = empty_diffusion_solver;
 	diffusion_decay_solver = diffusion_decay_solver__constant_coefficients_LOD_3D; 
@@ -123,17 +136,12 @@ Microenvironment::Microenvironment()
 	one.resize( 1 , 1.0 ); 
 	zero.resize( 1 , 0.0 );
 	
-	temporary_density_vectors1.resize( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.resize( mesh.voxels.size() , zero ); 
-	p_density_vectors = &temporary_density_vectors1;
+	density_storage1.assign( mesh.voxels.size() , zero ); 
+	density_storage2.assign( mesh.voxels.size() , zero ); 
+	p_density_storage = &density_storage1;
 
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( 1 ); 
-		(gradient_vectors[k])[0].resize( 3, 0.0 );
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 
 	bulk_supply_rate_function = zero_function; 
 	bulk_supply_target_densities_function = zero_function; 
@@ -158,6 +166,7 @@ Microenvironment::Microenvironment()
 	dirichlet_node_map.assign( mesh.voxels.size() , -1 ); 
 */
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	dirichlet_activation_vector.assign( 1 , true ); 
 	
 	if(default_microenvironment==NULL)
@@ -183,6 +192,7 @@ void Microenvironment::add_dirichlet_node( int voxel_index, std::vector<double>&
 	*/
 	
 	dirichlet_value_vectors[voxel_index] = value; // .assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	
 	return; 
 }
@@ -213,6 +223,7 @@ void Microenvironment::update_dirichlet_node( int voxel_index , std::vector<doub
 	
 	mesh.voxels[voxel_index].is_Dirichlet = true; 
 	dirichlet_value_vectors[voxel_index] = new_value; 
+	dirichlet_indices_need_update = true; 
 	
 	return; 
 }
@@ -220,6 +231,7 @@ void Microenvironment::update_dirichlet_node( int voxel_index , std::vector<doub
 void Microenvironment::remove_dirichlet_node( int voxel_index )
 {
 	mesh.voxels[voxel_index].is_Dirichlet = false; 
+	dirichlet_indices_need_update = true; 
 	
 /*	
 	if( mesh.voxels[voxel_index].is_Dirichlet == false )
@@ -251,40 +263,90 @@ void Microenvironment::remove_dirichlet_node( int voxel_index )
 
 bool& Microenvironment::is_dirichlet_node( int voxel_index )
 {
+	// the caller may change the flag through the reference 
+	dirichlet_indices_need_update = true; 
 	return mesh.voxels[voxel_index].is_Dirichlet; 
 }
 
 void Microenvironment::set_substrate_dirichlet_activation( int substrate_index , bool new_value )
 {
 	dirichlet_activation_vector[substrate_index] = new_value; 
+	dirichlet_indices_need_update = true; 
 	return; 
 }
 
-void Microenvironment::apply_dirichlet_conditions( void )
+void Microenvironment::update_dirichlet_indices( void )
 {
-	/*
-	#pragma omp parallel for 
-	for( int i=0 ; i < dirichlet_indices.size() ; i++ )
-	{ density_vector( dirichlet_indices[i] ) = dirichlet_value_vectors[i]; }
-	*/
-
-	#pragma omp parallel for 
-	for( int i=0 ; i < mesh.voxels.size() ;i++ )
+	int number_of_substrates = number_of_densities(); 
+	
+	dirichlet_indices.clear(); 
+	dirichlet_values.clear(); 
+	for( int i=0 ; i < mesh.voxels.size() ; i++ )
 	{
-		/*
-		if( mesh.voxels[i].is_Dirichlet == true )
-		{ density_vector(i) = dirichlet_value_vectors[i]; }
-		*/
 		if( mesh.voxels[i].is_Dirichlet == true )
 		{
-			for( int j=0; j < dirichlet_value_vectors[i].size(); j++ )
-			{
-				if( dirichlet_activation_vector[j] == true )
-				{
-					density_vector(i)[j] = dirichlet_value_vectors[i][j]; 
-				}
-			}
+			dirichlet_indices.push_back( i ); 
+			for( int j=0; j < number_of_substrates ; j++ )
+			{ dirichlet_values.push_back( dirichlet_value_vectors[i][j] ); }
+		}
+	}
+	
+	dirichlet_substrates.clear(); 
+	for( int j=0; j < number_of_substrates ; j++ )
+	{
+		if( dirichlet_activation_vector[j] == true )
+		{ dirichlet_substrates.push_back( j ); }
+	}
+	
+	dirichlet_indices_need_update = false; 
+	return; 
+}
+
+void Microenvironment::resize_thomas_scratch( long size )
+{
+	thomas_scratch_length = size; 
+	thomas_scratch.assign( omp_get_max_threads() , aligned_vector( size , 0.0 ) ); 
+	return; 
+}
+
+void Microenvironment::prepare_thomas_scratch( void )
+{
+	// A parallel region without a num_threads clause has at most omp_get_max_threads() 
+	// threads (as seen by the thread that starts it, also when nested), so this covers 
+	// every thread of the solver's regions. The count can go up between solves. 
+	if( thomas_scratch_length > 0 && thomas_scratch.size() < omp_get_max_threads() )
+	{ thomas_scratch.resize( omp_get_max_threads() , aligned_vector( thomas_scratch_length , 0.0 ) ); }
+	return; 
+}
+
+double* Microenvironment::thomas_scratch_buffer( void )
+{
+	// no work space when the solves run in place (double-precision densities) 
+	if( thomas_scratch.size() == 0 )
+	{ return NULL; }
+	return thomas_scratch[ omp_get_thread_num() ].data(); 
+}
+
+void Microenvironment::apply_dirichlet_conditions( void )
+{
+	if( dirichlet_indices_need_update )
+	{ update_dirichlet_indices(); }
+	
+	density_type* pD = p_density_storage->pointer(); 
+	int vs = p_density_storage->voxel_stride(); 
+	int ss = p_density_storage->substrate_stride(); 
+	int number_of_substrates = number_of_densities(); 
+	int number_of_active_substrates = dirichlet_substrates.size(); 
 	
+	#pragma omp parallel for 
+	for( int n=0 ; n < dirichlet_indices.size() ; n++ )
+	{
+		density_type* pV = pD + (long) dirichlet_indices[n]*vs; 
+		const double* pValues = dirichlet_values.data() + n*number_of_substrates; 
+		for( int m=0; m < number_of_active_substrates ; m++ )
+		{
+			int j = dirichlet_substrates[m]; 
+			pV[ j*ss ] = pValues[j]; 
 		}
 	}
 	return; 
@@ -301,21 +363,14 @@ void Microenvironment::resize_voxels( int new_number_of_voxes )
 	
 	mesh.voxels.resize( new_number_of_voxes ); 
 	
-	temporary_density_vectors1.resize( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.resize( mesh.voxels.size() , zero ); 
+	density_storage1.assign( mesh.voxels.size() , zero ); 
+	density_storage2.assign( mesh.voxels.size() , zero ); 
 		
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	
 	return; 
 }
@@ -325,21 +380,14 @@ void Microenvironment::resize_space( int x_nodes, int y_nodes, int z_nodes )
 {
 	mesh.resize( x_nodes, y_nodes , z_nodes ); 
 
-	temporary_density_vectors1.assign( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.assign( mesh.voxels.size() , zero ); 
+	density_storage1.assign( mesh.voxels.size() , zero ); 
+	density_storage2.assign( mesh.voxels.size() , zero ); 
 		
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 
 	return;  
 }
@@ -348,21 +396,14 @@ void Microenvironment::resize_space( double x_start, double x_end, double y_star
 {
 	mesh.resize( x_start, x_end, y_start, y_end, z_start, z_end, x_nodes, y_nodes , z_nodes  ); 
 
-	temporary_density_vectors1.assign( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.assign( mesh.voxels.size() , zero ); 
+	density_storage1.assign( mesh.voxels.size() , zero ); 
+	density_storage2.assign( mesh.voxels.size() , zero ); 
 	
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	
 	return;  
 }
@@ -371,21 +412,14 @@ void Microenvironment::resize_space( double x_start, double x_end, double y_star
 {
 	mesh.resize( x_start, x_end, y_start, y_end, z_start, z_end,  dx_new , dy_new , dz_new ); 
 
-	temporary_density_vectors1.assign( mesh.voxels.size() , zero ); 
-	temporary_density_vectors2.assign( mesh.voxels.size() , zero ); 
+	density_storage1.assign( mesh.voxels.size() , zero ); 
+	density_storage2.assign( mesh.voxels.size() , zero ); 
 	
-	gradient_vectors.resize( mesh.voxels.size() ); 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	
 	return;  
 }
@@ -400,18 +434,11 @@ void Microenvironment::resize_densities( int new_size )
 	zero.assign( new_size, 0.0 ); 
 	one.assign( new_size , 1.0 );
 
-	temporary_density_vectors1.assign( mesh.voxels.size() , zero );
-	temporary_density_vectors2.assign( mesh.voxels.size() , zero );
+	density_storage1.assign( mesh.voxels.size() , zero );
+	density_storage2.assign( mesh.voxels.size() , zero );
 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 	
 	diffusion_coefficients.assign( new_size , 0.0 ); 
 	decay_rates.assign( new_size , 0.0 ); 
@@ -426,10 +453,14 @@ void Microenvironment::resize_densities( int new_size )
 	one_third /= 3.0; 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	dirichlet_activation_vector.assign( new_size, true ); 
 
 	default_microenvironment_options.Dirichlet_condition_vector = one; 
 	default_microenvironment_options.Dirichlet_activation_vector.assign( new_size, true ); 
+	default_microenvironment_options.gradient_activation_vector.assign( new_size, true ); 
+	default_microenvironment_options.diffusion_step_multiples.assign( new_size, 1 ); 
+	default_microenvironment_options.quasi_steady_activation_vector.assign( new_size, false ); 
 	
 	return; 
 }
@@ -451,23 +482,12 @@ void Microenvironment::add_density( void )
 	decay_rates.push_back( 0.0 ); 
 	
 	// update sources and such 
-	for( int i=0; i < temporary_density_vectors1.size() ; i++ )
-	{
-		temporary_density_vectors1[i].push_back( 0.0 ); 
-		temporary_density_vectors2[i].push_back( 0.0 ); 
-	}
+	density_storage1.add_density( 0.0 ); 
+	density_storage2.add_density( 0.0 ); 
 
 	// resize the gradient data structures 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 	
 	one_half = one; 
 	one_half *= 0.5; 
@@ -476,10 +496,14 @@ void Microenvironment::add_density( void )
 	one_third /= 3.0; 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	dirichlet_activation_vector.assign( number_of_densities(), true ); 
 	
 	default_microenvironment_options.Dirichlet_condition_vector = one; 
 	default_microenvironment_options.Dirichlet_activation_vector.assign( number_of_densities(), true ); 
+	default_microenvironment_options.gradient_activation_vector.assign( number_of_densities(), true ); 
+	default_microenvironment_options.diffusion_step_multiples.assign( number_of_densities(), 1 ); 
+	default_microenvironment_options.quasi_steady_activation_vector.assign( number_of_densities(), false ); 
 	
 	return; 
 }
@@ -501,22 +525,12 @@ void Microenvironment::add_density( std::string name , std::string units )
 	decay_rates.push_back( 0.0 ); 
 	
 	// update sources and such 
-	for( int i=0; i < temporary_density_vectors1.size() ; i++ )
-	{
-		temporary_density_vectors1[i].push_back( 0.0 ); 
-		temporary_density_vectors2[i].push_back( 0.0 ); 
-	}
+	density_storage1.add_density( 0.0 ); 
+	density_storage2.add_density( 0.0 ); 
 
 	// resize the gradient data structures, 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 
 	one_half = one; 
 	one_half *= 0.5; 
@@ -525,10 +539,14 @@ void Microenvironment::add_density( std::string name , std::string units )
 	one_third /= 3.0; 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	dirichlet_activation_vector.assign( number_of_densities(), true ); 
 	
 	default_microenvironment_options.Dirichlet_condition_vector = one; 
 	default_microenvironment_options.Dirichlet_activation_vector.assign( number_of_densities(), true ); 
+	default_microenvironment_options.gradient_activation_vector.assign( number_of_densities(), true ); 
+	default_microenvironment_options.diffusion_step_multiples.assign( number_of_densities(), 1 ); 
+	default_microenvironment_options.quasi_steady_activation_vector.assign( number_of_densities(), false ); 
 
 	return; 
 }
@@ -550,22 +568,12 @@ void Microenvironment::add_density( std::string name , std::string units, double
 	decay_rates.push_back( decay_rate ); 
 	
 	// update sources and such 
-	for( int i=0; i < temporary_density_vectors1.size() ; i++ )
-	{
-		temporary_density_vectors1[i].push_back( 0.0 ); 
-		temporary_density_vectors2[i].push_back( 0.0 ); 
-	}
+	density_storage1.add_density( 0.0 ); 
+	density_storage2.add_density( 0.0 ); 
 
 	// resize the gradient data structures 
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		gradient_vectors[k].resize( number_of_densities() ); 
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.resize( mesh.voxels.size() , false ); 	
+	gradient_computation_enabled.resize( number_of_densities() , true ); 
+	resize_gradient_storage(); 
 
 	one_half = one; 
 	one_half *= 0.5; 
@@ -574,10 +582,14 @@ void Microenvironment::add_density( std::string name , std::string units, double
 	one_third /= 3.0; 
 	
 	dirichlet_value_vectors.assign( mesh.voxels.size(), one ); 
+	dirichlet_indices_need_update = true; 
 	dirichlet_activation_vector.assign( number_of_densities(), true ); 
 	
 	default_microenvironment_options.Dirichlet_condition_vector = one; 
 	default_microenvironment_options.Dirichlet_activation_vector.assign( number_of_densities(), true ); 
+	default_microenvironment_options.gradient_activation_vector.assign( number_of_densities(), true ); 
+	default_microenvironment_options.diffusion_step_multiples.assign( number_of_densities(), 1 ); 
+	default_microenvironment_options.quasi_steady_activation_vector.assign( number_of_densities(), false ); 
 	
 	return; 
 }
@@ -622,6 +634,9 @@ std::vector<int> Microenvironment::cartesian_indices( int n )
 int Microenvironment::nearest_voxel_index( std::vector<double>& position )
 { return mesh.nearest_voxel_index( position ); }
 
+int Microenvironment::nearest_voxel_index( const Vec3& position )
+{ return mesh.nearest_voxel_index( position ); }
+
 Voxel& Microenvironment::voxels( int voxel_index )
 { return mesh.voxels[voxel_index]; }
 
@@ -631,34 +646,118 @@ std::vector<int> Microenvironment::nearest_cartesian_indices( std::vector<double
 Voxel& Microenvironment::nearest_voxel( std::vector<double>& position )
 { return mesh.nearest_voxel( position ); }
 
-std::vector<double>& Microenvironment::nearest_density_vector( std::vector<double>& position )
-{ return (*p_density_vectors)[ mesh.nearest_voxel_index( position ) ]; }
+Density_Vector Microenvironment::nearest_density_vector( std::vector<double>& position )
+{ return (*p_density_storage)( mesh.nearest_voxel_index( position ) ); }
+
+Density_Vector Microenvironment::nearest_density_vector( const Vec3& position )
+{ return (*p_density_storage)( mesh.nearest_voxel_index( position ) ); }
 
-std::vector<double>& Microenvironment::nearest_density_vector( int voxel_index )
-{ return (*p_density_vectors)[ voxel_index ]; }
+Density_Vector Microenvironment::nearest_density_vector( int voxel_index )
+{ return (*p_density_storage)( voxel_index ); }
 
-std::vector<double>& Microenvironment::operator()( int i, int j, int k )
-{ return (*p_density_vectors)[ voxel_index(i,j,k) ]; }
+Density_Vector Microenvironment::operator()( int i, int j, int k )
+{ return (*p_density_storage)( voxel_index(i,j,k) ); }
 
-std::vector<double>& Microenvironment::operator()( int i, int j )
-{ return (*p_density_vectors)[ voxel_index(i,j,0) ]; }
+Density_Vector Microenvironment::operator()( int i, int j )
+{ return (*p_density_storage)( voxel_index(i,j,0) ); }
 
-std::vector<double>& Microenvironment::operator()( int n )
-{ return (*p_density_vectors)[ n ]; }
+Density_Vector Microenvironment::operator()( int n )
+{ return (*p_density_storage)( n ); }
 
-std::vector<double>& Microenvironment::density_vector( int i, int j, int k )
-{ return (*p_density_vectors)[ voxel_index(i,j,k) ]; }
+Density_Vector Microenvironment::density_vector( int i, int j, int k )
+{ return (*p_density_storage)( voxel_index(i,j,k) ); }
 
-std::vector<double>& Microenvironment::density_vector( int i, int j )
-{ return (*p_density_vectors)[ voxel_index(i,j,0) ]; }
+Density_Vector Microenvironment::density_vector( int i, int j )
+{ return (*p_density_storage)( voxel_index(i,j,0) ); }
 
-std::vector<double>& Microenvironment::density_vector( int n )
-{ return (*p_density_vectors)[ n ]; }
+Density_Vector Microenvironment::density_vector( int n )
+{ return (*p_density_storage)( n ); }
+
+void Microenvironment::set_density_layout( int layout )
+{
+	density_storage1.set_layout( layout ); 
+	density_storage2.set_layout( layout ); 
+	// the lane coefficients of the batched Thomas sweeps depend upon the layout 
+	diffusion_solver_setup_done = false; 
+	return; 
+}
+
+int Microenvironment::get_density_layout( void )
+{ return p_density_storage->get_layout(); }
+
+void Microenvironment::set_vectorized_thomas_solver( bool use_vectorized_solver )
+{
+	if( use_vectorized_solver )
+	{ thomas_kernel = select_batched_thomas_kernel(); }
+	else
+	{ thomas_kernel = NULL; }
+	diffusion_solver_setup_done = false; 
+	return; 
+}
 
 void Microenvironment::simulate_diffusion_decay( double dt )
 {
 	if( diffusion_decay_solver )
-	{ diffusion_decay_solver( *this, dt ); }
+	{
+		// choose the substrates to advance in this step 
+		update_diffusion_schedule(); 
+		
+		// quasi-steady substrates: re-solve at the chosen cadence 
+		bool any_quasi_steady = false; 
+		for( int q=0; q < quasi_steady_substrates.size() ; q++ )
+		{ any_quasi_steady = any_quasi_steady || quasi_steady_substrates[q]; }
+		if( any_quasi_steady )
+		{
+			if( quasi_steady_elapsed_time + 0.5*dt >= quasi_steady_interval )
+			{
+				for( int q=0; q < quasi_steady_substrates.size() ; q++ )
+				{
+					if( quasi_steady_substrates[q] )
+					{ solve_steady_state( q ); }
+				}
+				quasi_steady_elapsed_time = 0.0; 
+			}
+			quasi_steady_elapsed_time += dt; 
+		}
+		
+		// substrates due for a steady-state test: keep their fields from before the step 
+		tested_substrates.clear(); 
+		if( steady_state_tolerance > 0.0 && diffusion_step_count % steady_state_check_interval == 0 )
+		{
+			tested_substrates = active_substrates; 
+			if( previous_fields.size() < tested_substrates.size() )
+			{ previous_fields.resize( tested_substrates.size() ); }
+			for( int m=0; m < tested_substrates.size() ; m++ )
+			{ copy_substrate_field( tested_substrates[m] , previous_fields[m] ); }
+		}
+		
+		if( active_substrates.size() > 0 )
+		{ diffusion_decay_solver( *this, dt ); }
+		else if( fused_cell_sources_and_sinks )
+		{ simulate_binned_cell_sources_and_sinks( dt ); }
+		
+		bool source_rates_updated = false; 
+		for( int m=0; m < tested_substrates.size() ; m++ )
+		{
+			int q = tested_substrates[m]; 
+			if( max_abs_change( q , previous_fields[m] ) < steady_state_tolerance )
+			{
+				substrate_frozen[q] = true; 
+				substrate_frozen_step[q] = diffusion_step_count; 
+				if( source_rates_updated == false )
+				{
+					update_total_cell_source_rates(); 
+					source_rates_updated = true; 
+				}
+				substrate_frozen_source_rates[q] = cell_source_rates[q]; 
+				substrate_frozen_source_rates[number_of_densities()+q] = cell_source_rates[number_of_densities()+q]; 
+			}
+		}
+		
+		diffusion_step_count++; 
+		// all gradients are now out of date 
+		gradient_epoch++; 
+	}
 	else
 	{
 		std::cout << "Warning: diffusion-reaction-source/sink solver not set for Microenvironment object at " << this << ". Nothing happened!" << std::endl; 
@@ -668,6 +767,283 @@ void Microenvironment::simulate_diffusion_decay( double dt )
 	return; 
 }
 
+void Microenvironment::set_substrate_step_multiple( int substrate_index , int multiple )
+{
+	if( multiple < 1 )
+	{
+		std::cout << "Warning: the step multiple of substrate " << substrate_index << " must be at least 1. Using 1." << std::endl; 
+		multiple = 1; 
+	}
+	substrate_step_multiples.resize( number_of_densities() , 1 ); 
+	if( substrate_step_multiples[substrate_index] == multiple )
+	{ return; }
+	
+	substrate_step_multiples[substrate_index] = multiple; 
+	// the solver coefficients depend on the substrate time steps 
+	diffusion_solver_setup_done = false; 
+	return; 
+}
+
+int Microenvironment::get_substrate_step_multiple( int substrate_index )
+{
+	if( substrate_index < substrate_step_multiples.size() )
+	{ return substrate_step_multiples[substrate_index]; }
+	return 1; 
+}
+
+void Microenvironment::set_steady_state_detection( double tolerance , double source_tolerance , int check_interval )
+{
+	steady_state_tolerance = tolerance; 
+	steady_state_source_tolerance = source_tolerance; 
+	steady_state_check_interval = check_interval; 
+	if( steady_state_check_interval < 1 )
+	{ steady_state_check_interval = 1; }
+	
+	// thaw everything 
+	substrate_frozen.assign( number_of_densities() , false ); 
+	return; 
+}
+
+bool Microenvironment::substrate_is_frozen( int substrate_index )
+{
+	if( substrate_index < substrate_frozen.size() )
+	{ return substrate_frozen[substrate_index]; }
+	return false; 
+}
+
+std::vector<double> Microenvironment::substrate_time_steps( double dt )
+{
+	std::vector<double> output( number_of_densities() , dt ); 
+	for( int q=0; q < number_of_densities() ; q++ )
+	{ output[q] *= get_substrate_step_multiple( q ); }
+	return output; 
+}
+
+void Microenvironment::update_diffusion_schedule( void )
+{
+	int number_of_substrates = number_of_densities(); 
+	if( substrate_step_multiples.size() != number_of_substrates )
+	{ substrate_step_multiples.resize( number_of_substrates , 1 ); }
+	if( substrate_frozen.size() != number_of_substrates )
+	{ substrate_frozen.resize( number_of_substrates , false ); }
+	substrate_frozen_step.resize( number_of_substrates , 0 ); 
+	substrate_frozen_source_rates.resize( 2*number_of_substrates , 0.0 ); 
+	
+	// thaw frozen substrates that are due for a re-test, or whose cell sources changed 
+	bool any_frozen = false; 
+	for( int q=0; q < number_of_substrates ; q++ )
+	{ any_frozen = any_frozen || substrate_frozen[q]; }
+	if( any_frozen )
+	{
+		update_total_cell_source_rates(); 
+		for( int q=0; q < number_of_substrates ; q++ )
+		{
+			if( substrate_frozen[q] == false )
+			{ continue; }
+			if( diffusion_step_count - substrate_frozen_step[q] >= steady_state_check_interval )
+			{ substrate_frozen[q] = false; }
+			for( int r=q; r < 2*number_of_substrates ; r += number_of_substrates )
+			{
+				double change = fabs( cell_source_rates[r] - substrate_frozen_source_rates[r] ); 
+				if( change > steady_state_source_tolerance * fabs( substrate_frozen_source_rates[r] ) )
+				{ substrate_frozen[q] = false; }
+			}
+		}
+	}
+	
+	quasi_steady_substrates.resize( number_of_substrates , false ); 
+	active_substrates.clear(); 
+	for( int q=0; q < number_of_substrates ; q++ )
+	{
+		if( substrate_frozen[q] == false && quasi_steady_substrates[q] == false && 
+			diffusion_step_count % substrate_step_multiples[q] == 0 )
+		{ active_substrates.push_back( q ); }
+	}
+	return; 
+}
+
+void Microenvironment::set_quasi_steady_substrate( int substrate_index , bool new_value )
+{
+	quasi_steady_substrates.resize( number_of_densities() , false ); 
+	if( quasi_steady_substrates[substrate_index] == new_value )
+	{ return; }
+	quasi_steady_substrates[substrate_index] = new_value; 
+	// solve at the next step 
+	quasi_steady_elapsed_time = quasi_steady_interval; 
+	return; 
+}
+
+bool Microenvironment::substrate_is_quasi_steady( int substrate_index )
+{
+	if( substrate_index < quasi_steady_substrates.size() )
+	{ return quasi_steady_substrates[substrate_index]; }
+	return false; 
+}
+
+void Microenvironment::set_quasi_steady_interval( double interval )
+{
+	quasi_steady_interval = interval; 
+	quasi_steady_elapsed_time = interval; 
+	return; 
+}
+
+void Microenvironment::solve_steady_state( int substrate_index )
+{
+	if( mesh.Cartesian_mesh == false )
+	{
+		std::cout << "Error: the steady-state solver is written for Cartesian meshes." << std::endl << std::endl; 
+		return; 
+	}
+	
+	int q = substrate_index; 
+	int number_of_substrates = number_of_densities(); 
+	
+	// decay, and the cells' secretion / uptake as rates per unit volume: 
+	//    -D*Laplacian(u) + ( lambda + sum (V/V_voxel)*(S+U) )*u = sum (V/V_voxel)*S*T 
+	std::vector<double> sigma( number_of_voxels() , decay_rates[q] ); 
+	std::vector<double> f( number_of_voxels() , 0.0 ); 
+	for( int i=0; i < all_basic_agents.size() ; i++ )
+	{
+		Basic_Agent* pAgent = all_basic_agents[i]; 
+		int n = pAgent->get_current_voxel_index(); 
+		if( pAgent->get_microenvironment() != this || n < 0 )
+		{ continue; }
+		double volume_fraction = pAgent->get_total_volume() / mesh.voxels[n].volume; 
+		double S = (*pAgent->secretion_rates)[q]; 
+		sigma[n] += volume_fraction * ( S + (*pAgent->uptake_rates)[q] ); 
+		f[n] += volume_fraction * S * (*pAgent->saturation_densities)[q]; 
+	}
+	
+	// Dirichlet nodes keep their values 
+	std::vector<double> u = substrate_field( q ); 
+	std::vector<char> fixed( number_of_voxels() , 0 ); 
+	if( dirichlet_indices_need_update )
+	{ update_dirichlet_indices(); }
+	if( dirichlet_activation_vector[q] )
+	{
+		for( int m=0; m < dirichlet_indices.size() ; m++ )
+		{
+			fixed[ dirichlet_indices[m] ] = 1; 
+			u[ dirichlet_indices[m] ] = dirichlet_values[ m*number_of_substrates + q ]; 
+		}
+	}
+	
+	steady_state_multigrid.setup( mesh.x_coordinates.size() , mesh.y_coordinates.size() , mesh.z_coordinates.size() , 
+		mesh.dx , mesh.dy , mesh.dz , diffusion_coefficients[q] , sigma , fixed ); 
+	steady_state_multigrid.solve( u , f ); 
+	if( steady_state_multigrid.converged == false )
+	{
+		std::cout << "Warning: the steady-state solve of substrate " << density_names[q] << " did not converge in " 
+			<< steady_state_multigrid.cycles << " V-cycles (last change " << steady_state_multigrid.last_change 
+			<< "). Using the last iterate." << std::endl; 
+	}
+	
+	for( int n=0; n < number_of_voxels() ; n++ )
+	{ p_density_storage->value( n , q ) = u[n]; }
+	gradient_epoch++; 
+	return; 
+}
+
+void Microenvironment::update_total_cell_source_rates( void )
+{
+	// [ sum of V*S*T | sum of V*(S+U) ] over all agents, one entry per substrate each 
+	int number_of_substrates = number_of_densities(); 
+	std::vector<double>& output = cell_source_rates; 
+	output.assign( 2*number_of_substrates , 0.0 ); 
+	for( int i=0; i < all_basic_agents.size() ; i++ )
+	{
+		Basic_Agent* pAgent = all_basic_agents[i]; 
+		if( pAgent->get_microenvironment() != this )
+		{ continue; }
+		double volume = pAgent->get_total_volume(); 
+		for( int q=0; q < number_of_substrates ; q++ )
+		{
+			double S = (*pAgent->secretion_rates)[q]; 
+			output[q] += volume * S * (*pAgent->saturation_densities)[q]; 
+			output[number_of_substrates+q] += volume * ( S + (*pAgent->uptake_rates)[q] ); 
+		}
+	}
+	return; 
+}
+
+std::vector<double> Microenvironment::substrate_field( int substrate_index )
+{
+	std::vector<double> output( number_of_voxels() ); 
+	for( int n=0; n < number_of_voxels() ; n++ )
+	{ output[n] = p_density_storage->value( n , substrate_index ); }
+	return output; 
+}
+
+void Microenvironment::copy_substrate_field( int substrate_index , std::vector<double>& output )
+{
+	output.resize( number_of_voxels() ); 
+	for( int n=0; n < number_of_voxels() ; n++ )
+	{ output[n] = p_density_storage->value( n , substrate_index ); }
+	return; 
+}
+
+double Microenvironment::max_abs_change( int substrate_index , const std::vector<double>& previous_field )
+{
+	double output = 0.0; 
+	for( int n=0; n < number_of_voxels() ; n++ )
+	{
+		double change = fabs( p_density_storage->value( n , substrate_index ) - previous_field[n] ); 
+		if( change > output )
+		{ output = change; }
+	}
+	return output; 
+}
+
+void Microenvironment::update_voxel_coefficient_fields( void )
+{
+	// the mesh changed: start over from the constant coefficients 
+	if( voxel_diffusion_coefficients.size() > 0 && voxel_diffusion_coefficients[0].size() != number_of_voxels() )
+	{
+		voxel_diffusion_coefficients.clear(); 
+		voxel_decay_rates.clear(); 
+		variable_lod_factorization_dt.assign( variable_lod_factorization_dt.size() , 0.0 ); 
+	}
+	
+	for( int q = voxel_diffusion_coefficients.size(); q < number_of_densities() ; q++ )
+	{
+		voxel_diffusion_coefficients.push_back( std::vector<double>( number_of_voxels() , diffusion_coefficients[q] ) ); 
+		voxel_decay_rates.push_back( std::vector<double>( number_of_voxels() , decay_rates[q] ) ); 
+	}
+	
+	variable_lod_lower.resize( number_of_densities() ); 
+	variable_lod_inverse_pivot.resize( number_of_densities() ); 
+	variable_lod_factorization_dt.resize( number_of_densities() , 0.0 ); 
+	return; 
+}
+
+void Microenvironment::set_voxel_diffusion_coefficient( int voxel_index , int substrate_index , double value )
+{
+	update_voxel_coefficient_fields(); 
+	voxel_diffusion_coefficients[substrate_index][voxel_index] = value; 
+	variable_lod_factorization_dt[substrate_index] = 0.0; 
+	return; 
+}
+
+void Microenvironment::set_voxel_decay_rate( int voxel_index , int substrate_index , double value )
+{
+	update_voxel_coefficient_fields(); 
+	voxel_decay_rates[substrate_index][voxel_index] = value; 
+	variable_lod_factorization_dt[substrate_index] = 0.0; 
+	return; 
+}
+
+double Microenvironment::get_voxel_diffusion_coefficient( int voxel_index , int substrate_index )
+{
+	update_voxel_coefficient_fields(); 
+	return voxel_diffusion_coefficients[substrate_index][voxel_index]; 
+}
+
+double Microenvironment::get_voxel_decay_rate( int voxel_index , int substrate_index )
+{
+	update_voxel_coefficient_fields(); 
+	return voxel_decay_rates[substrate_index][voxel_index]; 
+}
+
 void Microenvironment::auto_choose_diffusion_decay_solver( void )
 {
 	// set the safest choice 
@@ -702,7 +1078,7 @@ void Microenvironment::display_information( std::ostream& os )
 }
 	
 int Microenvironment::number_of_densities( void )
-{ return (*p_density_vectors)[0].size(); }
+{ return p_density_storage->number_of_densities(); }
 
 int Microenvironment::number_of_voxels( void )
 { return mesh.voxels.size(); }
@@ -713,7 +1089,7 @@ int Microenvironment::number_of_voxel_faces( void )
 void Microenvironment::write_to_matlab( std::string filename )
 {
 	int number_of_data_entries = mesh.voxels.size();
-	int size_of_each_datum = 3 + 1 + (*p_density_vectors)[0].size(); 
+	int size_of_each_datum = 3 + 1 + number_of_densities(); 
 
 	FILE* fp = write_matlab_header( size_of_each_datum, number_of_data_entries,  filename, "multiscale_microenvironment" );  
 
@@ -727,14 +1103,87 @@ void Microenvironment::write_to_matlab( std::string filename )
 
 		// densities  
 
-		for( int j=0 ; j < (*p_density_vectors)[i].size() ; j++)
-		{ fwrite( (char*) &( ((*p_density_vectors)[i])[j] ) , sizeof(double) , 1 , fp ); }
+		for( int j=0 ; j < number_of_densities() ; j++)
+		{
+			double value = p_density_storage->value(i,j); // .mat files are always double 
+			fwrite( (char*) &value , sizeof(double) , 1 , fp ); 
+		}
 	}
 
 	fclose( fp ); 
 	return;
 }
 
+void Microenvironment::write_snapshot( Snapshot_Buffer& buffer )
+{
+	int voxels = number_of_voxels(); 
+	int densities = number_of_densities(); 
+	int layout = p_density_storage->get_layout(); 
+	int precision = sizeof(density_type); 
+	buffer.write_value( voxels ); 
+	buffer.write_value( densities ); 
+	buffer.write_value( layout ); 
+	buffer.write_value( precision ); 
+	buffer.write( p_density_storage->pointer() , (size_t) voxels * densities * sizeof(density_type) ); 
+	
+	// multi-rate, steady-state, and quasi-steady schedules 
+	buffer.write_value( diffusion_step_count ); 
+	buffer.write_value( quasi_steady_elapsed_time ); 
+	std::vector<int> frozen( substrate_frozen.begin() , substrate_frozen.end() ); 
+	std::vector<unsigned long> frozen_step = substrate_frozen_step; 
+	std::vector<double> frozen_source_rates = substrate_frozen_source_rates; 
+	frozen.resize( densities , 0 ); 
+	frozen_step.resize( densities , 0 ); 
+	frozen_source_rates.resize( 2*densities , 0.0 ); 
+	buffer.write_vector( frozen ); 
+	buffer.write( frozen_step.data() , densities*sizeof(unsigned long) ); 
+	buffer.write_vector( frozen_source_rates ); 
+	return; 
+}
+
+bool Microenvironment::read_snapshot( Snapshot_Buffer& buffer )
+{
+	int voxels = 0; 
+	int densities = 0; 
+	int layout = 0; 
+	int precision = 0; 
+	buffer.read_value( voxels ); 
+	buffer.read_value( densities ); 
+	buffer.read_value( layout ); 
+	buffer.read_value( precision ); 
+	if( buffer.read_failed || voxels != number_of_voxels() || densities != number_of_densities() 
+		|| layout != p_density_storage->get_layout() || precision != sizeof(density_type) )
+	{
+		std::cout << "Error: the snapshot microenvironment (" << voxels << " voxels, " << densities 
+			<< " substrates) does not match " << name << " (" << number_of_voxels() << " voxels, " 
+			<< number_of_densities() << " substrates), or uses another density layout or precision" << std::endl; 
+		return false; 
+	}
+	buffer.read( p_density_storage->pointer() , (size_t) voxels * densities * sizeof(density_type) ); 
+	
+	std::vector<int> frozen; 
+	std::vector<unsigned long> frozen_step( densities , 0 ); 
+	std::vector<double> frozen_source_rates; 
+	buffer.read_value( diffusion_step_count ); 
+	buffer.read_value( quasi_steady_elapsed_time ); 
+	buffer.read_vector( frozen ); 
+	buffer.read( frozen_step.data() , densities*sizeof(unsigned long) ); 
+	buffer.read_vector( frozen_source_rates ); 
+	if( buffer.read_failed || frozen.size() != densities || frozen_source_rates.size() != 2*densities )
+	{
+		std::cout << "Error: truncated or malformed microenvironment snapshot" << std::endl; 
+		return false; 
+	}
+	substrate_frozen.assign( frozen.begin() , frozen.end() ); 
+	substrate_frozen_step = frozen_step; 
+	substrate_frozen_source_rates = frozen_source_rates; 
+	
+	// all gradients are now out of date 
+	gradient_epoch++; 
+	
+	return true; 
+}
+
 
 
 void Microenvironment::simulate_bulk_sources_and_sinks( double dt )
@@ -757,12 +1206,14 @@ void Microenvironment::simulate_bulk_sources_and_sinks( double dt )
 
 		
 		bulk_source_sink_solver_temp2[i] *= bulk_source_sink_solver_temp1[i]; // temp2 = S*T
-		axpy( &(*p_density_vectors)[i] , dt , bulk_source_sink_solver_temp2[i] ); // out = out + dt*temp2 = out + dt*S*T
+		bulk_source_sink_solver_temp2[i] *= dt; // temp2 = dt*S*T
 		bulk_source_sink_solver_temp3[i] += bulk_source_sink_solver_temp1[i]; // temp3 = U+S
 		bulk_source_sink_solver_temp3[i] *= dt; // temp3 = dt*(U+S)
 		bulk_source_sink_solver_temp3[i] += one; // temp3 = 1 + dt*(U+S)
 		
-		(*p_density_vectors)[i] /= bulk_source_sink_solver_temp3[i];
+		Density_Vector density = (*p_density_storage)(i); 
+		density += bulk_source_sink_solver_temp2[i]; // out = out + dt*S*T
+		density /= bulk_source_sink_solver_temp3[i];
 	}
 	
 	return; 
@@ -784,6 +1235,54 @@ void Microenvironment::simulate_cell_sources_and_sinks( double dt )
 	simulate_cell_sources_and_sinks(all_basic_agents, dt);
 }
 
+void Microenvironment::bin_cell_sources_and_sinks( void )
+{
+	// counting sort of the agents by x-line of voxels. This is stable, so the agents 
+	// in a voxel are applied in the same order as in all_basic_agents. 
+	int nx = mesh.x_coordinates.size(); 
+	int number_of_lines = mesh.voxels.size() / nx; 
+	
+	source_sink_line_start.assign( number_of_lines+1 , 0 ); 
+	for( int i=0; i < all_basic_agents.size() ; i++ )
+	{
+		Basic_Agent* pAgent = all_basic_agents[i]; 
+		int n = pAgent->get_current_voxel_index(); 
+		if( n >= 0 && pAgent->get_microenvironment() == this )
+		{ source_sink_line_start[ n/nx + 1 ]++; }
+	}
+	for( int L=0; L < number_of_lines ; L++ )
+	{ source_sink_line_start[L+1] += source_sink_line_start[L]; }
+	
+	source_sink_agents.resize( source_sink_line_start[number_of_lines] ); 
+	std::vector<int> next = source_sink_line_start; 
+	for( int i=0; i < all_basic_agents.size() ; i++ )
+	{
+		Basic_Agent* pAgent = all_basic_agents[i]; 
+		int n = pAgent->get_current_voxel_index(); 
+		if( n >= 0 && pAgent->get_microenvironment() == this )
+		{ source_sink_agents[ next[ n/nx ]++ ] = pAgent; }
+	}
+	return; 
+}
+
+void Microenvironment::apply_cell_sources_and_sinks( int line , double dt )
+{
+	for( int i=source_sink_line_start[line]; i < source_sink_line_start[line+1] ; i++ )
+	{ source_sink_agents[i]->simulate_secretion_and_uptake( this , dt ); }
+	return; 
+}
+
+void Microenvironment::simulate_binned_cell_sources_and_sinks( double dt )
+{
+	bin_cell_sources_and_sinks(); 
+	
+	int number_of_lines = source_sink_line_start.size()-1; 
+	#pragma omp parallel for 
+	for( int L=0; L < number_of_lines ; L++ )
+	{ apply_cell_sources_and_sinks( L , dt ); }
+	return; 
+}
+
 void Microenvironment::update_rates( void )
 {
 	if( supply_target_densities_times_supply_rates.size() != number_of_voxels() )
@@ -807,129 +1306,129 @@ void Microenvironment::update_rates( void )
 	return; 
 }
 
-std::vector<gradient>& Microenvironment::gradient_vector(int i, int j, int k)
+std::vector<gradient> Microenvironment::gradient_vector(int i, int j, int k)
+{ return gradient_vector( voxel_index(i,j,k) ); }
+
+std::vector<gradient> Microenvironment::gradient_vector(int i, int j )
+{ return gradient_vector( voxel_index(i,j,0) ); }
+
+std::vector<gradient> Microenvironment::gradient_vector(int n )
 {
-	int n = voxel_index(i,j,k);
-	if( gradient_vector_computed[n] == false )
+	// if the gradient has not yet been computed, then do it!
+	if( gradient_vector_is_current( n ) == false )
 	{
 		compute_gradient_vector( n );
 	}
 	
-	return gradient_vectors[n];
+	// substrates without gradient computations report zero gradients 
+	std::vector<gradient> output( number_of_densities() , zero_gradient ); 
+	for( int q=0; q < number_of_densities() ; q++ )
+	{
+		if( gradient_slots[q] < 0 )
+		{ continue; }
+		const density_type* pG = gradient_storage.data() + 3*( (long) gradient_slots[q]*mesh.voxels.size() + n ); 
+		output[q] = Vec3( pG[0] , pG[1] , pG[2] ); 
+	}
+	return output; 
 }
+	
+std::vector<gradient> Microenvironment::nearest_gradient_vector( std::vector<double>& position )
+{ return gradient_vector( nearest_voxel_index( position ) ); }
 
-std::vector<gradient>& Microenvironment::gradient_vector(int i, int j )
+std::vector<gradient> Microenvironment::nearest_gradient_vector( const Vec3& position )
+{ return gradient_vector( nearest_voxel_index( position ) ); }
+
+gradient Microenvironment::substrate_gradient( int n , int substrate_index )
 {
-	int n = voxel_index(i,j,0);
-	if( gradient_vector_computed[n] == false )
+	if( gradient_slots[substrate_index] < 0 )
+	{ return zero_gradient; }
+	
+	if( gradient_vector_is_current( n ) == false )
 	{
 		compute_gradient_vector( n );
 	}
 	
-	return gradient_vectors[n];
+	const density_type* pG = gradient_storage.data() + 3*( (long) gradient_slots[substrate_index]*mesh.voxels.size() + n ); 
+	return gradient( pG[0] , pG[1] , pG[2] ); 
 }
 
-std::vector<gradient>& Microenvironment::gradient_vector(int n )
+bool Microenvironment::gradient_vector_is_current( int n )
 {
-	// if the gradient has not yet been computed, then do it!
-	if( gradient_vector_computed[n] == false )
-	{
-		compute_gradient_vector( n );
-	}
-	
-	return gradient_vectors[n];
+	// gradients may be computed on demand from several threads at once 
+	unsigned int epoch; 
+	#pragma omp atomic read 
+	epoch = gradient_vector_computed[n]; 
+	return epoch == gradient_epoch; 
 }
-	
-std::vector<gradient>& Microenvironment::nearest_gradient_vector( std::vector<double>& position )
+
+void Microenvironment::set_gradient_computation( int substrate_index , bool new_value )
 {
-	int n = nearest_voxel_index( position );
-	if( gradient_vector_computed[n] == false )
-	{
-		compute_gradient_vector( n );
-	}
-	
-	return gradient_vectors[n];
+	if( gradient_computation_enabled[substrate_index] == new_value )
+	{ return; }
+	gradient_computation_enabled[substrate_index] = new_value; 
+	resize_gradient_storage(); 
+	return; 
 }
 
-void Microenvironment::compute_all_gradient_vectors( void )
+bool Microenvironment::get_gradient_computation( int substrate_index )
+{ return gradient_computation_enabled[substrate_index]; }
+
+void Microenvironment::resize_gradient_storage( void )
 {
-	// 
-	static double two_dx = mesh.dx; 
-	static double two_dy = mesh.dy; 
-	static double two_dz = mesh.dz; 
-	static bool gradient_constants_defined = false; 
-	if( gradient_constants_defined == false )
+	// one [voxel][3] block per substrate with gradient computations 
+	gradient_slots.assign( number_of_densities() , -1 ); 
+	int number_of_slots = 0; 
+	for( int q=0; q < number_of_densities() ; q++ )
 	{
-		two_dx *= 2.0; 
-		two_dy *= 2.0; 
-		two_dz *= 2.0;
-		gradient_constants_defined = true; 
+		if( gradient_computation_enabled[q] )
+		{ gradient_slots[q] = number_of_slots; number_of_slots++; }
 	}
 	
-	#pragma omp parallel for 
-	for( int k=0; k < mesh.z_coordinates.size() ; k++ )
-	{
-		for( int j=0; j < mesh.y_coordinates.size() ; j++ )
-		{
-			
-			for( int i=1; i < mesh.x_coordinates.size()-1 ; i++ )
-			{
-				for( int q=0; q < number_of_densities() ; q++ )
-				{
-					int n = voxel_index(i,j,k);
-					// x-derivative of qth substrate at voxel n
-					gradient_vectors[n][q][0] = (*p_density_vectors)[n+thomas_i_jump][q]; 
-					gradient_vectors[n][q][0] -= (*p_density_vectors)[n-thomas_i_jump][q]; 
-					gradient_vectors[n][q][0] /= two_dx; 
-					
-					gradient_vector_computed[n] = true; 
- 				}
-			}
-			
-		}
-	}
-	
-	#pragma omp parallel for 
-	for( int k=0; k < mesh.z_coordinates.size() ; k++ )
-	{
-		for( int i=0; i < mesh.x_coordinates.size() ; i++ )
-		{
-			
-			for( int j=1; j < mesh.y_coordinates.size()-1 ; j++ )
-			{
-				for( int q=0; q < number_of_densities() ; q++ )
-				{
-					int n = voxel_index(i,j,k);
-					// y-derivative of qth substrate at voxel n
-					gradient_vectors[n][q][1] = (*p_density_vectors)[n+thomas_j_jump][q]; 
-					gradient_vectors[n][q][1] -= (*p_density_vectors)[n-thomas_j_jump][q]; 
-					gradient_vectors[n][q][1] /= two_dy; 
-					gradient_vector_computed[n] = true; 
-				}
-			}
-			
-		}
-	}
+	gradient_storage.assign( 3 * (long) number_of_slots * mesh.voxels.size() , 0.0 ); 
+	gradient_vector_computed.assign( mesh.voxels.size() , 0 ); 
+	return; 
+}
 
-	#pragma omp parallel for 
-	for( int j=0; j < mesh.y_coordinates.size() ; j++ )
+void Microenvironment::compute_all_gradient_vectors( void )
+{
+	double two_dx = 2.0 * mesh.dx; 
+	double two_dy = 2.0 * mesh.dy; 
+	double two_dz = 2.0 * mesh.dz; 
+	
+	int nx = mesh.x_coordinates.size(); 
+	int ny = mesh.y_coordinates.size(); 
+	int nz = mesh.z_coordinates.size(); 
+	long number_of_voxels = mesh.voxels.size(); 
+	
+	long vs = p_density_storage->voxel_stride(); 
+	long ss = p_density_storage->substrate_stride(); 
+	
+	// one pass over the x-lines: each line contributes its x-derivatives, and 
+	// its y- and z-derivatives when the line is not on a y or z boundary. 
+	// Boundary components stay zero. 
+	#pragma omp parallel for collapse(2)
+	for( int k=0; k < nz ; k++ )
 	{
-		for( int i=0; i < mesh.x_coordinates.size() ; i++ )
+		for( int j=0; j < ny ; j++ )
 		{
-			
-			for( int k=1; k < mesh.z_coordinates.size()-1 ; k++ )
+			int n = voxel_index(0,j,k); 
+			for( int q=0; q < number_of_densities() ; q++ )
 			{
-				for( int q=0; q < number_of_densities() ; q++ )
-				{
-					int n = voxel_index(i,j,k);
-					// y-derivative of qth substrate at voxel n
-					gradient_vectors[n][q][2] = (*p_density_vectors)[n+thomas_k_jump][q]; 
-					gradient_vectors[n][q][2] -= (*p_density_vectors)[n-thomas_k_jump][q]; 
-					gradient_vectors[n][q][2] /= two_dz; 
-					gradient_vector_computed[n] = true; 
-				}
+				if( gradient_slots[q] < 0 )
+				{ continue; }
+				const density_type* pD = p_density_storage->pointer() + q*ss + n*vs; 
+				density_type* pG = gradient_storage.data() + 3*( gradient_slots[q]*number_of_voxels + n ); 
+				
+				if( nx > 2 )
+				{ central_differences( pD + vs , vs , vs , nx-2 , two_dx , pG + 3 ); }
+				if( j > 0 && j < ny-1 )
+				{ central_differences( pD , vs , nx*vs , nx , two_dy , pG + 1 ); }
+				if( k > 0 && k < nz-1 )
+				{ central_differences( pD , vs , nx*ny*vs , nx , two_dz , pG + 2 ); }
 			}
 			
+			for( int i=0; i < nx ; i++ )
+			{ gradient_vector_computed[n+i] = gradient_epoch; }
 		}
 	}
 
@@ -938,71 +1437,60 @@ void Microenvironment::compute_all_gradient_vectors( void )
 
 void Microenvironment::compute_gradient_vector( int n )
 {
-	static double two_dx = mesh.dx; 
-	static double two_dy = mesh.dy; 
-	static double two_dz = mesh.dz; 
-	static bool gradient_constants_defined = false; 
-	static std::vector<int> indices(3,0);
+	// no function-local statics: this may run on several threads at once 
+	double two_dx = 2.0 * mesh.dx; 
+	double two_dy = 2.0 * mesh.dy; 
+	double two_dz = 2.0 * mesh.dz; 
 	
-	if( gradient_constants_defined == false )
-	{
-		two_dx *= 2.0; 
-		two_dy *= 2.0; 
-		two_dz *= 2.0;
-		gradient_constants_defined = true; 
-	}	
+	int nx = mesh.x_coordinates.size(); 
+	int ny = mesh.y_coordinates.size(); 
+	int nz = mesh.z_coordinates.size(); 
+	long number_of_voxels = mesh.voxels.size(); 
 	
-	indices = cartesian_indices( n );
+	std::vector<int> indices = cartesian_indices( n );
 	
-	// d/dx 
-	if( indices[0] > 0 && indices[0] < mesh.x_coordinates.size()-1 )
+	for( int q=0; q < number_of_densities() ; q++ )
 	{
-		for( int q=0; q < number_of_densities() ; q++ )
+		if( gradient_slots[q] < 0 )
+		{ continue; }
+		density_type* pG = gradient_storage.data() + 3*( gradient_slots[q]*number_of_voxels + n ); 
+		
+		// d/dx 
+		if( indices[0] > 0 && indices[0] < nx-1 )
 		{
-			gradient_vectors[n][q][0] = (*p_density_vectors)[n+thomas_i_jump][q]; 
-			gradient_vectors[n][q][0] -= (*p_density_vectors)[n-thomas_i_jump][q]; 
-			gradient_vectors[n][q][0] /= two_dx; 
-			gradient_vector_computed[n] = true; 
+			pG[0] = p_density_storage->value(n+1,q); 
+			pG[0] -= p_density_storage->value(n-1,q); 
+			pG[0] /= two_dx; 
 		}
-	}
-	
-	// d/dy 
-	if( indices[1] > 0 && indices[1] < mesh.y_coordinates.size()-1 )
-	{
-		for( int q=0; q < number_of_densities() ; q++ )
+		
+		// d/dy 
+		if( indices[1] > 0 && indices[1] < ny-1 )
 		{
-			gradient_vectors[n][q][1] = (*p_density_vectors)[n+thomas_j_jump][q]; 
-			gradient_vectors[n][q][1] -= (*p_density_vectors)[n-thomas_j_jump][q]; 
-			gradient_vectors[n][q][1] /= two_dy; 
-			gradient_vector_computed[n] = true; 
+			pG[1] = p_density_storage->value(n+nx,q); 
+			pG[1] -= p_density_storage->value(n-nx,q); 
+			pG[1] /= two_dy; 
 		}
-	}
-	
-	// d/dz 
-	if( indices[2] > 0 && indices[2] < mesh.z_coordinates.size()-1 )
-	{
-		for( int q=0; q < number_of_densities() ; q++ )
+		
+		// d/dz 
+		if( indices[2] > 0 && indices[2] < nz-1 )
 		{
-			gradient_vectors[n][q][2] = (*p_density_vectors)[n+thomas_k_jump][q]; 
-			gradient_vectors[n][q][2] -= (*p_density_vectors)[n-thomas_k_jump][q]; 
-			gradient_vectors[n][q][2] /= two_dz; 
-			gradient_vector_computed[n] = true; 
+			pG[2] = p_density_storage->value(n+nx*ny,q); 
+			pG[2] -= p_density_storage->value(n-nx*ny,q); 
+			pG[2] /= two_dz; 
 		}
 	}
 	
+	// publish only after the values are written 
+	#pragma omp atomic write 
+	gradient_vector_computed[n] = gradient_epoch; 
+	
 	return; 
 }
 
 void Microenvironment::reset_all_gradient_vectors( void )
 {
-	for( int k=0 ; k < mesh.voxels.size() ; k++ )
-	{
-		for( int i=0 ; i < number_of_densities() ; i++ )
-		{
-			(gradient_vectors[k])[i].resize( 3, 0.0 );
-		}
-	}
-	gradient_vector_computed.assign( mesh.voxels.size() , false ); 	
+	std::fill( gradient_storage.begin() , gradient_storage.end() , 0.0 ); 
+	gradient_vector_computed.assign( mesh.voxels.size() , 0 ); 	
 }
 
 
@@ -1011,6 +1499,9 @@ Microenvironment microenvironment;
 Microenvironment_Options::Microenvironment_Options()
 {
 	use_oxygen_as_first_field = true; 
+	density_layout = density_layout_voxel_major; 
+	vectorized_thomas_solver = true; 
+	fused_cell_sources_and_sinks = false; 
 	
 	if( get_default_microenvironment() != NULL )
 	{
@@ -1032,6 +1523,9 @@ Microenvironment_Options::Microenvironment_Options()
 	outer_Dirichlet_conditions = false; 
 	Dirichlet_condition_vector.assign( pMicroenvironment->number_of_densities() , 0.0 ); 
 	Dirichlet_activation_vector.assign( pMicroenvironment->number_of_densities() , true ); 
+	gradient_activation_vector.assign( pMicroenvironment->number_of_densities() , true ); 
+	diffusion_step_multiples.assign( pMicroenvironment->number_of_densities() , 1 ); 
+	quasi_steady_activation_vector.assign( pMicroenvironment->number_of_densities() , false ); 
 	
 	// set a far-field value for oxygen (assumed to be in the first field)
 	Dirichlet_condition_vector[0] = 38.0; 
@@ -1048,6 +1542,13 @@ Microenvironment_Options::Microenvironment_Options()
 	Z_range[0] *= -1.0;
 	
 	calculate_gradients = false; 
+	calculate_gradients_on_demand = false; 
+	
+	steady_state_tolerance = 0.0; 
+	steady_state_source_tolerance = 0.01; 
+	steady_state_check_interval = 100; 
+	
+	quasi_steady_interval = 6.0; 
 	
 	return; 
 }
@@ -1063,6 +1564,9 @@ void initialize_microenvironment( void )
 	
 	// create and name a microenvironment; 
 	microenvironment.name = default_microenvironment_options.name;
+	microenvironment.set_density_layout( default_microenvironment_options.density_layout ); 
+	microenvironment.set_vectorized_thomas_solver( default_microenvironment_options.vectorized_thomas_solver ); 
+	microenvironment.fused_cell_sources_and_sinks = default_microenvironment_options.fused_cell_sources_and_sinks; 
 	// register the diffusion solver 
 	if( default_microenvironment_options.simulate_2D == true )
 	{
@@ -1136,6 +1640,38 @@ void initialize_microenvironment( void )
 		
 	}
 	
+	// only compute gradients for the substrates that need them 
+	for( int q=0; q < default_microenvironment_options.gradient_activation_vector.size() && q < microenvironment.number_of_densities() ; q++ )
+	{ microenvironment.set_gradient_computation( q , default_microenvironment_options.gradient_activation_vector[q] ); }
+	
+	// multi-rate diffusion and steady-state skipping 
+	for( int q=0; q < default_microenvironment_options.diffusion_step_multiples.size() && q < microenvironment.number_of_densities() ; q++ )
+	{ microenvironment.set_substrate_step_multiple( q , default_microenvironment_options.diffusion_step_multiples[q] ); }
+	microenvironment.set_steady_state_detection( default_microenvironment_options.steady_state_tolerance , 
+		default_microenvironment_options.steady_state_source_tolerance , default_microenvironment_options.steady_state_check_interval ); 
+	
+	// quasi-steady substrates 
+	microenvironment.set_quasi_steady_interval( default_microenvironment_options.quasi_steady_interval ); 
+	for( int q=0; q < default_microenvironment_options.quasi_steady_activation_vector.size() && q < microenvironment.number_of_densities() ; q++ )
+	{ microenvironment.set_quasi_steady_substrate( q , default_microenvironment_options.quasi_steady_activation_vector[q] ); }
+	
+	// The vectorized y- and z-sweeps can only skip substrates with the substrate-major 
+	// layout (the voxel-major lanes interleave all substrates), so switch to it whenever 
+	// some steps advance only part of the substrates. 
+	bool multi_rate = default_microenvironment_options.steady_state_tolerance > 0.0; 
+	for( int q=0; q < microenvironment.number_of_densities() ; q++ )
+	{
+		multi_rate = multi_rate || microenvironment.get_substrate_step_multiple( q ) > 1 
+			|| microenvironment.substrate_is_quasi_steady( q ); 
+	}
+	if( multi_rate && default_microenvironment_options.vectorized_thomas_solver && 
+		microenvironment.get_density_layout() == density_layout_voxel_major )
+	{
+		std::cout << "Note: using the substrate-major density layout, so that the vectorized y- and z-sweeps " << std::endl 
+			<< "      can skip the substrates that are not advanced in a step (multi-rate diffusion)." << std::endl << std::endl; 
+		microenvironment.set_density_layout( density_layout_substrate_major ); 
+	}
+	
 	microenvironment.display_information( std::cout );
 	return;
 }
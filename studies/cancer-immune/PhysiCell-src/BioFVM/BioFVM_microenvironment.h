@@ -52,11 +52,15 @@
 #include "BioFVM_mesh.h"
 #include "BioFVM_agent_container.h"
 #include "BioFVM_MultiCellDS.h"
+#include "BioFVM_density_storage.h"
+#include "BioFVM_simd.h"
+#include "BioFVM_multigrid.h"
+#include "BioFVM_utilities.h"
 
 namespace BioFVM{
 
 /* and now some gradients */ 
-typedef std::vector<double> gradient; 
+typedef Vec3 gradient; 
 
 /*! /brief   */
 
@@ -68,9 +72,9 @@ class Microenvironment
 	friend std::ostream& operator<<(std::ostream& os, const Microenvironment& S);  
 
 	/*! For internal use and accelerations in solvers */ 
-	std::vector< std::vector<double> > temporary_density_vectors1; 
+	Density_Storage density_storage1; 
 	/*! For internal use and accelerations in solvers */ 
-	std::vector< std::vector<double> > temporary_density_vectors2; 
+	Density_Storage density_storage2; 
 	
 	/*! for internal use in bulk source/sink solvers */
 	std::vector< std::vector<double> > bulk_source_sink_solver_temp1; 
@@ -80,10 +84,22 @@ class Microenvironment
 
 	
 	/*! stores pointer to current density solutions. Access via operator() functions. */ 
-	std::vector< std::vector<double> >* p_density_vectors; 
+	Density_Storage* p_density_storage; 
 	
-	std::vector< std::vector<gradient> > gradient_vectors; 
-	std::vector<bool> gradient_vector_computed; 
+	/*! gradients of the substrates with gradient computations, stored as 
+	    [slot][voxel][3] in one buffer. gradient_slots[q] is the slot of substrate q, 
+	    or -1 if its gradients are not computed. */ 
+	aligned_density_vector gradient_storage; 
+	std::vector<int> gradient_slots; 
+	void resize_gradient_storage( void ); 
+	gradient zero_gradient; 
+	/*! the gradients at voxel n are up to date if gradient_vector_computed[n] == gradient_epoch. 
+	    Each diffusion step advances the epoch, which marks all voxels dirty at once. */ 
+	std::vector<unsigned int> gradient_vector_computed; 
+	unsigned int gradient_epoch; 
+	bool gradient_vector_is_current( int n ); 
+	/*! substrates whose gradients are computed (all, by default) */ 
+	std::vector<bool> gradient_computation_enabled; 
 
 	
 	/*! helpful for solvers -- resize these whenever adding/removing substrates */ 
@@ -118,15 +134,101 @@ class Microenvironment
 	std::vector< std::vector<double> > thomas_cz;
 	bool diffusion_solver_setup_done; 
 	
+	/*! for the vectorized (batched) y- and z-sweeps of the LOD solvers: the lanes run 
+	    along one x-row of voxels, so the coefficients are expanded to one entry per lane */ 
+	batched_thomas_kernel thomas_kernel; 
+	aligned_vector thomas_lane_constant1; 
+	aligned_vector thomas_lane_denomy; 
+	aligned_vector thomas_lane_cy; 
+	/*! the z-sweep works on tiles of consecutive voxels of the first z-plane instead of x-rows */ 
+	aligned_vector thomas_tile_constant1; 
+	aligned_vector thomas_lane_denomz; 
+	aligned_vector thomas_lane_cz; 
+	/*! per-thread double-precision work space for the Thomas solves, used only when 
+	    densities are stored in single precision (otherwise the solves run in place) */ 
+	std::vector<aligned_vector> thomas_scratch; 
+	long thomas_scratch_length; 
+	/*! set the length of each thread's work space (at solver setup) */ 
+	void resize_thomas_scratch( long size ); 
+	/*! size the work spaces for the team of the next parallel regions, i.e., for 
+	    omp_get_max_threads() threads (call before each parallel solve, from the thread 
+	    that starts those regions) */ 
+	void prepare_thomas_scratch( void ); 
+	/*! the calling thread's work space (omp_get_thread_num() in a team prepared above) */ 
+	double* thomas_scratch_buffer( void ); 
+	
+	/*! for the general-mesh explicit solver: flux weights 1/|x_i-x_j|^2, in the order of 
+	    mesh.connected_voxel_indices, and the largest per-voxel sum of weights (for the CFL limit) */ 
+	std::vector< std::vector<double> > explicit_neighbor_weights; 
+	double explicit_max_weight_sum; 
+	
+	/*! for the variable-coefficient LOD solvers: per-voxel diffusion coefficients and decay 
+	    rates [substrate][voxel], and the cached Thomas factorizations of the lines of each 
+	    substrate [substrate][axis*number_of_voxels + voxel] (coupling to the previous voxel on 
+	    the line, and inverse pivot). A substrate's factorization is rebuilt only when its 
+	    fields or its time step change (variable_lod_factorization_dt[q] = 0 marks it stale). */ 
+	std::vector< std::vector<double> > voxel_diffusion_coefficients; 
+	std::vector< std::vector<double> > voxel_decay_rates; 
+	void update_voxel_coefficient_fields( void ); 
+	std::vector< std::vector<double> > variable_lod_lower; 
+	std::vector< std::vector<double> > variable_lod_inverse_pivot; 
+	std::vector<double> variable_lod_factorization_dt; 
+	
+	/*! quasi-steady substrates (see set_quasi_steady_substrate): solved for their steady state 
+	    every quasi_steady_interval of simulated time, and skipped by the diffusion solver */ 
+	std::vector<bool> quasi_steady_substrates; 
+	double quasi_steady_interval; 
+	double quasi_steady_elapsed_time; 
+	Steady_State_Multigrid steady_state_multigrid; 
+	
+	/*! multi-rate diffusion: active_substrates lists the substrates that the solver advances 
+	    in the current step. Substrate q is advanced once every substrate_step_multiples[q] steps, 
+	    by substrate_step_multiples[q]*dt (see substrate_time_steps). */ 
+	std::vector<int> substrate_step_multiples; 
+	std::vector<int> active_substrates; 
+	unsigned long diffusion_step_count; 
+	void update_diffusion_schedule( void ); 
+	std::vector<double> substrate_time_steps( double dt ); 
+	
+	/*! steady-state skipping (see set_steady_state_detection) */ 
+	double steady_state_tolerance; 
+	double steady_state_source_tolerance; 
+	int steady_state_check_interval; 
+	std::vector<bool> substrate_frozen; 
+	std::vector<unsigned long> substrate_frozen_step; 
+	std::vector<double> substrate_frozen_source_rates; 
+	// work space, kept between steps: the substrates due for a steady-state test in this step, 
+	// their fields before the step, and the current total cell source rates 
+	std::vector<int> tested_substrates; 
+	std::vector< std::vector<double> > previous_fields; 
+	std::vector<double> cell_source_rates; 
+	void update_total_cell_source_rates( void ); // [ sum of V*S*T | sum of V*(S+U) ] in cell_source_rates 
+	std::vector<double> substrate_field( int substrate_index ); 
+	void copy_substrate_field( int substrate_index , std::vector<double>& output ); 
+	double max_abs_change( int substrate_index , const std::vector<double>& previous_field ); 
+	
 	// on "resize density" type operations, need to extend all of these 
 	
-	/*
-	std::vector<int> dirichlet_indices; 
-	std::vector< std::vector<double> > dirichlet_value_vectors; 
-	std::vector<bool> dirichlet_node_map; 
-	*/
 	std::vector< std::vector<double> > dirichlet_value_vectors; 
 	std::vector<bool> dirichlet_activation_vector; 	
+	
+	/*! compact copy of the Dirichlet nodes used by apply_dirichlet_conditions(), so that only 
+	    the Dirichlet voxels (usually the boundary) are visited: voxel indices, their values 
+	    ([node][substrate]), and the substrates with active Dirichlet conditions. Rebuilt 
+	    from the per-voxel data whenever that data changes. */ 
+	std::vector<int> dirichlet_indices; 
+	std::vector<double> dirichlet_values; 
+	std::vector<int> dirichlet_substrates; 
+	bool dirichlet_indices_need_update; 
+	void update_dirichlet_indices( void ); 
+	
+	/*! for the fused cell source/sink pass: the agents, grouped by the x-line of voxels 
+	    they are in (line = voxel index / nx), with the agents of line L in 
+	    source_sink_agents[ source_sink_line_start[L] ... source_sink_line_start[L+1]-1 ] */ 
+	std::vector<Basic_Agent*> source_sink_agents; 
+	std::vector<int> source_sink_line_start; 
+	void bin_cell_sources_and_sinks( void ); 
+	void apply_cell_sources_and_sinks( int line , double dt ); 
 		
  public:
  
@@ -189,35 +291,89 @@ class Microenvironment
 	std::vector<int> cartesian_indices( int n ); 
 	
 	int nearest_voxel_index( std::vector<double>& position ); 
+	int nearest_voxel_index( const Vec3& position ); 
 	std::vector<int> nearest_cartesian_indices( std::vector<double>& position ); 
 	Voxel& nearest_voxel( std::vector<double>& position ); 
 	Voxel& voxels( int voxel_index );
-	std::vector<double>& nearest_density_vector( std::vector<double>& position );  
-	std::vector<double>& nearest_density_vector( int voxel_index );  
+	Density_Vector nearest_density_vector( std::vector<double>& position );  
+	Density_Vector nearest_density_vector( const Vec3& position );  
+	Density_Vector nearest_density_vector( int voxel_index );  
 
 	/*! access the density vector at  [ X(i),Y(j),Z(k) ] */
-	std::vector<double>& operator()( int i, int j, int k ); 
+	Density_Vector operator()( int i, int j, int k ); 
 	/*! access the density vector at  [ X(i),Y(j),0 ]  -- helpful for 2-D problems */
-	std::vector<double>& operator()( int i, int j );  
+	Density_Vector operator()( int i, int j );  
 	/*! access the density vector at [x,y,z](n) */
-	std::vector<double>& operator()( int n );  
+	Density_Vector operator()( int n );  
+	
+	/*! gradients of all substrates at a voxel (copied out of the gradient buffer). 
+	    Substrates without gradient computations report zero gradients. */ 
+	std::vector<gradient> gradient_vector(int i, int j, int k); 
+	std::vector<gradient> gradient_vector(int i, int j ); 
+	std::vector<gradient> gradient_vector(int n );  
 	
-	std::vector<gradient>& gradient_vector(int i, int j, int k); 
-	std::vector<gradient>& gradient_vector(int i, int j ); 
-	std::vector<gradient>& gradient_vector(int n );  
+	std::vector<gradient> nearest_gradient_vector( std::vector<double>& position ); 
+	std::vector<gradient> nearest_gradient_vector( const Vec3& position ); 
 	
-	std::vector<gradient>& nearest_gradient_vector( std::vector<double>& position ); 
+	/*! gradient of one substrate at voxel n */ 
+	gradient substrate_gradient( int n , int substrate_index ); 
 
 	void compute_all_gradient_vectors( void ); 
 	void compute_gradient_vector( int n );  
 	void reset_all_gradient_vectors( void ); 
 	
+	/*! turn gradient computations on or off for one substrate. Gradients are computed for 
+	    all voxels by compute_all_gradient_vectors(), or on demand (at first access after 
+	    each diffusion step) by gradient_vector() and Basic_Agent::nearest_gradient(). */ 
+	void set_gradient_computation( int substrate_index , bool new_value ); 
+	bool get_gradient_computation( int substrate_index ); 
+	
+	/*! multi-rate diffusion: advance this substrate once every multiple calls of 
+	    simulate_diffusion_decay(dt), by a step of multiple*dt. Cell sources and sinks 
+	    are still applied in every step. */ 
+	void set_substrate_step_multiple( int substrate_index , int multiple ); 
+	int get_substrate_step_multiple( int substrate_index ); 
+	
+	/*! steady-state skipping: every check_interval steps, substrates whose fields change by 
+	    less than tolerance (max abs change over all voxels) in one step are frozen. Neither 
+	    diffusion nor cell sources and sinks are applied to a frozen substrate until the total 
+	    cell secretion or uptake of that substrate changes by more than a relative 
+	    source_tolerance, or until it is re-tested check_interval steps later. A tolerance 
+	    of 0 (the default) turns this off. */ 
+	void set_steady_state_detection( double tolerance , double source_tolerance , int check_interval ); 
+	bool substrate_is_frozen( int substrate_index ); 
+	
+	/*! quasi-static substrates (e.g., oxygen): instead of time stepping, solve the steady state of 
+	    diffusion, decay, and cell secretion / uptake (with the current cells) every interval of 
+	    simulated time (the first time at the next step). Cells then leave these substrates to 
+	    the steady-state solve. Cartesian meshes only. */ 
+	void set_quasi_steady_substrate( int substrate_index , bool new_value ); 
+	bool substrate_is_quasi_steady( int substrate_index ); 
+	void set_quasi_steady_interval( double interval ); 
+	/*! solve for the steady state of one substrate now (geometric multigrid, see Steady_State_Multigrid) */ 
+	void solve_steady_state( int substrate_index ); 
+	
+	/*! spatially varying diffusion coefficients and decay rates, used by the variable-coefficient 
+	    solvers (e.g., faster decay in a necrotic core). Until a voxel's value is set, it is the 
+	    substrate's constant diffusion coefficient or decay rate (as of the first call). */ 
+	void set_voxel_diffusion_coefficient( int voxel_index , int substrate_index , double value ); 
+	void set_voxel_decay_rate( int voxel_index , int substrate_index , double value ); 
+	double get_voxel_diffusion_coefficient( int voxel_index , int substrate_index ); 
+	double get_voxel_decay_rate( int voxel_index , int substrate_index ); 
+	
 	/*! access the density vector at  [ X(i),Y(j),Z(k) ] */
-	std::vector<double>& density_vector( int i, int j, int k ); 
+	Density_Vector density_vector( int i, int j, int k ); 
 	/*! access the density vector at  [ X(i),Y(j),0 ]  -- helpful for 2-D problems */
-	std::vector<double>& density_vector( int i, int j ); 
+	Density_Vector density_vector( int i, int j ); 
 	/*! access the density vector at [x,y,z](n) */
-	std::vector<double>& density_vector( int n ); 
+	Density_Vector density_vector( int n ); 
+	
+	/*! choose density_layout_voxel_major or density_layout_substrate_major storage */
+	void set_density_layout( int layout ); 
+	int get_density_layout( void ); 
+	
+	/*! solve the y- and z-sweeps of the LOD solvers many lines at a time (SIMD), or one line at a time */
+	void set_vectorized_thomas_solver( bool use_vectorized_solver ); 
 
 	/*! advance the diffusion-decay solver by dt time */
 	void simulate_diffusion_decay( double dt ); 
@@ -230,6 +386,19 @@ class Microenvironment
 	// use the global list of cells 
 	void simulate_cell_sources_and_sinks( double dt ); 
 	
+	/*! When true, the diffusion solver applies the secretion and uptake of all agents (in 
+	    all_basic_agents) at the start of each step: agents are binned by x-line of voxels, 
+	    and each line's agents are applied in order by the task that solves that line in 
+	    the first LOD sweep, so agents sharing a voxel never write concurrently. PhysiCell's 
+	    Secretion::advance then leaves the secretion / uptake to the solver. 
+	    
+	    Off by default (set Microenvironment_Options::fused_cell_sources_and_sinks to opt in): 
+	    the secretion / uptake of a phenotype step is applied in the next diffusion step, with 
+	    the cell state after the update, which changes the results slightly. */ 
+	bool fused_cell_sources_and_sinks; 
+	// the same binned, race-free pass as a standalone step (for solvers without an x-sweep) 
+	void simulate_binned_cell_sources_and_sinks( double dt ); 
+	
 	void display_information( std::ostream& os ); 
 	
 	void add_dirichlet_node( int voxel_index, std::vector<double>& value ); 
@@ -246,6 +415,9 @@ class Microenvironment
 
 	friend void diffusion_decay_solver__constant_coefficients_LOD_3D( Microenvironment& S, double dt ); 
 	friend void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& S, double dt ); 
+
+	friend void diffusion_decay_solver__variable_coefficients_LOD_3D( Microenvironment& S, double dt ); 
+	friend void diffusion_decay_solver__variable_coefficients_LOD_2D( Microenvironment& S, double dt ); 
 	
 	friend void diffusion_decay_explicit_uniform_rates( Microenvironment& M, double dt );
 	
@@ -253,6 +425,12 @@ class Microenvironment
 	void write_mesh_to_matlab( std::string filename ); // not yet written 
 	void write_densities_to_matlab( std::string filename ); // not yet written 
 	
+	/*! save / restore the time-dependent state (densities and the diffusion schedule) in a 
+	    binary snapshot. The mesh, substrates, and solver options are not saved: restoring 
+	    requires a Microenvironment set up the same way, and fails (returns false) otherwise. */ 
+	void write_snapshot( Snapshot_Buffer& buffer ); 
+	bool read_snapshot( Snapshot_Buffer& buffer ); 
+	
 	void write_to_xml( std::string xml_filename , std::string data_filename ); // not yet written
 	void read_from_matlab( std::string filename ); // not yet written 
 	void read_from_xml( std::string filename ); // not yet written 
@@ -308,8 +486,27 @@ class Microenvironment_Options
 	Microenvironment_Options(); 
 	
 	bool calculate_gradients; 
+	// skip compute_all_gradient_vectors() after each step; gradients are computed where they are read 
+	bool calculate_gradients_on_demand; 
+	// gradient_activation_vector[q] == false skips all gradient computations (and storage) for substrate q 
+	std::vector<bool> gradient_activation_vector; 
+	
+	// multi-rate diffusion: substrate q is advanced every diffusion_step_multiples[q] diffusion steps 
+	std::vector<int> diffusion_step_multiples; 
+	// steady-state skipping (see Microenvironment::set_steady_state_detection); 0 is off 
+	double steady_state_tolerance; 
+	double steady_state_source_tolerance; 
+	int steady_state_check_interval; 
+	// quasi-steady substrates (see Microenvironment::set_quasi_steady_substrate), re-solved every quasi_steady_interval 
+	std::vector<bool> quasi_steady_activation_vector; 
+	double quasi_steady_interval; 
 	
 	bool use_oxygen_as_first_field;
+	
+	int density_layout; // voxel-major by default; substrate-major is used with multi-rate diffusion 
+	bool vectorized_thomas_solver; 
+	bool fused_cell_sources_and_sinks; // opt-in; changes the results (see Microenvironment) 
+
 };
 
 extern Microenvironment_Options default_microenvironment_options; 
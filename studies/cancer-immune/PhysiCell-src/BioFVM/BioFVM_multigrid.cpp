@@ -0,0 +1,374 @@
+/*
+#############################################################################
+# If you use BioFVM in your project, please cite BioFVM and the version     #
+# number, such as below:                                                    #
+#                                                                           #
+# We solved the diffusion equations using BioFVM (Version 1.1.7) [1]        #
+#                                                                           #
+# [1] A. Ghaffarizadeh, S.H. Friedman, and P. Macklin, BioFVM: an efficient #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the BioFVM Project              #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#include "BioFVM_multigrid.h"
+
+#include <cmath>
+
+namespace BioFVM{
+
+Steady_State_Multigrid::Steady_State_Multigrid()
+{
+	pre_smoothing_steps = 2; 
+	post_smoothing_steps = 2; 
+	coarsest_level_sweeps = 50; 
+	max_cycles = 50; 
+	tolerance = 1e-6; 
+	
+	cycles = 0; 
+	last_change = 0.0; 
+	converged = false; 
+	return; 
+}
+
+void Steady_State_Multigrid::setup( int nx , int ny , int nz , double dx , double dy , double dz , double D , 
+	const std::vector<double>& sigma , const std::vector<char>& fixed )
+{
+	int n [3] = { nx , ny , nz }; 
+	double h [3] = { dx , dy , dz }; 
+	
+	// sizes of the levels: merge pairs of voxels along each axis until the mesh is small 
+	int number_of_levels = 0; 
+	while( true )
+	{
+		if( number_of_levels >= levels.size() )
+		{ levels.push_back( Level() ); }
+		Level& L = levels[number_of_levels]; 
+		long N = (long) n[0]*n[1]*n[2]; 
+		for( int a=0; a < 3 ; a++ )
+		{
+			L.n[a] = n[a]; 
+			L.w[a] = D / ( h[a]*h[a] ); 
+		}
+		L.diagonal.resize( N ); 
+		L.u.resize( N ); 
+		L.f.resize( N ); 
+		L.r.resize( N ); 
+		L.fixed.resize( N ); 
+		number_of_levels++; 
+		
+		if( N <= 64 || ( n[0] <= 2 && n[1] <= 2 && n[2] <= 2 ) )
+		{ break; }
+		for( int a=0; a < 3 ; a++ )
+		{
+			if( n[a] > 1 )
+			{
+				n[a] = ( n[a] + 1 ) / 2; 
+				h[a] *= 2.0; 
+			}
+		}
+	}
+	levels.resize( number_of_levels ); 
+	
+	// finest level 
+	levels[0].fixed = fixed; 
+	compute_diagonal( levels[0] , sigma ); 
+	
+	// Coarse levels. A coarse voxel is fixed (zero correction) only if all of its voxels 
+	// are, so that voxels next to a Dirichlet boundary still get coarse-grid corrections. 
+	// The corrections are zero at the fixed fine voxels, so those act as sinks for the 
+	// other voxels of a partly fixed coarse voxel: sigma is averaged over the free voxels 
+	// (counting fixed ones as 0), plus each free voxel's coupling to fixed neighbours 
+	// that are not already in a fixed coarse voxel. 
+	std::vector<double> fine_sigma = sigma; 
+	std::vector<double> coarse_sigma; 
+	std::vector<int> count; 
+	std::vector<int> fixed_count; 
+	for( int l=1; l < number_of_levels ; l++ )
+	{
+		Level& F = levels[l-1]; 
+		Level& C = levels[l]; 
+		coarse_sigma.assign( C.u.size() , 0.0 ); 
+		count.assign( C.u.size() , 0 ); 
+		fixed_count.assign( C.u.size() , 0 ); 
+		for( int k=0; k < F.n[2] ; k++ )
+		{
+			for( int j=0; j < F.n[1] ; j++ )
+			{
+				for( int i=0; i < F.n[0] ; i++ )
+				{
+					long m = i + F.n[0]*( j + (long) F.n[1]*k ); 
+					long M = i/2 + C.n[0]*( j/2 + (long) C.n[1]*(k/2) ); 
+					count[M]++; 
+					if( F.fixed[m] )
+					{ fixed_count[M]++; }
+				}
+			}
+		}
+		for( long M=0; M < C.u.size() ; M++ )
+		{ C.fixed[M] = ( fixed_count[M] == count[M] ); }
+		
+		for( int k=0; k < F.n[2] ; k++ )
+		{
+			for( int j=0; j < F.n[1] ; j++ )
+			{
+				for( int i=0; i < F.n[0] ; i++ )
+				{
+					long m = i + F.n[0]*( j + (long) F.n[1]*k ); 
+					if( F.fixed[m] )
+					{ continue; }
+					long M = i/2 + C.n[0]*( j/2 + (long) C.n[1]*(k/2) ); 
+					coarse_sigma[M] += fine_sigma[m]; 
+					
+					for( int a=0; a < 3 ; a++ )
+					{
+						for( int side=-1; side <= 1 ; side += 2 )
+						{
+							int neighbor_index [3] = { i , j , k }; 
+							neighbor_index[a] += side; 
+							if( neighbor_index[a] < 0 || neighbor_index[a] >= F.n[a] )
+							{ continue; }
+							long neighbor = neighbor_index[0] + F.n[0]*( neighbor_index[1] + (long) F.n[1]*neighbor_index[2] ); 
+							long neighbor_M = neighbor_index[0]/2 + C.n[0]*( neighbor_index[1]/2 + (long) C.n[1]*(neighbor_index[2]/2) ); 
+							if( F.fixed[neighbor] && !C.fixed[neighbor_M] )
+							{ coarse_sigma[M] += F.w[a]; }
+						}
+					}
+				}
+			}
+		}
+		for( long M=0; M < C.u.size() ; M++ )
+		{ coarse_sigma[M] /= (double) count[M]; }
+		compute_diagonal( C , coarse_sigma ); 
+		fine_sigma.swap( coarse_sigma ); 
+	}
+	return; 
+}
+
+void Steady_State_Multigrid::compute_diagonal( Level& L , const std::vector<double>& sigma )
+{
+	int nx = L.n[0]; 
+	int ny = L.n[1]; 
+	int nz = L.n[2]; 
+	for( int k=0; k < nz ; k++ )
+	{
+		for( int j=0; j < ny ; j++ )
+		{
+			for( int i=0; i < nx ; i++ )
+			{
+				long n = i + nx*( j + (long) ny*k ); 
+				// zero flux across the domain boundary: only existing neighbours couple 
+				int neighbors [3] = { ( i > 0 ) + ( i < nx-1 ) , ( j > 0 ) + ( j < ny-1 ) , ( k > 0 ) + ( k < nz-1 ) }; 
+				L.diagonal[n] = sigma[n] + L.w[0]*neighbors[0] + L.w[1]*neighbors[1] + L.w[2]*neighbors[2]; 
+			}
+		}
+	}
+	return; 
+}
+
+void Steady_State_Multigrid::smooth( Level& L , int sweeps )
+{
+	int nx = L.n[0]; 
+	int ny = L.n[1]; 
+	int nz = L.n[2]; 
+	long jump_y = nx; 
+	long jump_z = (long) nx*ny; 
+	double* u = L.u.data(); 
+	
+	for( int s=0; s < sweeps ; s++ )
+	{
+		// red-black ordering: all voxels of one colour can be updated in parallel 
+		for( int colour=0; colour < 2 ; colour++ )
+		{
+			#pragma omp parallel for collapse(2) 
+			for( int k=0; k < nz ; k++ )
+			{
+				for( int j=0; j < ny ; j++ )
+				{
+					for( int i=( colour + j + k ) % 2 ; i < nx ; i += 2 )
+					{
+						long n = i + nx*( j + (long) ny*k ); 
+						if( L.fixed[n] || L.diagonal[n] <= 0.0 )
+						{ continue; }
+						double sum = L.f[n]; 
+						if( i > 0 ) { sum += L.w[0]*u[n-1]; }
+						if( i < nx-1 ) { sum += L.w[0]*u[n+1]; }
+						if( j > 0 ) { sum += L.w[1]*u[n-jump_y]; }
+						if( j < ny-1 ) { sum += L.w[1]*u[n+jump_y]; }
+						if( k > 0 ) { sum += L.w[2]*u[n-jump_z]; }
+						if( k < nz-1 ) { sum += L.w[2]*u[n+jump_z]; }
+						u[n] = sum / L.diagonal[n]; 
+					}
+				}
+			}
+		}
+	}
+	return; 
+}
+
+double Steady_State_Multigrid::compute_residual( Level& L )
+{
+	int nx = L.n[0]; 
+	int ny = L.n[1]; 
+	int nz = L.n[2]; 
+	long jump_y = nx; 
+	long jump_z = (long) nx*ny; 
+	const double* u = L.u.data(); 
+	double max_residual = 0.0; 
+	
+	#pragma omp parallel for collapse(2) reduction(max:max_residual) 
+	for( int k=0; k < nz ; k++ )
+	{
+		for( int j=0; j < ny ; j++ )
+		{
+			for( int i=0; i < nx ; i++ )
+			{
+				long n = i + nx*( j + (long) ny*k ); 
+				if( L.fixed[n] )
+				{ L.r[n] = 0.0; continue; }
+				double sum = L.f[n] - L.diagonal[n]*u[n]; 
+				if( i > 0 ) { sum += L.w[0]*u[n-1]; }
+				if( i < nx-1 ) { sum += L.w[0]*u[n+1]; }
+				if( j > 0 ) { sum += L.w[1]*u[n-jump_y]; }
+				if( j < ny-1 ) { sum += L.w[1]*u[n+jump_y]; }
+				if( k > 0 ) { sum += L.w[2]*u[n-jump_z]; }
+				if( k < nz-1 ) { sum += L.w[2]*u[n+jump_z]; }
+				L.r[n] = sum; 
+				if( fabs( sum ) > max_residual )
+				{ max_residual = fabs( sum ); }
+			}
+		}
+	}
+	return max_residual; 
+}
+
+void Steady_State_Multigrid::restrict_residual( Level& F , Level& C )
+{
+	// the equations are per unit volume, so the coarse right-hand side is the average 
+	C.f.assign( C.f.size() , 0.0 ); 
+	std::vector<int> count( C.f.size() , 0 ); 
+	for( int k=0; k < F.n[2] ; k++ )
+	{
+		for( int j=0; j < F.n[1] ; j++ )
+		{
+			for( int i=0; i < F.n[0] ; i++ )
+			{
+				long m = i + F.n[0]*( j + (long) F.n[1]*k ); 
+				long M = i/2 + C.n[0]*( j/2 + (long) C.n[1]*(k/2) ); 
+				C.f[M] += F.r[m]; 
+				count[M]++; 
+			}
+		}
+	}
+	for( long M=0; M < C.f.size() ; M++ )
+	{ C.f[M] /= (double) count[M]; }
+	C.u.assign( C.u.size() , 0.0 ); 
+	return; 
+}
+
+void Steady_State_Multigrid::prolong_correction( Level& C , Level& F )
+{
+	#pragma omp parallel for collapse(2) 
+	for( int k=0; k < F.n[2] ; k++ )
+	{
+		for( int j=0; j < F.n[1] ; j++ )
+		{
+			for( int i=0; i < F.n[0] ; i++ )
+			{
+				long m = i + F.n[0]*( j + (long) F.n[1]*k ); 
+				if( F.fixed[m] )
+				{ continue; }
+				F.u[m] += C.u[ i/2 + C.n[0]*( j/2 + (long) C.n[1]*(k/2) ) ]; 
+			}
+		}
+	}
+	return; 
+}
+
+void Steady_State_Multigrid::v_cycle( int level )
+{
+	Level& L = levels[level]; 
+	if( level == levels.size()-1 )
+	{
+		smooth( L , coarsest_level_sweeps ); 
+		return; 
+	}
+	
+	smooth( L , pre_smoothing_steps ); 
+	compute_residual( L ); 
+	restrict_residual( L , levels[level+1] ); 
+	v_cycle( level+1 ); 
+	prolong_correction( levels[level+1] , L ); 
+	smooth( L , post_smoothing_steps ); 
+	return; 
+}
+
+int Steady_State_Multigrid::solve( std::vector<double>& u , const std::vector<double>& f )
+{
+	Level& L = levels[0]; 
+	L.u = u; 
+	L.f = f; 
+	std::vector<double> previous; 
+	
+	converged = false; 
+	for( cycles=1; cycles <= max_cycles ; cycles++ )
+	{
+		previous = L.u; 
+		v_cycle( 0 ); 
+		
+		double change = 0.0; 
+		double scale = 0.0; 
+		for( long n=0; n < L.u.size() ; n++ )
+		{
+			if( fabs( L.u[n] - previous[n] ) > change )
+			{ change = fabs( L.u[n] - previous[n] ); }
+			if( fabs( L.u[n] ) > scale )
+			{ scale = fabs( L.u[n] ); }
+		}
+		last_change = change; 
+		if( change <= tolerance * scale )
+		{ converged = true; break; }
+	}
+	if( cycles > max_cycles )
+	{ cycles = max_cycles; }
+	
+	u = L.u; 
+	return cycles; 
+}
+
+};
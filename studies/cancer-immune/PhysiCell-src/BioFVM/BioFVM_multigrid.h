@@ -0,0 +1,115 @@
+/*
+#############################################################################
+# If you use BioFVM in your project, please cite BioFVM and the version     #
+# number, such as below:                                                    #
+#                                                                           #
+# We solved the diffusion equations using BioFVM (Version 1.1.7) [1]        #
+#                                                                           #
+# [1] A. Ghaffarizadeh, S.H. Friedman, and P. Macklin, BioFVM: an efficient #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the BioFVM Project              #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#ifndef __BioFVM_multigrid_h__
+#define __BioFVM_multigrid_h__
+
+#include <vector>
+
+namespace BioFVM{
+
+/* Geometric multigrid for the steady diffusion-reaction problem on a Cartesian mesh 
+   
+     -D*Laplacian(u) + sigma(x)*u = f(x) 
+   
+   (cell-centred finite volumes, zero-flux domain boundaries, fixed values at "fixed" 
+   voxels such as Dirichlet nodes). Each coarse level merges up to 2 voxels per axis; 
+   smoothing is red-black Gauss-Seidel, residuals are restricted by averaging, and 
+   corrections are prolonged piecewise constant. solve() runs V-cycles from the given 
+   initial guess until the largest change in one cycle drops below tolerance*max|u|. */ 
+
+class Steady_State_Multigrid
+{
+ private:
+	struct Level
+	{
+		int n [3]; 
+		double w [3]; // D/h^2 along each axis 
+		std::vector<double> diagonal; // sigma + sum of the couplings to the neighbours 
+		std::vector<double> u; 
+		std::vector<double> f; 
+		std::vector<double> r; 
+		std::vector<char> fixed; 
+	}; 
+	std::vector<Level> levels; 
+	
+	void compute_diagonal( Level& L , const std::vector<double>& sigma ); 
+	void smooth( Level& L , int sweeps ); 
+	double compute_residual( Level& L ); 
+	void restrict_residual( Level& fine , Level& coarse ); 
+	void prolong_correction( Level& coarse , Level& fine ); 
+	void v_cycle( int level ); 
+	
+ public:
+	int pre_smoothing_steps; 
+	int post_smoothing_steps; 
+	int coarsest_level_sweeps; 
+	int max_cycles; 
+	double tolerance; 
+	
+	// statistics of the last solve 
+	int cycles; 
+	double last_change; 
+	bool converged; 
+	
+	Steady_State_Multigrid(); 
+	
+	/* build the levels for an nx x ny x nz mesh (voxel n = i + nx*(j + ny*k)), with spacings 
+	   dx, dy, dz, diffusion coefficient D, and per-voxel sigma (>= 0) and fixed flags. 
+	   The allocations are kept between calls. */ 
+	void setup( int nx , int ny , int nz , double dx , double dy , double dz , double D , 
+		const std::vector<double>& sigma , const std::vector<char>& fixed ); 
+	
+	/* solve in place: u holds the initial guess (and the values at the fixed voxels). 
+	   Returns the number of V-cycles; converged is false if max_cycles ran out first. */ 
+	int solve( std::vector<double>& u , const std::vector<double>& f ); 
+};
+
+};
+
+#endif
@@ -0,0 +1,265 @@
+/*
+#############################################################################
+# If you use BioFVM in your project, please cite BioFVM and the version     #
+# number, such as below:                                                    #
+#                                                                           #
+# We solved the diffusion equations using BioFVM (Version 1.1.7) [1]        #
+#                                                                           #
+# [1] A. Ghaffarizadeh, S.H. Friedman, and P. Macklin, BioFVM: an efficient #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the BioFVM Project              #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#include "BioFVM_simd.h"
+
+#ifdef BIOFVM_X86_SIMD
+#include <immintrin.h>
+#endif 
+
+namespace BioFVM{
+
+bool cpu_supports_avx2( void )
+{
+#ifdef BIOFVM_X86_SIMD
+	__builtin_cpu_init(); 
+	return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ); 
+#else
+	return false; 
+#endif 
+}
+
+bool cpu_supports_avx512( void )
+{
+#ifdef BIOFVM_X86_SIMD
+	__builtin_cpu_init(); 
+	return __builtin_cpu_supports( "avx512f" ); 
+#else
+	return false; 
+#endif 
+}
+
+// generic version: sweep all lanes at each position. The lane loops are 
+// contiguous, so the compiler vectorizes them for the build target. 
+void batched_thomas_generic( double* x , long step , int width , int length , 
+	const double* c1 , const double* denom , const double* c , int table_stride )
+{
+	for( int l=0; l < width ; l++ )
+	{ x[l] /= denom[l]; }
+	
+	for( int p=1; p < length ; p++ )
+	{
+		double* row = x + p*step; 
+		const double* previous = row - step; 
+		const double* d = denom + p*table_stride; 
+		for( int l=0; l < width ; l++ )
+		{
+			row[l] += c1[l] * previous[l]; 
+			row[l] /= d[l]; 
+		}
+	}
+	
+	for( int p=length-2; p >= 0 ; p-- )
+	{
+		double* row = x + p*step; 
+		const double* next = row + step; 
+		const double* cc = c + p*table_stride; 
+		for( int l=0; l < width ; l++ )
+		{ row[l] -= cc[l] * next[l]; }
+	}
+	return; 
+}
+
+#ifdef BIOFVM_X86_SIMD
+
+// AVX2: 8 lanes (two registers) per block; the previous / next row stays in 
+// registers for the whole line, so each entry is loaded and stored once per sweep. 
+__attribute__((target("avx2,fma")))
+void batched_thomas_avx2( double* x , long step , int width , int length , 
+	const double* c1 , const double* denom , const double* c , int table_stride )
+{
+	int l = 0; 
+	for( ; l+8 <= width ; l += 8 )
+	{
+		double* base = x + l; 
+		__m256d a0 = _mm256_loadu_pd( c1+l ); 
+		__m256d a1 = _mm256_loadu_pd( c1+l+4 ); 
+		
+		__m256d x0 = _mm256_div_pd( _mm256_loadu_pd( base ) , _mm256_loadu_pd( denom+l ) ); 
+		__m256d x1 = _mm256_div_pd( _mm256_loadu_pd( base+4 ) , _mm256_loadu_pd( denom+l+4 ) ); 
+		_mm256_storeu_pd( base , x0 ); 
+		_mm256_storeu_pd( base+4 , x1 ); 
+		
+		for( int p=1; p < length ; p++ )
+		{
+			double* row = base + p*step; 
+			const double* d = denom + p*table_stride + l; 
+			x0 = _mm256_fmadd_pd( a0 , x0 , _mm256_loadu_pd( row ) ); 
+			x1 = _mm256_fmadd_pd( a1 , x1 , _mm256_loadu_pd( row+4 ) ); 
+			x0 = _mm256_div_pd( x0 , _mm256_loadu_pd( d ) ); 
+			x1 = _mm256_div_pd( x1 , _mm256_loadu_pd( d+4 ) ); 
+			_mm256_storeu_pd( row , x0 ); 
+			_mm256_storeu_pd( row+4 , x1 ); 
+		}
+		
+		for( int p=length-2; p >= 0 ; p-- )
+		{
+			double* row = base + p*step; 
+			const double* cc = c + p*table_stride + l; 
+			x0 = _mm256_fnmadd_pd( _mm256_loadu_pd( cc ) , x0 , _mm256_loadu_pd( row ) ); 
+			x1 = _mm256_fnmadd_pd( _mm256_loadu_pd( cc+4 ) , x1 , _mm256_loadu_pd( row+4 ) ); 
+			_mm256_storeu_pd( row , x0 ); 
+			_mm256_storeu_pd( row+4 , x1 ); 
+		}
+	}
+	
+	// remaining lanes 
+	if( l < width )
+	{ batched_thomas_generic( x+l , step , width-l , length , c1+l , denom+l , c+l , table_stride ); }
+	return; 
+}
+
+// AVX-512: 16 lanes (two registers) per block 
+__attribute__((target("avx512f")))
+void batched_thomas_avx512( double* x , long step , int width , int length , 
+	const double* c1 , const double* denom , const double* c , int table_stride )
+{
+	int l = 0; 
+	for( ; l+16 <= width ; l += 16 )
+	{
+		double* base = x + l; 
+		__m512d a0 = _mm512_loadu_pd( c1+l ); 
+		__m512d a1 = _mm512_loadu_pd( c1+l+8 ); 
+		
+		__m512d x0 = _mm512_div_pd( _mm512_loadu_pd( base ) , _mm512_loadu_pd( denom+l ) ); 
+		__m512d x1 = _mm512_div_pd( _mm512_loadu_pd( base+8 ) , _mm512_loadu_pd( denom+l+8 ) ); 
+		_mm512_storeu_pd( base , x0 ); 
+		_mm512_storeu_pd( base+8 , x1 ); 
+		
+		for( int p=1; p < length ; p++ )
+		{
+			double* row = base + p*step; 
+			const double* d = denom + p*table_stride + l; 
+			x0 = _mm512_fmadd_pd( a0 , x0 , _mm512_loadu_pd( row ) ); 
+			x1 = _mm512_fmadd_pd( a1 , x1 , _mm512_loadu_pd( row+8 ) ); 
+			x0 = _mm512_div_pd( x0 , _mm512_loadu_pd( d ) ); 
+			x1 = _mm512_div_pd( x1 , _mm512_loadu_pd( d+8 ) ); 
+			_mm512_storeu_pd( row , x0 ); 
+			_mm512_storeu_pd( row+8 , x1 ); 
+		}
+		
+		for( int p=length-2; p >= 0 ; p-- )
+		{
+			double* row = base + p*step; 
+			const double* cc = c + p*table_stride + l; 
+			x0 = _mm512_fnmadd_pd( _mm512_loadu_pd( cc ) , x0 , _mm512_loadu_pd( row ) ); 
+			x1 = _mm512_fnmadd_pd( _mm512_loadu_pd( cc+8 ) , x1 , _mm512_loadu_pd( row+8 ) ); 
+			_mm512_storeu_pd( row , x0 ); 
+			_mm512_storeu_pd( row+8 , x1 ); 
+		}
+	}
+	
+	// remaining lanes 
+	if( l < width )
+	{ batched_thomas_avx2( x+l , step , width-l , length , c1+l , denom+l , c+l , table_stride ); }
+	return; 
+}
+
+#endif 
+
+batched_thomas_kernel select_batched_thomas_kernel( void )
+{
+#ifdef BIOFVM_X86_SIMD
+	if( cpu_supports_avx512() )
+	{ return batched_thomas_avx512; }
+	if( cpu_supports_avx2() )
+	{ return batched_thomas_avx2; }
+#endif 
+	return batched_thomas_generic; 
+}
+
+std::string batched_thomas_kernel_name( void )
+{
+#ifdef BIOFVM_X86_SIMD
+	if( cpu_supports_avx512() )
+	{ return "AVX-512"; }
+	if( cpu_supports_avx2() )
+	{ return "AVX2"; }
+#endif 
+	return "generic"; 
+}
+
+void central_differences( const density_type* in , long stride , long jump , int length , 
+	double two_h , density_type* out )
+{
+	// same operations (and rounding) as the scalar form, vectorized across voxels 
+	#pragma omp simd 
+	for( int i=0; i < length ; i++ )
+	{ out[3*i] = ( in[i*stride+jump] - in[i*stride-jump] ) / two_h; }
+	return; 
+}
+
+static inline double explicit_stencil_value( double u , double xm , double xp , double ym , double yp , 
+	double zm , double zp , double ax , double ay , double az , double decay )
+{ return decay * ( u + ax*( (xm-u) + (xp-u) ) + ay*( (ym-u) + (yp-u) ) + az*( (zm-u) + (zp-u) ) ); }
+
+void explicit_stencil_row( const density_type* u , const density_type* ym , const density_type* yp , 
+	const density_type* zm , const density_type* zp , long stride , int nx , 
+	double ax , double ay , double az , double decay , density_type* out )
+{
+	if( nx == 1 )
+	{
+		out[0] = explicit_stencil_value( u[0] , u[0] , u[0] , ym[0] , yp[0] , zm[0] , zp[0] , ax , ay , az , decay ); 
+		return; 
+	}
+	
+	// row ends: zero flux through the x boundaries 
+	out[0] = explicit_stencil_value( u[0] , u[0] , u[stride] , ym[0] , yp[0] , zm[0] , zp[0] , ax , ay , az , decay ); 
+	long n = (nx-1)*stride; 
+	out[n] = explicit_stencil_value( u[n] , u[n-stride] , u[n] , ym[n] , yp[n] , zm[n] , zp[n] , ax , ay , az , decay ); 
+	
+	#pragma omp simd 
+	for( int i=1; i < nx-1 ; i++ )
+	{
+		long m = i*stride; 
+		out[m] = explicit_stencil_value( u[m] , u[m-stride] , u[m+stride] , ym[m] , yp[m] , zm[m] , zp[m] , ax , ay , az , decay ); 
+	}
+	return; 
+}
+
+};
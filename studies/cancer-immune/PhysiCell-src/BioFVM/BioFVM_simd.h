@@ -0,0 +1,124 @@
+/*
+#############################################################################
+# If you use BioFVM in your project, please cite BioFVM and the version     #
+# number, such as below:                                                    #
+#                                                                           #
+# We solved the diffusion equations using BioFVM (Version 1.1.7) [1]        #
+#                                                                           #
+# [1] A. Ghaffarizadeh, S.H. Friedman, and P. Macklin, BioFVM: an efficient #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the BioFVM Project              #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#ifndef __BioFVM_simd_h__
+#define __BioFVM_simd_h__
+
+#include <string>
+
+#include "BioFVM_density_storage.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define BIOFVM_X86_SIMD
+#endif 
+
+namespace BioFVM{
+
+/* runtime detection of the host's vector instruction sets. BioFVM kernels 
+   that have explicit SIMD versions pick the widest one the CPU supports. */ 
+
+bool cpu_supports_avx2( void ); 
+bool cpu_supports_avx512( void ); 
+
+/* batched Thomas solver: solves width independent tridiagonal systems at once. 
+   Entry (position p, lane l) of the systems is at x[ p*step + l ], so that at each 
+   position along the line, the lanes are contiguous in memory. Forward elimination 
+   and back substitution use the LOD coefficients for each lane: 
+   
+   x[p] = ( x[p] + c1*x[p-1] ) / denom[p] ; x[p] -= c[p]*x[p+1] 
+   
+   with denom and c stored as [position][lane] with row length table_stride. 
+   
+   The AVX2 and AVX-512 kernels fuse each multiply-add, so their results are not 
+   bit-identical to the generic kernel's. For the diagonally dominant LOD systems, 
+   they agree to a relative difference of 1e-12 (checked by tests/thomas_kernel_test.cpp). */ 
+
+typedef void (*batched_thomas_kernel)( double* x , long step , int width , int length , 
+	const double* c1 , const double* denom , const double* c , int table_stride ); 
+
+void batched_thomas_generic( double* x , long step , int width , int length , 
+	const double* c1 , const double* denom , const double* c , int table_stride ); 
+
+#ifdef BIOFVM_X86_SIMD
+// only call these if cpu_supports_avx2() / cpu_supports_avx512() 
+void batched_thomas_avx2( double* x , long step , int width , int length , 
+	const double* c1 , const double* denom , const double* c , int table_stride ); 
+void batched_thomas_avx512( double* x , long step , int width , int length , 
+	const double* c1 , const double* denom , const double* c , int table_stride ); 
+#endif 
+
+// returns the fastest kernel for this CPU (AVX-512, AVX2, or generic) 
+batched_thomas_kernel select_batched_thomas_kernel( void ); 
+std::string batched_thomas_kernel_name( void ); 
+
+/* central differences of one substrate along a run of voxels: 
+   
+   out[3*i] = ( in[ i*stride + jump ] - in[ i*stride - jump ] ) / two_h , i = 0 ... length-1 
+   
+   where out points to one component (x, y, or z) of the first voxel's gradient 
+   in a [voxel][3] gradient buffer. */ 
+
+void central_differences( const density_type* in , long stride , long jump , int length , 
+	double two_h , density_type* out ); 
+
+/* explicit diffusion-decay step (7-point stencil) along one x-row of one substrate: 
+   
+   out[i] = decay * ( u[i] + ax*( u[i-1] + u[i+1] - 2u[i] ) + ay*( ym[i] + yp[i] - 2u[i] ) 
+                           + az*( zm[i] + zp[i] - 2u[i] ) ) , i = 0 ... nx-1 
+   
+   where entry i is at offset i*stride, and ym, yp, zm, zp are the neighbouring rows. 
+   At the domain edges, pass the row itself as the missing neighbour (zero flux); 
+   the row ends have zero flux in x. */ 
+
+void explicit_stencil_row( const density_type* u , const density_type* ym , const density_type* yp , 
+	const density_type* zm , const density_type* zp , long stride , int nx , 
+	double ax , double ay , double az , double decay , density_type* out ); 
+
+};
+
+#endif
@@ -54,11 +54,25 @@
 
 namespace BioFVM{
 
-// do I even need this? 
+// substrates that the solver does not advance in this step (multi-rate diffusion): 
+// the explicit solvers write into the other buffer, so these must be carried over 
+static std::vector<int> inactive_substrates( const std::vector<int>& active , int number_of_densities )
+{
+	std::vector<bool> is_active( number_of_densities , false ); 
+	for( int m=0; m < active.size() ; m++ )
+	{ is_active[ active[m] ] = true; }
+	std::vector<int> output; 
+	for( int q=0; q < number_of_densities ; q++ )
+	{
+		if( !is_active[q] )
+		{ output.push_back( q ); }
+	}
+	return output; 
+}
+
 void diffusion_decay_solver__constant_coefficients_explicit( Microenvironment& M, double dt )
 {
-	static bool precomputations_and_constants_done = false; 
-	if( !precomputations_and_constants_done )
+	if( !M.diffusion_solver_setup_done )
 	{
 		std::cout	<< std::endl << "Using solver: " << __FUNCTION__ << std::endl 
 					<< "     (constant diffusion coefficient with explicit stepping, implicit decay) ... " << std::endl << std::endl;  
@@ -69,27 +83,395 @@ void diffusion_decay_solver__constant_coefficients_explicit( Microenvironment& M
 			<< "     diffusion_decay_solver__constant_coefficients_explicit_uniform_mesh" << std::endl  
 			<< std::endl; 
 		}
+		
+		// flux weights 1/|x_i - x_j|^2 for each connection, in the order of 
+		// connected_voxel_indices. These give the usual D/dx^2 on Cartesian meshes. 
+		
+		M.explicit_neighbor_weights.resize( M.number_of_voxels() ); 
+		M.explicit_max_weight_sum = 0.0; 
+		for( int i=0; i < M.number_of_voxels() ; i++ )
+		{
+			std::vector<int>& neighbors = M.mesh.connected_voxel_indices[i]; 
+			M.explicit_neighbor_weights[i].assign( neighbors.size() , 0.0 ); 
+			double weight_sum = 0.0; 
+			for( int j=0; j < neighbors.size() ; j++ )
+			{
+				double distance_squared = 0.0; 
+				for( int d=0; d < 3 ; d++ )
+				{
+					double temp = M.mesh.voxels[i].center[d] - M.mesh.voxels[ neighbors[j] ].center[d]; 
+					distance_squared += temp*temp; 
+				}
+				M.explicit_neighbor_weights[i][j] = 1.0 / distance_squared; 
+				weight_sum += M.explicit_neighbor_weights[i][j]; 
+			}
+			if( weight_sum > M.explicit_max_weight_sum )
+			{ M.explicit_max_weight_sum = weight_sum; }
+		}
+
+		M.diffusion_solver_setup_done = true; 
+	}
+	
+	std::vector<int>& active = M.active_substrates; 
+	std::vector<int> inactive = inactive_substrates( active , M.number_of_densities() ); 
+	std::vector<double> substrate_dt = M.substrate_time_steps( dt ); 
+	
+	// stability (CFL): dt*D*max_i( sum_j w_ij ) <= 1, so sub-step as needed 
+	
+	int number_of_substeps = 1; 
+	for( int m=0; m < active.size() ; m++ )
+	{
+		int q = active[m]; 
+		double ratio = substrate_dt[q] * M.diffusion_coefficients[q] * M.explicit_max_weight_sum; 
+		if( (int) ceil( ratio ) > number_of_substeps )
+		{ number_of_substeps = (int) ceil( ratio ); }
+	}
+	
+	std::vector<double> diffusion_constant( M.number_of_densities() , 0.0 ); // D*dt_sub 
+	std::vector<double> decay_constant( M.number_of_densities() , 1.0 ); // 1/(1+lambda*dt_sub) 
+	for( int m=0; m < active.size() ; m++ )
+	{
+		int q = active[m]; 
+		double substep = substrate_dt[q] / (double) number_of_substeps; 
+		diffusion_constant[q] = M.diffusion_coefficients[q] * substep; 
+		decay_constant[q] = 1.0 / ( 1.0 + M.decay_rates[q] * substep ); 
+	}
 
-		precomputations_and_constants_done = true; 
+	// cell secretion / uptake 
+	
+	if( M.fused_cell_sources_and_sinks )
+	{ M.simulate_binned_cell_sources_and_sinks( dt ); }
+	
+	for( int s=0; s < number_of_substeps ; s++ )
+	{
+		M.apply_dirichlet_conditions(); 
+		
+		// double buffering: read the current buffer, write the other one 
+		Density_Storage* pOld = M.p_density_storage; 
+		Density_Storage* pNew = ( pOld == &(M.density_storage1) ) ? &(M.density_storage2) : &(M.density_storage1); 
+		
+		#pragma omp parallel for 
+		for( int i=0; i < M.number_of_voxels() ; i++ )
+		{
+			const std::vector<int>& neighbors = M.mesh.connected_voxel_indices[i]; 
+			const std::vector<double>& weights = M.explicit_neighbor_weights[i]; 
+			
+			for( int m=0; m < active.size() ; m++ )
+			{
+				int q = active[m]; 
+				double u = pOld->value(i,q); 
+				double flux = 0.0; 
+				for( int j=0; j < neighbors.size() ; j++ )
+				{ flux += weights[j] * ( pOld->value( neighbors[j] , q ) - u ); }
+				pNew->value(i,q) = decay_constant[q] * ( u + diffusion_constant[q] * flux ); 
+			}
+			for( int m=0; m < inactive.size() ; m++ )
+			{ pNew->value(i,inactive[m]) = pOld->value(i,inactive[m]); }
+		}
+		
+		M.p_density_storage = pNew; 
 	}
+	
+	M.apply_dirichlet_conditions(); 
 
 	return; 
 }
 
 void diffusion_decay_solver__constant_coefficients_explicit_uniform_mesh( Microenvironment& M, double dt )
 {
-	static bool precomputations_and_constants_done = false; 
-	if( !precomputations_and_constants_done )
+	if( M.mesh.Cartesian_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for Cartesian meshes. Try: diffusion_decay_solver__constant_coefficients_explicit" << std::endl << std::endl; 
+		return; 
+	}
+	
+	if( !M.diffusion_solver_setup_done )
 	{
 		std::cout	<< std::endl << "Using solver: " << __FUNCTION__ << std::endl 
 					<< "     (constant diffusion coefficient with explicit stepping, implicit decay, uniform mesh) ... " << std::endl << std::endl;  
 
-		if( M.mesh.uniform_mesh == false )
-		{ std::cout << "Error. This code is only supported for uniform meshes." << std::endl; }
+		M.diffusion_solver_setup_done = true; 
+	}
+	
+	int nx = M.mesh.x_coordinates.size(); 
+	int ny = M.mesh.y_coordinates.size(); 
+	int nz = M.mesh.z_coordinates.size(); 
+	
+	// 1/h^2 along each axis that has more than one voxel (so this also does 2D and 1D domains) 
+	double inverse_dx2 = ( nx > 1 ) ? 1.0 / ( M.mesh.dx * M.mesh.dx ) : 0.0; 
+	double inverse_dy2 = ( ny > 1 ) ? 1.0 / ( M.mesh.dy * M.mesh.dy ) : 0.0; 
+	double inverse_dz2 = ( nz > 1 ) ? 1.0 / ( M.mesh.dz * M.mesh.dz ) : 0.0; 
+	
+	std::vector<int>& active = M.active_substrates; 
+	std::vector<int> inactive = inactive_substrates( active , M.number_of_densities() ); 
+	std::vector<double> substrate_dt = M.substrate_time_steps( dt ); 
+	
+	// stability (CFL): dt*D*( 2/dx^2 + 2/dy^2 + 2/dz^2 ) <= 1, so sub-step as needed 
+	
+	int number_of_substeps = 1; 
+	for( int m=0; m < active.size() ; m++ )
+	{
+		int q = active[m]; 
+		double ratio = substrate_dt[q] * M.diffusion_coefficients[q] * 2.0 * ( inverse_dx2 + inverse_dy2 + inverse_dz2 ); 
+		if( (int) ceil( ratio ) > number_of_substeps )
+		{ number_of_substeps = (int) ceil( ratio ); }
+	}
+	
+	std::vector<double> ax( M.number_of_densities() , 0.0 ); // D*dt_sub/dx^2 
+	std::vector<double> ay( M.number_of_densities() , 0.0 ); 
+	std::vector<double> az( M.number_of_densities() , 0.0 ); 
+	std::vector<double> decay_constant( M.number_of_densities() , 1.0 ); // 1/(1+lambda*dt_sub) 
+	for( int m=0; m < active.size() ; m++ )
+	{
+		int q = active[m]; 
+		double substep = substrate_dt[q] / (double) number_of_substeps; 
+		ax[q] = M.diffusion_coefficients[q] * substep * inverse_dx2; 
+		ay[q] = M.diffusion_coefficients[q] * substep * inverse_dy2; 
+		az[q] = M.diffusion_coefficients[q] * substep * inverse_dz2; 
+		decay_constant[q] = 1.0 / ( 1.0 + M.decay_rates[q] * substep ); 
+	}
+	
+	// cell secretion / uptake 
+	
+	if( M.fused_cell_sources_and_sinks )
+	{ M.simulate_binned_cell_sources_and_sinks( dt ); }
+	
+	for( int s=0; s < number_of_substeps ; s++ )
+	{
+		M.apply_dirichlet_conditions(); 
+		
+		// double buffering: read the current buffer, write the other one 
+		Density_Storage* pOld = M.p_density_storage; 
+		Density_Storage* pNew = ( pOld == &(M.density_storage1) ) ? &(M.density_storage2) : &(M.density_storage1); 
+		long stride = pOld->voxel_stride(); 
+		long y_jump = stride * nx; 
+		long z_jump = y_jump * ny; 
+		
+		// one x-row of one substrate at a time. At the y and z edges, the row itself 
+		// stands in for the missing neighbour row (zero flux). 
+		
+		#pragma omp parallel for collapse(2) 
+		for( int k=0; k < nz ; k++ )
+		{
+			for( int j=0; j < ny ; j++ )
+			{
+				int n = M.mesh.voxel_index(0,j,k); 
+				for( int m=0; m < active.size() ; m++ )
+				{
+					int q = active[m]; 
+					const density_type* u = &( pOld->value(n,q) ); 
+					const density_type* ym = ( j > 0 ) ? u - y_jump : u; 
+					const density_type* yp = ( j < ny-1 ) ? u + y_jump : u; 
+					const density_type* zm = ( k > 0 ) ? u - z_jump : u; 
+					const density_type* zp = ( k < nz-1 ) ? u + z_jump : u; 
+					explicit_stencil_row( u , ym , yp , zm , zp , stride , nx , 
+						ax[q] , ay[q] , az[q] , decay_constant[q] , &( pNew->value(n,q) ) ); 
+				}
+				for( int m=0; m < inactive.size() ; m++ )
+				{
+					int q = inactive[m]; 
+					for( int i=0; i < nx ; i++ )
+					{ pNew->value(n+i,q) = pOld->value(n+i,q); }
+				}
+			}
+		}
+		
+		M.p_density_storage = pNew; 
+	}
+	
+	M.apply_dirichlet_conditions(); 
+
+	return; 
+}
+
+// Thomas algorithm along one line of voxels (all substrates), working directly on 
+// the density buffer. line points to the first voxel of the line, jump is the 
+// distance (in doubles) between consecutive voxels on the line, and ss is the 
+// distance between consecutive substrates within a voxel. Forward elimination 
+// uses the pre-computed denominators; back substitution the pre-computed c's. 
+static void thomas_solve_line_in_place( double* line , int jump , int ss , int length , 
+	const std::vector<double>& constant1 , 
+	const std::vector< std::vector<double> >& denom , 
+	const std::vector< std::vector<double> >& c , const std::vector<int>& substrates )
+{
+	int number_of_substrates = substrates.size(); 
+	const int* Q = substrates.data(); 
+	
+	if( ss == 1 )
+	{
+		// voxel-major: the substrates of each voxel are contiguous 
+		double* p = line; 
+		for( int m=0; m < number_of_substrates ; m++ )
+		{ p[Q[m]] /= denom[0][Q[m]]; }
+		
+		for( int i=1; i < length ; i++ )
+		{
+			p += jump; 
+			const double* pPrev = p - jump; 
+			const double* d = denom[i].data(); 
+			for( int m=0; m < number_of_substrates ; m++ )
+			{
+				int q = Q[m]; 
+				p[q] += constant1[q] * pPrev[q]; 
+				p[q] /= d[q]; 
+			}
+		}
+		
+		for( int i=length-2; i >= 0 ; i-- )
+		{
+			p -= jump; 
+			const double* pNext = p + jump; 
+			const double* cc = c[i].data(); 
+			for( int m=0; m < number_of_substrates ; m++ )
+			{ p[Q[m]] -= cc[Q[m]] * pNext[Q[m]]; }
+		}
+		return; 
+	}
+	
+	// substrate-major: sweep one substrate at a time 
+	for( int m=0; m < number_of_substrates ; m++ )
+	{
+		int q = Q[m]; 
+		double* p = line + q*ss; 
+		double c1 = constant1[q]; 
+		
+		p[0] /= denom[0][q]; 
+		for( int i=1; i < length ; i++ )
+		{
+			p[i*jump] += c1 * p[(i-1)*jump]; 
+			p[i*jump] /= denom[i][q]; 
+		}
+		
+		for( int i=length-2; i >= 0 ; i-- )
+		{ p[i*jump] -= c[i][q] * p[(i+1)*jump]; }
+	}
+	return; 
+}
+
+void thomas_solve_line( density_type* line , int jump , int ss , int length , 
+	const std::vector<double>& constant1 , 
+	const std::vector< std::vector<double> >& denom , 
+	const std::vector< std::vector<double> >& c , double* scratch , const std::vector<int>& substrates )
+{
+#ifdef BIOFVM_SINGLE_PRECISION_DENSITIES
+	// copy the line to [voxel][substrate] doubles, solve it there, and round once on the way back 
+	int number_of_densities = constant1.size(); 
+	for( int i=0; i < length ; i++ )
+	{
+		for( int q=0; q < number_of_densities ; q++ )
+		{ scratch[ i*number_of_densities + q ] = line[ i*jump + q*ss ]; }
+	}
+	thomas_solve_line_in_place( scratch , number_of_densities , 1 , length , constant1 , denom , c , substrates ); 
+	for( int i=0; i < length ; i++ )
+	{
+		for( int q=0; q < number_of_densities ; q++ )
+		{ line[ i*jump + q*ss ] = scratch[ i*number_of_densities + q ]; }
+	}
+#else
+	thomas_solve_line_in_place( line , jump , ss , length , constant1 , denom , c , substrates ); 
+#endif 
+	return; 
+}
+
+// number of voxels per tile in the cache-blocked z-sweep. At 16 voxels, a tile of a 200^3 
+// mesh with 2 substrates is ~50 kB, and the AVX kernels work on whole blocks 
+// (timings: tests/z_sweep_benchmark.cpp). 
+static const int thomas_z_tile_size = 16; 
 
-		precomputations_and_constants_done = true; 
+// The batched sweeps treat every (voxel, substrate) entry of an x-row as one lane, 
+// so lane e belongs to substrate e % nd (voxel-major) or e / nx (substrate-major). 
+void expand_thomas_coefficients_to_lanes( const std::vector< std::vector<double> >& coefficients , 
+	int nx , int layout , aligned_vector& lanes )
+{
+	int number_of_densities = coefficients[0].size(); 
+	int width = nx*number_of_densities; 
+	lanes.assign( coefficients.size()*width , 0.0 ); 
+	for( int p=0; p < coefficients.size() ; p++ )
+	{
+		for( int e=0; e < width ; e++ )
+		{
+			int q = ( layout == density_layout_voxel_major ) ? e % number_of_densities : e / nx; 
+			lanes[ p*width + e ] = coefficients[p][q]; 
+		}
+	}
+	return; 
+}
+
+// lanes per block when batched lines are solved in the double work space 
+static const int thomas_scratch_lanes = 32; 
+
+long thomas_scratch_size( int max_length , int max_line_width )
+{
+	long size = (long) thomas_scratch_lanes * max_length; 
+	if( size < max_line_width )
+	{ size = max_line_width; }
+	return size; 
+}
+
+// run the batched kernel on width lanes starting at x. With single-precision densities, 
+// blocks of lanes are copied to the double work space, solved there, and copied back. 
+static void solve_lanes( batched_thomas_kernel kernel , density_type* x , long step , int width , int length , 
+	const double* c1 , const double* denom , const double* c , int table_stride , double* scratch )
+{
+#ifdef BIOFVM_SINGLE_PRECISION_DENSITIES
+	for( int l=0; l < width ; l += thomas_scratch_lanes )
+	{
+		int w = width - l; 
+		if( w > thomas_scratch_lanes )
+		{ w = thomas_scratch_lanes; }
+		
+		for( int p=0; p < length ; p++ )
+		{
+			const density_type* row = x + p*step + l; 
+			for( int m=0; m < w ; m++ )
+			{ scratch[ p*w + m ] = row[m]; }
+		}
+		
+		kernel( scratch , w , w , length , c1+l , denom+l , c+l , table_stride ); 
+		
+		for( int p=0; p < length ; p++ )
+		{
+			density_type* row = x + p*step + l; 
+			for( int m=0; m < w ; m++ )
+			{ row[m] = scratch[ p*w + m ]; }
+		}
 	}
+#else
+	kernel( x , step , width , length , c1 , denom , c , table_stride ); 
+#endif 
+	return; 
+}
 
+// row points to the first of nx consecutive voxels (an x-row, or a tile of a z-plane), 
+// and step is the distance (in doubles) between that row and the next one along the 
+// sweep direction. Only the lines starting in voxels i_start to i_end-1 of the row 
+// are solved. 
+void thomas_solve_rows( batched_thomas_kernel kernel , Density_Storage& D , density_type* row , long step , int nx , 
+	int i_start , int i_end , int length , 
+	const aligned_vector& constant1 , const aligned_vector& denom , const aligned_vector& c , double* scratch , 
+	const std::vector<int>& substrates )
+{
+	int number_of_densities = D.number_of_densities(); 
+	int width = nx*number_of_densities; 
+	
+	// voxel-major: the lanes of all substrates are interleaved, so all are solved 
+	if( D.get_layout() == density_layout_voxel_major )
+	{
+		int e = i_start*number_of_densities; 
+		solve_lanes( kernel , row + e , step , (i_end-i_start)*number_of_densities , length , 
+			constant1.data() + e , denom.data() + e , c.data() + e , width , scratch ); 
+		return; 
+	}
+	
+	// substrate-major: the x-row of each substrate is contiguous 
+	int ss = D.substrate_stride(); 
+	for( int m=0; m < substrates.size() ; m++ )
+	{
+		int q = substrates[m]; 
+		int e = q*nx + i_start; 
+		solve_lanes( kernel , row + (long) q*ss + i_start , step , i_end-i_start , length , 
+			constant1.data() + e , denom.data() + e , c.data() + e , width , scratch ); 
+	}
 	return; 
 }
 
@@ -121,20 +503,23 @@ void diffusion_decay_solver__constant_coefficients_LOD_3D( Microenvironment& M,
 		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
 		M.thomas_k_jump = M.thomas_j_jump * M.mesh.y_coordinates.size(); 
 
+		// each substrate's own time step (multi-rate diffusion) 
+		std::vector<double> substrate_dt = M.substrate_time_steps( dt ); 
+		
 		M.thomas_constant1 =  M.diffusion_coefficients; // dt*D/dx^2 
 		M.thomas_constant1a = M.zero; // -dt*D/dx^2; 
 		M.thomas_constant2 =  M.decay_rates; // (1/3)* dt*lambda 
 		M.thomas_constant3 = M.one; // 1 + 2*constant1 + constant2; 
 		M.thomas_constant3a = M.one; // 1 + constant1 + constant2; 		
 			
-		M.thomas_constant1 *= dt; 
+		M.thomas_constant1 *= substrate_dt; 
 		M.thomas_constant1 /= M.mesh.dx; 
 		M.thomas_constant1 /= M.mesh.dx; 
 
 		M.thomas_constant1a = M.thomas_constant1; 
 		M.thomas_constant1a *= -1.0; 
 
-		M.thomas_constant2 *= dt; 
+		M.thomas_constant2 *= substrate_dt; 
 		M.thomas_constant2 /= 3.0; // for the LOD splitting of the source 
 
 		M.thomas_constant3 += M.thomas_constant1; 
@@ -187,109 +572,136 @@ void diffusion_decay_solver__constant_coefficients_LOD_3D( Microenvironment& M,
 			axpy( &M.thomas_denomz[i] , M.thomas_constant1 , M.thomas_cz[i-1] ); 
 			M.thomas_cz[i] /= M.thomas_denomz[i]; // the value at  size-1 is not actually used  
 		}	
+		
+		// lane coefficients for the batched y- and z-sweeps 
+		
+		if( M.thomas_kernel )
+		{
+			int layout = M.get_density_layout(); 
+			int nx = M.mesh.x_coordinates.size(); 
+			std::vector< std::vector<double> > constant1_table( 1 , M.thomas_constant1 ); 
+			expand_thomas_coefficients_to_lanes( constant1_table , nx , layout , M.thomas_lane_constant1 ); 
+			expand_thomas_coefficients_to_lanes( M.thomas_denomy , nx , layout , M.thomas_lane_denomy ); 
+			expand_thomas_coefficients_to_lanes( M.thomas_cy , nx , layout , M.thomas_lane_cy ); 
+			expand_thomas_coefficients_to_lanes( constant1_table , thomas_z_tile_size , layout , M.thomas_tile_constant1 ); 
+			expand_thomas_coefficients_to_lanes( M.thomas_denomz , thomas_z_tile_size , layout , M.thomas_lane_denomz ); 
+			expand_thomas_coefficients_to_lanes( M.thomas_cz , thomas_z_tile_size , layout , M.thomas_lane_cz ); 
+			std::cout << "     (y- and z-sweeps vectorized with the " << batched_thomas_kernel_name() << " kernel)" << std::endl << std::endl; 
+		}
+		
+#ifdef BIOFVM_SINGLE_PRECISION_DENSITIES
+		// double-precision work space for solving the single-precision densities 
+		int max_length = M.mesh.x_coordinates.size(); 
+		if( M.mesh.y_coordinates.size() > max_length )
+		{ max_length = M.mesh.y_coordinates.size(); }
+		if( M.mesh.z_coordinates.size() > max_length )
+		{ max_length = M.mesh.z_coordinates.size(); }
+		M.resize_thomas_scratch( thomas_scratch_size( max_length , max_length*M.number_of_densities() ) ); 
+		std::cout << "     (single-precision densities, double-precision elimination)" << std::endl << std::endl; 
+#endif 
 
 		M.diffusion_solver_setup_done = true; 
 	}
+	M.prepare_thomas_scratch(); 
+
+	density_type* pD = M.p_density_storage->pointer(); 
+	int vs = M.p_density_storage->voxel_stride(); 
+	int ss = M.p_density_storage->substrate_stride(); 
+	// the batched sweeps solve all substrates of a voxel-major row at once, so they are 
+	// only used there when every substrate is advanced in this step (initialize_microenvironment 
+	// switches to the substrate-major layout when multi-rate diffusion is on) 
+	bool batched = M.thomas_kernel && ( M.active_substrates.size() == M.number_of_densities() || 
+		M.get_density_layout() == density_layout_substrate_major ); 
+	int nx = M.mesh.x_coordinates.size(); 
+	int ny = M.mesh.y_coordinates.size(); 
+	int nz = M.mesh.z_coordinates.size(); 
 
 	// x-diffusion 
 	
+	if( M.fused_cell_sources_and_sinks )
+	{ M.bin_cell_sources_and_sinks(); }
+	
 	M.apply_dirichlet_conditions();
 	#pragma omp parallel for 
-	for( int k=0; k < M.mesh.z_coordinates.size() ; k++ )
+	for( int k=0; k < nz ; k++ )
 	{
-		for( int j=0; j < M.mesh.y_coordinates.size() ; j++ )
+		for( int j=0; j < ny ; j++ )
 		{
+			// cell secretion / uptake in this line 
+			if( M.fused_cell_sources_and_sinks )
+			{ M.apply_cell_sources_and_sinks( j + ny*k , dt ); }
+			
 			// Thomas solver, x-direction
-
-			// remaining part of forward elimination, using pre-computed quantities 
-			int n = M.voxel_index(0,j,k);
-			(*M.p_density_vectors)[n] /= M.thomas_denomx[0]; 
-
-			for( int i=1; i < M.mesh.x_coordinates.size() ; i++ )
-			{
-				n = M.voxel_index(i,j,k); 
-				axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_i_jump] ); 
-				(*M.p_density_vectors)[n] /= M.thomas_denomx[i]; 
-			}
-
-			for( int i = M.mesh.x_coordinates.size()-2 ; i >= 0 ; i-- )
-			{
-				n = M.voxel_index(i,j,k); 
-				naxpy( &(*M.p_density_vectors)[n] , M.thomas_cx[i] , (*M.p_density_vectors)[n+M.thomas_i_jump] ); 
-			}
-
+			thomas_solve_line( pD + M.voxel_index(0,j,k)*vs , M.thomas_i_jump*vs , ss , nx , 
+				M.thomas_constant1 , M.thomas_denomx , M.thomas_cx , M.thomas_scratch_buffer() , M.active_substrates ); 
 		}
 	}
 
 	// y-diffusion 
 
 	M.apply_dirichlet_conditions();
-	#pragma omp parallel for 
-	for( int k=0; k < M.mesh.z_coordinates.size() ; k++ )
+	if( batched )
 	{
-		for( int i=0; i < M.mesh.x_coordinates.size() ; i++ )
+		#pragma omp parallel for 
+		for( int k=0; k < nz ; k++ )
 		{
-   // Thomas solver, y-direction
-
-	// remaining part of forward elimination, using pre-computed quantities 
-
-	int n = M.voxel_index(i,0,k);
-	(*M.p_density_vectors)[n] /= M.thomas_denomy[0]; 
-
-	for( int j=1; j < M.mesh.y_coordinates.size() ; j++ )
-	{
-		n = M.voxel_index(i,j,k); 
-		axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_j_jump] ); 
-		(*M.p_density_vectors)[n] /= M.thomas_denomy[j]; 
+			// Thomas solver, y-direction: all lines starting in the x-row (0:nx-1,0,k) at once 
+			thomas_solve_rows( M.thomas_kernel , *M.p_density_storage , pD + M.voxel_index(0,0,k)*vs , 
+				(long) M.thomas_j_jump*vs , nx , 0 , nx , ny , M.thomas_lane_constant1 , M.thomas_lane_denomy , M.thomas_lane_cy , M.thomas_scratch_buffer() , M.active_substrates ); 
+		}
 	}
-
-	// back substitution 
-	// n = voxel_index( mesh.x_coordinates.size()-2 ,j,k); 
-
-	for( int j = M.mesh.y_coordinates.size()-2 ; j >= 0 ; j-- )
+	else
 	{
-		n = M.voxel_index(i,j,k); 
-		naxpy( &(*M.p_density_vectors)[n] , M.thomas_cy[j] , (*M.p_density_vectors)[n+M.thomas_j_jump] ); 
+		#pragma omp parallel for 
+		for( int k=0; k < nz ; k++ )
+		{
+			for( int i=0; i < nx ; i++ )
+			{
+				// Thomas solver, y-direction
+				thomas_solve_line( pD + M.voxel_index(i,0,k)*vs , M.thomas_j_jump*vs , ss , ny , 
+					M.thomas_constant1 , M.thomas_denomy , M.thomas_cy , M.thomas_scratch_buffer() , M.active_substrates ); 
+			}
+		}
 	}
 
-  }
- }
-
- // z-diffusion 
+	// z-diffusion 
 
 	M.apply_dirichlet_conditions();
- #pragma omp parallel for 
- for( int j=0; j < M.mesh.y_coordinates.size() ; j++ )
- {
-	 
-  for( int i=0; i < M.mesh.x_coordinates.size() ; i++ )
-  {
-   // Thomas solver, y-direction
-
-	// remaining part of forward elimination, using pre-computed quantities 
-
-	int n = M.voxel_index(i,j,0);
-	(*M.p_density_vectors)[n] /= M.thomas_denomz[0]; 
-
-	// should be an empty loop if mesh.z_coordinates.size() < 2  
-	for( int k=1; k < M.mesh.z_coordinates.size() ; k++ )
+	if( batched )
 	{
-		n = M.voxel_index(i,j,k); 
-		axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_k_jump] ); 
-		(*M.p_density_vectors)[n] /= M.thomas_denomz[k]; 
+		// The voxels of a z-plane are contiguous in memory (for either layout), so the plane 
+		// is cut into tiles of consecutive voxels, and all lines starting in a tile are 
+		// solved together. A tile is small enough to stay in cache for both the forward 
+		// and backward passes, even though consecutive entries of a line are a full 
+		// z-plane apart. 
+		int plane_size = nx*ny; 
+		int number_of_tiles = (plane_size + thomas_z_tile_size - 1) / thomas_z_tile_size; 
+		#pragma omp parallel for 
+		for( int t=0; t < number_of_tiles ; t++ )
+		{
+			int n_start = t*thomas_z_tile_size; 
+			int n_end = n_start + thomas_z_tile_size; 
+			if( n_end > plane_size )
+			{ n_end = plane_size; }
+			// Thomas solver, z-direction: all lines starting in voxels n_start to n_end-1 at once 
+			thomas_solve_rows( M.thomas_kernel , *M.p_density_storage , pD + (long) n_start*vs , 
+				(long) M.thomas_k_jump*vs , thomas_z_tile_size , 0 , n_end-n_start , nz , 
+				M.thomas_tile_constant1 , M.thomas_lane_denomz , M.thomas_lane_cz , M.thomas_scratch_buffer() , M.active_substrates ); 
+		}
 	}
-
-	// back substitution 
-
-	// should be an empty loop if mesh.z_coordinates.size() < 2 
-	for( int k = M.mesh.z_coordinates.size()-2 ; k >= 0 ; k-- )
+	else
 	{
-		n = M.voxel_index(i,j,k); 
-		naxpy( &(*M.p_density_vectors)[n] , M.thomas_cz[k] , (*M.p_density_vectors)[n+M.thomas_k_jump] ); 
-		// n -= i_jump; 
+		#pragma omp parallel for 
+		for( int j=0; j < ny ; j++ )
+		{
+			for( int i=0; i < nx ; i++ )
+			{
+				// Thomas solver, z-direction
+				thomas_solve_line( pD + M.voxel_index(i,j,0)*vs , M.thomas_k_jump*vs , ss , nz , 
+					M.thomas_constant1 , M.thomas_denomz , M.thomas_cz , M.thomas_scratch_buffer() , M.active_substrates ); 
+			}
+		}
 	}
-  }
- }
  
 	M.apply_dirichlet_conditions();
 	
@@ -324,20 +736,23 @@ void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& M,
 		M.thomas_i_jump = 1; 
 		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
 
+		// each substrate's own time step (multi-rate diffusion) 
+		std::vector<double> substrate_dt = M.substrate_time_steps( dt ); 
+		
 		M.thomas_constant1 =  M.diffusion_coefficients; //   dt*D/dx^2 
 		M.thomas_constant1a = M.zero; // -dt*D/dx^2; 
 		M.thomas_constant2 =  M.decay_rates; // (1/2)*dt*lambda 
 		M.thomas_constant3 = M.one; // 1 + 2*constant1 + constant2; 
 		M.thomas_constant3a = M.one; // 1 + constant1 + constant2; 
 		
-		M.thomas_constant1 *= dt; 
+		M.thomas_constant1 *= substrate_dt; 
 		M.thomas_constant1 /= M.mesh.dx; 
 		M.thomas_constant1 /= M.mesh.dx; 
 
 		M.thomas_constant1a = M.thomas_constant1; 
 		M.thomas_constant1a *= -1.0; 
 
-		M.thomas_constant2 *= dt; 
+		M.thomas_constant2 *= substrate_dt; 
 		M.thomas_constant2 *= 0.5; // for splitting via LOD
 
 		M.thomas_constant3 += M.thomas_constant1; 
@@ -377,69 +792,88 @@ void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& M,
 			axpy( &M.thomas_denomy[i] , M.thomas_constant1 , M.thomas_cy[i-1] ); 
 			M.thomas_cy[i] /= M.thomas_denomy[i]; // the value at  size-1 is not actually used  
 		}
+		
+		// lane coefficients for the batched y-sweep 
+		
+		if( M.thomas_kernel )
+		{
+			int layout = M.get_density_layout(); 
+			int nx = M.mesh.x_coordinates.size(); 
+			std::vector< std::vector<double> > constant1_table( 1 , M.thomas_constant1 ); 
+			expand_thomas_coefficients_to_lanes( constant1_table , nx , layout , M.thomas_lane_constant1 ); 
+			expand_thomas_coefficients_to_lanes( M.thomas_denomy , nx , layout , M.thomas_lane_denomy ); 
+			expand_thomas_coefficients_to_lanes( M.thomas_cy , nx , layout , M.thomas_lane_cy ); 
+			std::cout << "     (y-sweeps vectorized with the " << batched_thomas_kernel_name() << " kernel)" << std::endl << std::endl; 
+		}
+		
+#ifdef BIOFVM_SINGLE_PRECISION_DENSITIES
+		// double-precision work space for solving the single-precision densities 
+		int max_length = M.mesh.x_coordinates.size(); 
+		if( M.mesh.y_coordinates.size() > max_length )
+		{ max_length = M.mesh.y_coordinates.size(); }
+		M.resize_thomas_scratch( thomas_scratch_size( max_length , max_length*M.number_of_densities() ) ); 
+		std::cout << "     (single-precision densities, double-precision elimination)" << std::endl << std::endl; 
+#endif 
 
 		M.diffusion_solver_setup_done = true; 
 	}
-
-	// set the pointers
+	M.prepare_thomas_scratch(); 
+
+	density_type* pD = M.p_density_storage->pointer(); 
+	int vs = M.p_density_storage->voxel_stride(); 
+	int ss = M.p_density_storage->substrate_stride(); 
+	// the batched sweeps solve all substrates of a voxel-major row at once, so they are 
+	// only used there when every substrate is advanced in this step (initialize_microenvironment 
+	// switches to the substrate-major layout when multi-rate diffusion is on) 
+	bool batched = M.thomas_kernel && ( M.active_substrates.size() == M.number_of_densities() || 
+		M.get_density_layout() == density_layout_substrate_major ); 
+	int nx = M.mesh.x_coordinates.size(); 
+	int ny = M.mesh.y_coordinates.size(); 
+
+	if( M.fused_cell_sources_and_sinks )
+	{ M.bin_cell_sources_and_sinks(); }
 
 	M.apply_dirichlet_conditions();
 	// x-diffusion 
 	#pragma omp parallel for 
-	for( int j=0; j < M.mesh.y_coordinates.size() ; j++ )
+	for( int j=0; j < ny ; j++ )
 	{
+		// cell secretion / uptake in this line 
+		if( M.fused_cell_sources_and_sinks )
+		{ M.apply_cell_sources_and_sinks( j , dt ); }
+		
 		// Thomas solver, x-direction
-
-		// remaining part of forward elimination, using pre-computed quantities 
-		int n = M.voxel_index(0,j,0);
-		(*M.p_density_vectors)[n] /= M.thomas_denomx[0]; 
-
-		n += M.thomas_i_jump; 
-		for( int i=1; i < M.mesh.x_coordinates.size() ; i++ )
-		{
-			axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_i_jump] ); 
-			(*M.p_density_vectors)[n] /= M.thomas_denomx[i]; 
-			n += M.thomas_i_jump; 
-		}
-
-		// back substitution 
-		n = M.voxel_index( M.mesh.x_coordinates.size()-2 ,j,0); 
-
-		for( int i = M.mesh.x_coordinates.size()-2 ; i >= 0 ; i-- )
-		{
-			naxpy( &(*M.p_density_vectors)[n] , M.thomas_cx[i] , (*M.p_density_vectors)[n+M.thomas_i_jump] ); 
-			n -= M.thomas_i_jump; 
-		}
+		thomas_solve_line( pD + M.voxel_index(0,j,0)*vs , M.thomas_i_jump*vs , ss , nx , 
+			M.thomas_constant1 , M.thomas_denomx , M.thomas_cx , M.thomas_scratch_buffer() , M.active_substrates ); 
 	}
 
 	// y-diffusion 
 
 	M.apply_dirichlet_conditions();
-	#pragma omp parallel for 
-	for( int i=0; i < M.mesh.x_coordinates.size() ; i++ )
+	if( batched )
 	{
-		// Thomas solver, y-direction
-
-		// remaining part of forward elimination, using pre-computed quantities 
-
-		int n = M.voxel_index(i,0,0);
-		(*M.p_density_vectors)[n] /= M.thomas_denomy[0]; 
-
-		n += M.thomas_j_jump; 
-		for( int j=1; j < M.mesh.y_coordinates.size() ; j++ )
+		// split the x-row into blocks of lines, one block per task 
+		int block = 16; 
+		int number_of_blocks = (nx + block - 1) / block; 
+		#pragma omp parallel for 
+		for( int b=0; b < number_of_blocks ; b++ )
 		{
-			axpy( &(*M.p_density_vectors)[n] , M.thomas_constant1 , (*M.p_density_vectors)[n-M.thomas_j_jump] ); 
-			(*M.p_density_vectors)[n] /= M.thomas_denomy[j]; 
-			n += M.thomas_j_jump; 
+			// Thomas solver, y-direction: all lines starting in voxels (b*block:(b+1)*block-1,0) at once 
+			int i_end = (b+1)*block; 
+			if( i_end > nx )
+			{ i_end = nx; }
+			thomas_solve_rows( M.thomas_kernel , *M.p_density_storage , pD , (long) M.thomas_j_jump*vs , nx , b*block , i_end , ny , 
+				M.thomas_lane_constant1 , M.thomas_lane_denomy , M.thomas_lane_cy , M.thomas_scratch_buffer() , M.active_substrates ); 
 		}
-
-		// back substitution 
-		n = M.voxel_index( i,M.mesh.y_coordinates.size()-2, 0); 
-
-		for( int j = M.mesh.y_coordinates.size()-2 ; j >= 0 ; j-- )
+	}
+	else
+	{
+		#pragma omp parallel for 
+		for( int i=0; i < nx ; i++ )
 		{
-			naxpy( &(*M.p_density_vectors)[n] , M.thomas_cy[j] , (*M.p_density_vectors)[n+M.thomas_j_jump] ); 
-			n -= M.thomas_j_jump; 
+			// Thomas solver, y-direction
+			thomas_solve_line( pD + M.voxel_index(i,0,0)*vs , M.thomas_j_jump*vs , ss , ny , 
+				M.thomas_constant1 , M.thomas_denomy , M.thomas_cy , M.thomas_scratch_buffer() , M.active_substrates ); 
 		}
 	}
 
@@ -451,73 +885,265 @@ void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& M,
 	return; 
 }
 
-void diffusion_decay_explicit_uniform_rates( Microenvironment& M, double dt )
+// diffusion coefficient on the face between two voxels (harmonic mean, so a voxel 
+// with D = 0 blocks the exchange) 
+static inline double face_diffusion_coefficient( double D1 , double D2 )
 {
-	using std::vector; 
-	using std::cout; 
-	using std::endl; 
+	if( D1 + D2 <= 0.0 )
+	{ return 0.0; }
+	return 2.0*D1*D2 / ( D1 + D2 ); 
+}
 
-	static int n_jump_i = 1; 
-	static int n_jump_j = M.mesh.x_coordinates.size(); 
-	static int n_jump_k = M.mesh.x_coordinates.size() * M.mesh.y_coordinates.size(); 
+// Thomas factorization of the variable-coefficient LOD systems along all lines of one 
+// axis (0,1,2 = x,y,z), for one substrate with per-voxel D and lambda. The matrices are 
+// symmetric: lower[n] is the entry coupling voxel n to the previous voxel on its line 
+// (0 at the start of a line). decay_dt is the share of dt*lambda taken by each sweep. 
+static void factorize_variable_coefficient_lines( Cartesian_Mesh& mesh , const std::vector<double>& D , 
+	const std::vector<double>& lambda , int axis , double dt_over_h2 , double decay_dt , 
+	double* lower , double* inverse_pivot )
+{
+	int nx = mesh.x_coordinates.size(); 
+	int ny = mesh.y_coordinates.size(); 
+	int nz = mesh.z_coordinates.size(); 
+	int lengths [3] = { nx , ny , nz }; 
+	long jumps [3] = { 1 , nx , (long) nx*ny }; 
+	int length = lengths[axis]; 
+	long jump = jumps[axis]; 
+	
+	// the previous voxel on any line has a smaller index, so one pass in index order will do 
+	for( int k=0; k < nz ; k++ )
+	{
+		for( int j=0; j < ny ; j++ )
+		{
+			for( int i=0; i < nx ; i++ )
+			{
+				int position [3] = { i , j , k }; 
+				int p = position[axis]; 
+				long n = mesh.voxel_index(i,j,k); 
+				
+				double previous = 0.0; 
+				double next = 0.0; 
+				if( p > 0 )
+				{ previous = dt_over_h2 * face_diffusion_coefficient( D[n] , D[n-jump] ); }
+				if( p < length-1 )
+				{ next = dt_over_h2 * face_diffusion_coefficient( D[n] , D[n+jump] ); }
+				
+				double pivot = 1.0 + decay_dt*lambda[n] + previous + next; 
+				if( p > 0 )
+				{ pivot -= previous * previous * inverse_pivot[n-jump]; }
+				
+				lower[n] = -previous; 
+				inverse_pivot[n] = 1.0 / pivot; 
+			}
+		}
+	}
+	return; 
+}
 
-	if( !M.diffusion_solver_setup_done )
-	{	
-		M.thomas_i_jump = 1; 
-		M.thomas_j_jump = M.mesh.x_coordinates.size(); 
-		M.thomas_k_jump = M.thomas_j_jump * M.mesh.y_coordinates.size(); 
+// solve the factorized lines of substrate q that start in voxels base ... base+lanes-1 
+// (consecutive in x), jump voxels apart along the line. The lanes are solved together 
+// in the double work space (lanes*length), so the elimination vectorizes across lanes. 
+static void solve_variable_coefficient_lines( Density_Storage& S , int q , long base , int lanes , long jump , int length , 
+	const double* lower , const double* inverse_pivot , double* work )
+{
+	density_type* x = &( S.value(0,q) ); 
+	long vs = S.voxel_stride(); 
 	
-		M.diffusion_solver_setup_done = true; 
+	for( int p=0; p < length ; p++ )
+	{
+		long n = base + p*jump; 
+		for( int i=0; i < lanes ; i++ )
+		{ work[p*lanes+i] = x[ (n+i)*vs ]; }
 	}
 	
-	if( M.mesh.uniform_mesh == false )
+	// forward elimination 
+	for( int i=0; i < lanes ; i++ )
+	{ work[i] *= inverse_pivot[base+i]; }
+	for( int p=1; p < length ; p++ )
 	{
-		cout << "Error: This algorithm is written for uniform Cartesian meshes. Try: something else" << endl << endl; 
-		return; 
+		long n = base + p*jump; 
+		double* w = work + p*lanes; 
+		const double* w_previous = w - lanes; 
+		#pragma omp simd 
+		for( int i=0; i < lanes ; i++ )
+		{ w[i] = ( w[i] - lower[n+i] * w_previous[i] ) * inverse_pivot[n+i]; }
 	}
-
-	// double buffering to reduce memory copy / allocation overhead 
-
-	static vector< vector<double> >* pNew = &(M.temporary_density_vectors1);
-	static vector< vector<double> >* pOld = &(M.temporary_density_vectors2);
-
-	// swap the buffers 
-
-	vector< vector<double> >* pTemp = pNew; 
-	pNew = pOld; 
-	pOld = pTemp; 
-	M.p_density_vectors = pNew; 
-
-	static bool reaction_diffusion_shortcuts_are_set = false; 
-
-	static vector<double> constant1 = (1.0 / ( M.mesh.dx * M.mesh.dx )) * M.diffusion_coefficients; 
-	static vector<double> constant2 = dt * constant1; 
-	static vector<double> constant3 = M.one + dt * M.decay_rates;
-
-	static vector<double> constant4 = M.one - dt * M.decay_rates;
-
-	#pragma omp parallel for
-	for( int i=0; i < (*(M.p_density_vectors)).size() ; i++ )
+	
+	// back substitution 
+	for( int p=length-2; p >= 0 ; p-- )
 	{
-		int number_of_neighbors = M.mesh.connected_voxel_indices[i].size(); 
-
-		double d1 = -1.0 * number_of_neighbors; 
-
-		(*pNew)[i] = (*pOld)[i];  
-		(*pNew)[i] *= constant4; 
+		long n = base + p*jump; 
+		double* w = work + p*lanes; 
+		const double* w_next = w + lanes; 
+		#pragma omp simd 
+		for( int i=0; i < lanes ; i++ )
+		{ w[i] -= lower[n+jump+i] * inverse_pivot[n+i] * w_next[i]; }
+	}
+	
+	for( int p=0; p < length ; p++ )
+	{
+		long n = base + p*jump; 
+		for( int i=0; i < lanes ; i++ )
+		{ x[ (n+i)*vs ] = work[p*lanes+i]; }
+	}
+	return; 
+}
 
-		for( int j=0; j < number_of_neighbors ; j++ )
+// variable-coefficient LOD on a Cartesian mesh: x-, y- and (if dimensions = 3) z-sweeps of 
+// the active substrates of S, each with its own time step 
+static void variable_coefficients_LOD( Microenvironment& M , Density_Storage& S , const std::vector<int>& active , 
+	const std::vector<double>& substrate_dt , int dimensions , 
+	std::vector< std::vector<double> >& D , std::vector< std::vector<double> >& lambda , 
+	std::vector< std::vector<double> >& lower , std::vector< std::vector<double> >& inverse_pivot , 
+	std::vector<double>& factorization_dt ) 
+{
+	int nx = M.mesh.x_coordinates.size(); 
+	int ny = M.mesh.y_coordinates.size(); 
+	int nz = M.mesh.z_coordinates.size(); 
+	long nv = M.number_of_voxels(); 
+	double h [3] = { M.mesh.dx , M.mesh.dy , M.mesh.dz }; 
+	
+	// rebuild the stale factorizations (new fields, or a new time step) 
+	
+	for( int m=0; m < active.size() ; m++ )
+	{
+		int q = active[m]; 
+		if( factorization_dt[q] == substrate_dt[q] )
+		{ continue; }
+		
+		lower[q].resize( dimensions*nv ); 
+		inverse_pivot[q].resize( dimensions*nv ); 
+		for( int axis=0; axis < dimensions ; axis++ )
 		{
-			axpy( &(*pNew)[i], constant2, (*pOld)[  M.mesh.connected_voxel_indices[i][j] ] ); 
+			factorize_variable_coefficient_lines( M.mesh , D[q] , lambda[q] , axis , 
+				substrate_dt[q] / ( h[axis]*h[axis] ) , substrate_dt[q] / (double) dimensions , 
+				lower[q].data() + axis*nv , inverse_pivot[q].data() + axis*nv ); 
 		}
-		vector<double> temp = constant2; 
-		temp *= d1; 
-		axpy( &(*pNew)[i] , temp , (*pOld)[i] ); 
+		factorization_dt[q] = substrate_dt[q]; 
 	}
 	
-	// reset gradient vectors 
-//	M.reset_all_gradient_vectors(); 
+	int max_length = ny > nz ? ny : nz; 
+	
+	// x-diffusion 
+	
+	M.apply_dirichlet_conditions(); 
+	#pragma omp parallel 
+	{
+		std::vector<double> work( nx ); 
+		#pragma omp for collapse(2) 
+		for( int k=0; k < nz ; k++ )
+		{
+			for( int j=0; j < ny ; j++ )
+			{
+				for( int m=0; m < active.size() ; m++ )
+				{
+					int q = active[m]; 
+					solve_variable_coefficient_lines( S , q , M.voxel_index(0,j,k) , 1 , 1 , nx , 
+						lower[q].data() , inverse_pivot[q].data() , work.data() ); 
+				}
+			}
+		}
+	}
+	
+	// y-diffusion: all lines starting in an x-row at once 
+	
+	M.apply_dirichlet_conditions(); 
+	#pragma omp parallel 
+	{
+		std::vector<double> work( (long) nx*max_length ); 
+		#pragma omp for 
+		for( int k=0; k < nz ; k++ )
+		{
+			for( int m=0; m < active.size() ; m++ )
+			{
+				int q = active[m]; 
+				solve_variable_coefficient_lines( S , q , M.voxel_index(0,0,k) , nx , nx , ny , 
+					lower[q].data() + nv , inverse_pivot[q].data() + nv , work.data() ); 
+			}
+		}
+	}
+	
+	// z-diffusion 
+	
+	if( dimensions == 3 )
+	{
+		M.apply_dirichlet_conditions(); 
+		#pragma omp parallel 
+		{
+			std::vector<double> work( (long) nx*max_length ); 
+			#pragma omp for 
+			for( int j=0; j < ny ; j++ )
+			{
+				for( int m=0; m < active.size() ; m++ )
+				{
+					int q = active[m]; 
+					solve_variable_coefficient_lines( S , q , M.voxel_index(0,j,0) , nx , (long) nx*ny , nz , 
+						lower[q].data() + 2*nv , inverse_pivot[q].data() + 2*nv , work.data() ); 
+				}
+			}
+		}
+	}
+	
+	M.apply_dirichlet_conditions(); 
+	return; 
+}
+
+void diffusion_decay_solver__variable_coefficients_LOD_3D( Microenvironment& M, double dt )
+{
+	if( M.mesh.Cartesian_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for Cartesian meshes. Try: other solvers!" << std::endl << std::endl; 
+		return; 
+	}
+	
+	if( !M.diffusion_solver_setup_done )
+	{
+		std::cout << std::endl << "Using method " << __FUNCTION__ << " (implicit 3-D LOD with Thomas Algorithm, per-voxel D and lambda) ... " 
+		<< std::endl << std::endl;  
+		M.diffusion_solver_setup_done = true; 
+	}
+	
+	// cell secretion / uptake 
+	if( M.fused_cell_sources_and_sinks )
+	{ M.simulate_binned_cell_sources_and_sinks( dt ); }
+	
+	M.update_voxel_coefficient_fields(); 
+	variable_coefficients_LOD( M , *M.p_density_storage , M.active_substrates , M.substrate_time_steps( dt ) , 3 , 
+		M.voxel_diffusion_coefficients , M.voxel_decay_rates , 
+		M.variable_lod_lower , M.variable_lod_inverse_pivot , M.variable_lod_factorization_dt ); 
+	return; 
+}
 
+void diffusion_decay_solver__variable_coefficients_LOD_2D( Microenvironment& M, double dt )
+{
+	if( M.mesh.Cartesian_mesh == false )
+	{
+		std::cout << "Error: This algorithm is written for Cartesian meshes. Try: other solvers!" << std::endl << std::endl; 
+		return; 
+	}
+	
+	if( !M.diffusion_solver_setup_done )
+	{
+		std::cout << std::endl << "Using method " << __FUNCTION__ << " (2D LOD with Thomas Algorithm, per-voxel D and lambda) ... " 
+		<< std::endl << std::endl;  
+		M.diffusion_solver_setup_done = true; 
+	}
+	
+	// cell secretion / uptake 
+	if( M.fused_cell_sources_and_sinks )
+	{ M.simulate_binned_cell_sources_and_sinks( dt ); }
+	
+	M.update_voxel_coefficient_fields(); 
+	variable_coefficients_LOD( M , *M.p_density_storage , M.active_substrates , M.substrate_time_steps( dt ) , 2 , 
+		M.voxel_diffusion_coefficients , M.voxel_decay_rates , 
+		M.variable_lod_lower , M.variable_lod_inverse_pivot , M.variable_lod_factorization_dt ); 
+	return; 
+}
+
+void diffusion_decay_explicit_uniform_rates( Microenvironment& M, double dt )
+{
+	// kept for existing code: this is the general-mesh explicit method 
+	diffusion_decay_solver__constant_coefficients_explicit( M , dt ); 
 	return; 
 }
 
@@ -54,20 +54,51 @@
 namespace BioFVM{
 // /*! diffusion-decay solvers for the equation du/dt = D*Laplacian(u) - lambda*u - U(x)*u + M(X)*(uT-u) */ 
 
+// /*! Thomas algorithm on one line of voxels, directly on the density buffer (used by the LOD solvers). 
+//     Only the listed substrates are solved. With single-precision densities, the line is solved in the 
+//     double work space scratch (else unused). */ 
+void thomas_solve_line( density_type* line , int jump , int ss , int length , 
+	const std::vector<double>& constant1 , 
+	const std::vector< std::vector<double> >& denom , 
+	const std::vector< std::vector<double> >& c , double* scratch , const std::vector<int>& substrates ); 
+
+// /*! expand per-substrate Thomas coefficients [position][substrate] to one entry per lane of an x-row [position][lane] */ 
+void expand_thomas_coefficients_to_lanes( const std::vector< std::vector<double> >& coefficients , 
+	int nx , int layout , aligned_vector& lanes ); 
+
+// /*! Thomas algorithm on all lines that start in voxels i_start to i_end-1 of a row of nx consecutive voxels, using the batched (SIMD) kernel. 
+//     Solves the listed substrates (substrate-major layout) or all substrates (voxel-major layout). */ 
+void thomas_solve_rows( batched_thomas_kernel kernel , Density_Storage& D , density_type* row , long step , int nx , 
+	int i_start , int i_end , int length , 
+	const aligned_vector& constant1 , const aligned_vector& denom , const aligned_vector& c , double* scratch , 
+	const std::vector<int>& substrates ); 
+
+// /*! size (in doubles) of the per-thread work space that the Thomas solves need for single-precision densities */ 
+long thomas_scratch_size( int max_length , int max_line_width ); 
+
 // /*! diffusion-decay solver: 3D LOD implicit (stable method). D and r uniform */  
 void diffusion_decay_solver__constant_coefficients_LOD_3D( Microenvironment& M, double dt ); // done
 // /*! diffusion-decay solver: 2D LOD implicit (stable method). D and r uniform */  
 void diffusion_decay_solver__constant_coefficients_LOD_2D( Microenvironment& M, double dt ); // done
 
+// /*! diffusion-decay solvers: 3D and 2D LOD implicit with per-voxel D and lambda (see 
+//     Microenvironment::set_voxel_diffusion_coefficient and set_voxel_decay_rate). Cartesian mesh. */ 
+void diffusion_decay_solver__variable_coefficients_LOD_3D( Microenvironment& M, double dt ); 
+void diffusion_decay_solver__variable_coefficients_LOD_2D( Microenvironment& M, double dt ); 
+
 /*! This solves for constant diffusion coefficients on a general mesh using the 
     explicit stepping for the diffusion operator, and implicit stepping for all 
-    other terms to increase stability. It is suitable for a general mesh. */ 
-
-// /*! diffusion-decay solver: 3D explicit method -- suitable to a general mesh if necessary */  
-void diffusion_decay_explicit_uniform_rates( Microenvironment& M , double dt );  // it exists 
+    other terms to increase stability. It is suitable for a general mesh. Both explicit 
+    solvers sub-step as needed to satisfy the stability (CFL) limit, and alternate 
+    between the two density buffers. */ 
 
+// /*! diffusion-decay solver: explicit method on a general mesh (fluxes along mesh.connected_voxel_indices) */ 
 void diffusion_decay_solver__constant_coefficients_explicit( Microenvironment& M, double dt ); 
+// /*! diffusion-decay solver: explicit 7-point stencil on a Cartesian mesh (3D, or 2D when nz = 1) */ 
 void diffusion_decay_solver__constant_coefficients_explicit_uniform_mesh( Microenvironment& M, double dt ); 
+
+// /*! same as diffusion_decay_solver__constant_coefficients_explicit (kept for existing code) */  
+void diffusion_decay_explicit_uniform_rates( Microenvironment& M , double dt ); 
 };
 
 #endif 
\ No newline at end of file
@@ -49,6 +49,10 @@
 #include "BioFVM.h"
 #include "BioFVM_utilities.h"
 
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
 namespace BioFVM{
 /*
 std::string BioFVM_Version; 
@@ -79,15 +83,13 @@ void RUNTIME_TOC(void)
 
 double stopwatch_value(void)
 {
-	static std::chrono::duration<double> time_span; 
-	time_span = std::chrono::duration_cast<std::chrono::duration<double>>(toc_time-tic_time);
+	std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double>>(toc_time-tic_time);
 	return time_span.count(); 
 }
 
 double runtime_stopwatch_value(void)
 {
-	static std::chrono::duration<double> time_span; 
-	time_span = std::chrono::duration_cast<std::chrono::duration<double>>(program_toc_time-program_tic_time);
+	std::chrono::duration<double> time_span = std::chrono::duration_cast<std::chrono::duration<double>>(program_toc_time-program_tic_time);
 	return time_span.count(); 
 }
 
@@ -140,10 +142,23 @@ double uniform_random( void )
 	return distribution(biofvm_PRNG_generator); 
 }
 
+std::string get_random_state( void )
+{
+	std::ostringstream state; 
+	state << biofvm_PRNG_generator; 
+	return state.str(); 
+}
+
+bool set_random_state( std::string state )
+{
+	std::istringstream input( state ); 
+	input >> biofvm_PRNG_generator; 
+	return !input.fail(); 
+}
+
 double compute_mean( std::vector<double>& values )
 {
-	static double sum; 
-	sum = 0.0; 
+	double sum = 0.0; 
 	for( int i=0; i < values.size(); i++ )
 	{ sum += values[i]; }
 	sum /= (double) values.size(); 
@@ -152,18 +167,15 @@ double compute_mean( std::vector<double>& values )
 
 double compute_variance( std::vector<double>& values, double mean )
 {
-	static double output; 
-	output = 0.0; 
+	double output = 0.0; 
 	for( int i=0; i < values.size() ; i++ )
 	{
-		static double temp; 
-		temp = values[i]; 
+		double temp = values[i]; 
 		temp -= mean; 
 		temp *= temp; 
 		output += temp; 	
 	}
-	static int n; 
-	n = values.size(); 
+	int n = values.size(); 
 	n--; 
 	output /= (double) n; 
 	return output; 
@@ -174,4 +186,161 @@ double compute_variance( std::vector<double>& values )
 	return compute_variance( values , mean ); 
 }	
 
+Snapshot_Buffer::Snapshot_Buffer()
+{
+	read_position = 0; 
+	read_failed = false; 
+	return; 
+}
+
+void Snapshot_Buffer::clear( void )
+{
+	bytes.clear(); 
+	read_position = 0; 
+	read_failed = false; 
+	return; 
+}
+
+void Snapshot_Buffer::write( const void* source , size_t size )
+{
+	const char* pSource = (const char*) source; 
+	bytes.insert( bytes.end() , pSource , pSource + size ); 
+	return; 
+}
+
+bool Snapshot_Buffer::read( void* destination , size_t size )
+{
+	if( read_failed || size > bytes.size() - read_position )
+	{
+		read_failed = true; 
+		return false; 
+	}
+	memcpy( destination , bytes.data() + read_position , size ); 
+	read_position += size; 
+	return true; 
+}
+
+void Snapshot_Buffer::write_vector( const std::vector<double>& values )
+{
+	write_value( (unsigned long long) values.size() ); 
+	write( values.data() , values.size()*sizeof(double) ); 
+	return; 
+}
+
+bool Snapshot_Buffer::read_vector( std::vector<double>& values )
+{
+	unsigned long long size = 0; 
+	if( !read_value( size ) || size > ( bytes.size() - read_position ) / sizeof(double) )
+	{
+		read_failed = true; 
+		return false; 
+	}
+	values.resize( size ); 
+	return read( values.data() , size*sizeof(double) ); 
+}
+
+void Snapshot_Buffer::write_vector( const std::vector<int>& values )
+{
+	write_value( (unsigned long long) values.size() ); 
+	write( values.data() , values.size()*sizeof(int) ); 
+	return; 
+}
+
+bool Snapshot_Buffer::read_vector( std::vector<int>& values )
+{
+	unsigned long long size = 0; 
+	if( !read_value( size ) || size > ( bytes.size() - read_position ) / sizeof(int) )
+	{
+		read_failed = true; 
+		return false; 
+	}
+	values.resize( size ); 
+	return read( values.data() , size*sizeof(int) ); 
+}
+
+void Snapshot_Buffer::write_vector( const Vec3& values )
+{
+	write_value( (unsigned long long) 3 ); 
+	write( values.data() , 3*sizeof(double) ); 
+	return; 
+}
+
+bool Snapshot_Buffer::read_vector( Vec3& values )
+{
+	unsigned long long size = 0; 
+	if( !read_value( size ) || size != 3 )
+	{
+		read_failed = true; 
+		return false; 
+	}
+	return read( values.data() , 3*sizeof(double) ); 
+}
+
+void Snapshot_Buffer::write_string( const std::string& value )
+{
+	write_value( (unsigned long long) value.size() ); 
+	write( value.data() , value.size() ); 
+	return; 
+}
+
+bool Snapshot_Buffer::read_string( std::string& value )
+{
+	unsigned long long size = 0; 
+	if( !read_value( size ) || size > bytes.size() - read_position )
+	{
+		read_failed = true; 
+		return false; 
+	}
+	value.assign( bytes.data() + read_position , size ); 
+	read_position += size; 
+	return true; 
+}
+
+bool Snapshot_Buffer::write_to_file( std::string filename )
+{
+	FILE* fp = fopen( filename.c_str() , "wb" ); 
+	if( fp == NULL )
+	{
+		std::cout << "Error: could not open " << filename << " for writing" << std::endl; 
+		return false; 
+	}
+	// one sequential write of the whole snapshot 
+	size_t written = fwrite( bytes.data() , 1 , bytes.size() , fp ); 
+	bool success = ( written == bytes.size() ); 
+	if( fclose( fp ) != 0 )
+	{ success = false; }
+	if( !success )
+	{ std::cout << "Error: could not write " << filename << std::endl; }
+	return success; 
+}
+
+bool Snapshot_Buffer::read_from_file( std::string filename )
+{
+	clear(); 
+	FILE* fp = fopen( filename.c_str() , "rb" ); 
+	if( fp == NULL )
+	{
+		std::cout << "Error: could not open " << filename << " for reading" << std::endl; 
+		return false; 
+	}
+	fseek( fp , 0 , SEEK_END ); 
+	long size = ftell( fp ); 
+	fseek( fp , 0 , SEEK_SET ); 
+	if( size < 0 )
+	{
+		fclose( fp ); 
+		return false; 
+	}
+	bytes.resize( size ); 
+	size_t bytes_read = fread( bytes.data() , 1 , size , fp ); 
+	fclose( fp ); 
+	if( bytes_read != (size_t) size )
+	{
+		std::cout << "Error: could not read " << filename << std::endl; 
+		clear(); 
+		return false; 
+	}
+	return true; 
+}
+
 };
\ No newline at end of file
@@ -55,6 +55,9 @@
 #include <string>
 #include <chrono>
 #include <random>
+#include <vector>
+
+#include "BioFVM_vector.h"
 
 namespace BioFVM{
 
@@ -77,9 +80,49 @@ void seed_random( unsigned int );
 void seed_random( void ); 
 double uniform_random( void );
 
+// the generator state, as text (for snapshots) 
+std::string get_random_state( void ); 
+bool set_random_state( std::string state ); 
+
 double compute_mean( std::vector<double>& values );
 double compute_variance( std::vector<double>& values, double mean ); 
 double compute_variance( std::vector<double>& values ); 
+
+/*! A byte buffer for binary snapshots of simulation state. Values are appended 
+    with the write functions and read back, in the same order, with the read 
+    functions. A read past the end (or of a malformed length) sets read_failed 
+    and leaves the destination unchanged, so a reader can check once at the end. */ 
+class Snapshot_Buffer
+{
+ public:
+	std::vector<char> bytes; 
+	size_t read_position; 
+	bool read_failed; 
+	
+	Snapshot_Buffer(); 
+	
+	void clear( void ); 
+	
+	void write( const void* source , size_t size ); 
+	bool read( void* destination , size_t size ); 
+	
+	template <class T> void write_value( const T& value ) 
+	{ write( &value , sizeof(T) ); }
+	template <class T> bool read_value( T& value ) 
+	{ return read( &value , sizeof(T) ); }
+	
+	void write_vector( const std::vector<double>& values ); 
+	bool read_vector( std::vector<double>& values ); 
+	void write_vector( const std::vector<int>& values ); 
+	bool read_vector( std::vector<int>& values ); 
+	void write_vector( const Vec3& values ); // same layout as a 3-entry std::vector<double> 
+	bool read_vector( Vec3& values ); 
+	void write_string( const std::string& value ); 
+	bool read_string( std::string& value ); 
+	
+	bool write_to_file( std::string filename ); 
+	bool read_from_file( std::string filename ); 
+};
 	
 };
  
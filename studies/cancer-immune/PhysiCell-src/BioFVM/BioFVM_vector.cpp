@@ -452,4 +452,216 @@ void vector3_to_list( const std::vector<double>& vect , char*& buffer , char del
 	return; 
 }
 
+/* fixed-size 3-vectors */ 
+
+Vec3::Vec3( const std::vector<double>& v )
+{ *this = v; }
+
+Vec3& Vec3::operator=( const std::vector<double>& v )
+{
+ for( int i=0; i < 3 ; i++ )
+ { values[i] = ( i < v.size() ) ? v[i] : 0.0; }
+ return *this; 
+}
+
+std::vector<double> Vec3::to_vector( void ) const
+{ return std::vector<double>( values , values+3 ); }
+
+void Vec3::assign( int n , double value )
+{
+ if( n != 3 )
+ { std::cout << "Warning: Vec3::assign( " << n << " , value ) sets all 3 components." << std::endl; }
+ for( int i=0; i < 3 ; i++ )
+ { values[i] = value; }
+ return; 
+}
+
+Vec3 operator-( const Vec3& v1 , const Vec3& v2 )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] -= v2[i]; }
+ return v; 
+}
+
+Vec3 operator+( const Vec3& v1 , const Vec3& v2 )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] += v2[i]; }
+ return v; 
+}
+
+Vec3 operator*( const Vec3& v1 , const Vec3& v2 )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] *= v2[i]; }
+ return v; 
+}
+
+Vec3 operator/( const Vec3& v1 , const Vec3& v2 )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] /= v2[i]; }
+ return v; 
+}
+
+Vec3 operator*( double d , const Vec3& v1 )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] *= d; }
+ return v; 
+}
+
+Vec3 operator+( double d , const Vec3& v1 )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] += d; }
+ return v; 
+}
+
+Vec3 operator+( const Vec3& v1 , double d )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] += d; }
+ return v; 
+}
+
+Vec3 operator-( double d , const Vec3& v1 )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] = d - v1[i]; }
+ return v; 
+}
+
+Vec3 operator-( const Vec3& v1 , double d  )
+{
+ Vec3 v = v1;
+ for( int i=0; i < 3 ; i++ )
+ { v[i] -= d; }
+ return v; 
+}
+
+void operator+=( Vec3& v1, const Vec3& v2 )
+{
+ for( int i=0; i < 3 ; i++ )
+ { v1[i] += v2[i]; }
+ return; 
+}
+
+void operator-=( Vec3& v1, const Vec3& v2 )
+{
+ for( int i=0; i < 3 ; i++ )
+ { v1[i] -= v2[i]; }
+ return; 
+}
+
+void operator/=( Vec3& v1, const Vec3& v2 )
+{
+ for( int i=0; i < 3 ; i++ )
+ { v1[i] /= v2[i]; }
+ return;  
+} 
+
+void operator*=( Vec3& v1, const double& a )
+{
+ for( int i=0; i < 3 ; i++ )
+ { v1[i] *= a; }
+ return; 
+}
+
+void operator*=( Vec3& v1, const Vec3& v2 )
+{
+ for( int i=0; i < 3 ; i++ )
+ { v1[i] *= v2[i]; }
+ return;  
+}
+
+void operator/=( Vec3& v1, const double& a )
+{
+ for( int i=0; i < 3 ; i++ )
+ { v1[i] /= a; }
+ return;  
+}
+
+std::ostream& operator<<(std::ostream& os, const Vec3& v )
+{
+ os << "x=\"" << v[0] << "\" y=\"" << v[1] << "\" z=\"" << v[2] << "\"" ; 
+ return os; 
+}
+
+Vec3 normalize( const Vec3& v )
+{
+ Vec3 output = v ;
+
+ double norm = 0.0; 
+ for( int i=0; i < 3; i++ )
+ { norm += ( v[i]*v[i] ); }
+ norm = sqrt( norm ); 
+
+ for( int i=0; i < 3; i++ )
+ { output[i] /= norm ; }
+ return output; 
+}
+
+void normalize( Vec3* v )
+{
+ double norm = 1e-32; 
+
+ for( int i=0; i < 3; i++ )
+ { norm += ( (*v)[i] * (*v)[i] ); }
+ norm = sqrt( norm ); 
+
+ for( int i=0; i < 3; i++ )
+ { (*v)[i] /=  norm ; }
+ return; 
+}
+
+double norm_squared( const Vec3& v )
+{
+ double out = 0.0; 
+ for( int i=0 ; i < 3 ; i++ )
+ { out += ( v[i] * v[i] ); }
+ return out; 
+}
+
+double norm( const Vec3& v )
+{
+ return sqrt( norm_squared( v ) ); 
+}
+
+void axpy( Vec3* y, const double& a , const Vec3& x )
+{
+ for( int i=0; i < 3 ; i++ )
+ { (*y)[i] += a * x[i] ; }
+ return ; 
+}
+
+void axpy( Vec3* y, const Vec3& a , const Vec3& x )
+{
+ for( int i=0; i < 3 ; i++ )
+ { (*y)[i] += a[i] * x[i] ; }
+ return; 
+}
+
+void naxpy( Vec3* y, const double& a , const Vec3& x )
+{
+ for( int i=0; i < 3 ; i++ )
+ { (*y)[i] -= a * x[i] ; }
+ return ; 
+}
+
+void naxpy( Vec3* y, const Vec3& a , const Vec3& x )
+{
+ for( int i=0; i < 3 ; i++ )
+ { (*y)[i] -= a[i] * x[i] ; }
+ return; 
+}
+
 };
@@ -139,6 +139,74 @@ void vector_to_list( const std::vector<double>& vect , char*& buffer , char deli
 
 void vector3_to_list( const std::vector<double>& vect , char*& buffer , char delim ); 
 
+/* a fixed-size 3-vector for positions, velocities, motility vectors, and gradients. 
+   It is trivially copyable and never touches the heap, so temporaries like 
+   "displacement = a - b" cost no allocations. It supports the same operators and 
+   BLAS-type functions as std::vector<double> above. */ 
+
+class Vec3
+{
+ public:
+	double values[3]; 
+
+	Vec3() { values[0] = 0.0; values[1] = 0.0; values[2] = 0.0; }
+	Vec3( double x , double y , double z ) { values[0] = x; values[1] = y; values[2] = z; }
+	// copies the first three entries (missing entries are zero) 
+	explicit Vec3( const std::vector<double>& v ); 
+	
+	Vec3& operator=( const std::vector<double>& v ); 
+	std::vector<double> to_vector( void ) const; 
+	
+	double& operator[]( int i ) { return values[i]; }
+	const double& operator[]( int i ) const { return values[i]; }
+	
+	int size( void ) const { return 3; }
+	double* data( void ) { return values; }
+	const double* data( void ) const { return values; }
+	double* begin( void ) { return values; }
+	double* end( void ) { return values+3; }
+	const double* begin( void ) const { return values; }
+	const double* end( void ) const { return values+3; }
+	
+	// for code written against std::vector<double>: n must be 3 
+	void assign( int n , double value ); 
+}; 
+
+Vec3 operator-( const Vec3& v1 , const Vec3& v2 );
+Vec3 operator+( const Vec3& v1 , const Vec3& v2 );
+Vec3 operator*( const Vec3& v1 , const Vec3& v2 );
+Vec3 operator/( const Vec3& v1 , const Vec3& v2 );
+
+Vec3 operator*( double d , const Vec3& v1 );
+Vec3 operator+( double d , const Vec3& v1 ); 
+Vec3 operator+( const Vec3& v1 , double d );
+Vec3 operator-( double d , const Vec3& v1 );
+Vec3 operator-( const Vec3& v1 , double d  ); 
+
+void operator+=( Vec3& v1, const Vec3& v2 ); 
+void operator-=( Vec3& v1, const Vec3& v2 ); 
+void operator/=( Vec3& v1, const Vec3& v2 ); 
+void operator*=( Vec3& v1, const double& a );
+void operator*=( Vec3& v1, const Vec3& v2 ); 
+void operator/=( Vec3& v1, const double& a );
+
+std::ostream& operator<<(std::ostream& os, const Vec3& v ); 
+
+Vec3 normalize( const Vec3& v );
+void normalize( Vec3* v ); 
+
+double norm_squared( const Vec3& v ); 
+double norm( const Vec3& v ); 
+
+// y = y + a*x 
+void axpy( Vec3* y, const double& a , const Vec3& x );
+// y = y + a.*x
+void axpy( Vec3* y, const Vec3& a , const Vec3& x ); 
+// y = y - a*x 
+void naxpy( Vec3* y, const double& a , const Vec3& x );
+// y = y - a.*x
+void naxpy( Vec3* y, const Vec3& a , const Vec3& x ); 
+
 };
 
 #endif
@@ -68,6 +68,7 @@
 #include "PhysiCell_constants.h"
 #include "../BioFVM/BioFVM_vector.h" 
 #include<limits.h>
+#include <new>
 
 namespace PhysiCell{
 
@@ -144,7 +145,7 @@ void Cell::update_motility_vector( double dt_ )
 {
 	if( phenotype.motility.is_motile == false )
 	{
-		phenotype.motility.motility_vector.assign( 3, 0.0 ); 
+		phenotype.motility.motility_vector = Vec3(); 
 		return; 
 	}
 	
@@ -163,8 +164,7 @@ void Cell::update_motility_vector( double dt_ )
 			cos_phi = 0.0;
 		}
 		
-		std::vector<double> randvec; 
-		randvec.resize(3,sin_phi); 
+		Vec3 randvec( sin_phi , sin_phi , sin_phi ); 
 		
 		randvec[0] *= cos( temp_angle ); // cos(theta)*sin(phi)
 		randvec[1] *= sin( temp_angle ); // sin(theta)*sin(phi)
@@ -219,7 +219,7 @@ void Cell::advance_bundled_phenotype_functions( double dt_ )
 		// also, turn off motility.
 		
 		phenotype.motility.is_motile = false; 
-		phenotype.motility.motility_vector.assign( 3, 0.0 ); 
+		phenotype.motility.motility_vector = Vec3(); 
 		functions.update_migration_bias = NULL;
 		
 		// turn off secretion, and reduce uptake by a factor of 10 
@@ -268,7 +268,7 @@ Cell::Cell()
 	
 	is_movable = true;
 	is_out_of_domain = false;
-	displacement.resize(3,0.0); // state? 
+	displacement = Vec3(); // state? 
 	
 	assign_orientation();
 	container = NULL;
@@ -276,6 +276,9 @@ Cell::Cell()
 	return; 
 }
 
+Cell::~Cell()
+{ return; }
+
 void Cell::flag_for_division( void )
 {
 	get_container()->flag_cell_for_division( this );
@@ -301,7 +304,7 @@ void Cell::start_death( int death_model_index )
 		
 	// turn off motility.
 	phenotype.motility.is_motile = false; 
-	phenotype.motility.motility_vector.assign( 3, 0.0 ); 
+	phenotype.motility.motility_vector = Vec3(); 
 	functions.update_migration_bias = NULL;
 		
 	// make sure to run the death entry function 
@@ -340,9 +343,6 @@ Cell* Cell::divide( )
 	// phenotype.flagged_for_removal = false; 
 	
 	Cell* child = create_cell();
-	child->copy_data( this );	
-	child->copy_function_pointers(this);
-	child->parameters = parameters;
 	
 	// The following is already performed by create_cell(). JULY 2017 ***
 	// child->register_microenvironment( get_microenvironment() );
@@ -353,14 +353,29 @@ Cell* Cell::divide( )
 	double temp_angle = 6.28318530717959*UniformRandom();
 	double temp_phi = 3.1415926535897932384626433832795*UniformRandom();
 	
+	prepare_daughter_cell( child , temp_angle , temp_phi ); 
+	register_daughter_cell( child ); 
+	
+	// child->set_phenotype( phenotype ); 
+	child->phenotype = phenotype; 
+	
+	return child;
+}
+
+void Cell::prepare_daughter_cell( Cell* child , double temp_angle , double temp_phi )
+{
+	child->copy_data( this );	
+	child->copy_function_pointers(this);
+	child->parameters = parameters;
+	
 	double radius= phenotype.geometry.radius;
-	std::vector<double> rand_vec (3, 0.0);
+	Vec3 rand_vec;
 	
 	rand_vec[0]= cos( temp_angle ) * sin( temp_phi );
 	rand_vec[1]= sin( temp_angle ) * sin( temp_phi );
 	rand_vec[2]= cos( temp_phi );
 	rand_vec = rand_vec- phenotype.geometry.polarity*(rand_vec[0]*state.orientation[0]+ 
-		rand_vec[1]*state.orientation[1]+rand_vec[2]*state.orientation[2])*state.orientation;
+		rand_vec[1]*state.orientation[1]+rand_vec[2]*state.orientation[2])*Vec3( state.orientation );
 	
 	if( norm(rand_vec) < 1e-16 )
 	{
@@ -368,7 +383,7 @@ Cell* Cell::divide( )
 	}
 	normalize( &rand_vec ); 
 	// rand_vec/= norm(rand_vec);
-	child->assign_position(position[0] + 0.5 * radius*rand_vec[0],
+	child->place_at(position[0] + 0.5 * radius*rand_vec[0],
 						 position[1] + 0.5 * radius*rand_vec[1],
 						 position[2] + 0.5 * radius*rand_vec[2]);
 	//change my position to keep the center of mass intact and then see if I need to update my voxel index
@@ -377,17 +392,21 @@ Cell* Cell::divide( )
 	// position[0] -= 0.5*radius*rand_vec[0];
 	// position[1] -= 0.5*radius*rand_vec[1]; 
 	// position[2] -= 0.5*radius*rand_vec[2]; 
+	return; 
+}
+
+void Cell::register_daughter_cell( Cell* child )
+{
+	// place_at() leaves a daughter outside the domain unregistered 
+	if( child->is_out_of_domain == false )
+	{ get_container()->register_agent( child ); }
 	 
 	update_voxel_in_container();
 	phenotype.volume.divide(); 
 	child->phenotype.volume.divide();
 	child->set_total_volume(child->phenotype.volume.total);
 	set_total_volume(phenotype.volume.total);
-	
-	// child->set_phenotype( phenotype ); 
-	child->phenotype = phenotype; 
-	
-	return child;
+	return; 
 }
 
 bool Cell::assign_position(std::vector<double> new_position)
@@ -405,6 +424,15 @@ void Cell::set_previous_velocity(double xV, double yV, double zV)
 }
 
 bool Cell::assign_position(double x, double y, double z)
+{
+	if( place_at( x, y, z ) == false )
+	{ return false; }
+	get_container()->register_agent(this);
+	
+	return true;
+}
+
+bool Cell::place_at(double x, double y, double z)
 {
 	if( !get_container()->underlying_mesh.is_position_valid(x,y,z) )
 	{	
@@ -422,7 +450,6 @@ bool Cell::assign_position(double x, double y, double z)
 	update_voxel_index();
 	// update current_mechanics_voxel_index
 	current_mechanics_voxel_index= get_container()->underlying_mesh.nearest_voxel_index( position );
-	get_container()->register_agent(this);
 	
 	return true;
 }
@@ -507,23 +534,13 @@ void Cell::update_position( double dt )
 	// Basic_Agent::update_position(dt);
 		
 	// use Adams-Bashforth 
-	static double d1; 
-	static double d2; 
-	static bool constants_defined = false; 
-	if( constants_defined == false )
-	{
-		d1 = dt; 
-		d1 *= 1.5; 
-		d2 = dt; 
-		d2 *= -0.5; 
-		constants_defined = true; 
-	}
+	double d1 = 1.5 * dt; 
+	double d2 = -0.5 * dt; 
 	
 	// new AUgust 2017
 	if( default_microenvironment_options.simulate_2D == true )
 	{ velocity[2] = 0.0; }
 	
-	std::vector<double> old_position(position); 
 	axpy( &position , d1 , velocity );  
 	axpy( &position , d2 , previous_velocity );  
 	// overwrite previous_velocity for future use 
@@ -533,6 +550,11 @@ void Cell::update_position( double dt )
 	previous_velocity = velocity; 
 	
 	velocity[0]=0; velocity[1]=0; velocity[2]=0;
+	
+	// keep the arena's copy current for the rest of the mechanics step 
+	if( index < get_container()->mechanics_arena.size() )
+	{ get_container()->mechanics_arena.store_kinematics( this ); }
+	
 	// #pragma omp critical
 	//{update_voxel_in_container();}
 	if(get_container()->underlying_mesh.is_position_valid(position[0],position[1],position[2]))
@@ -608,8 +630,8 @@ void Cell::copy_data(Cell* copy_me)
 	
 	velocity = copy_me->velocity; 
 	// expected_phenotype = copy_me-> expected_phenotype; //it is taken care in set_phenotype
-	cell_source_sink_solver_temp1 = std::vector<double>(copy_me->cell_source_sink_solver_temp1);
-	cell_source_sink_solver_temp2 = std::vector<double>(copy_me->cell_source_sink_solver_temp2);
+	cell_source_sink_coefficients = copy_me->cell_source_sink_coefficients; 
+	cell_source_sink_inputs = copy_me->cell_source_sink_inputs; 
 	
 	return; 
 }
@@ -622,17 +644,33 @@ void Cell::copy_function_pointers(Cell* copy_me)
 
 void Cell::add_potentials(Cell* other_agent)
 {
-	if( this->ID == other_agent->ID )
+	add_potentials( other_agent->index ); 
+	return; 
+}
+
+void Cell::add_potentials( int other_slot )
+{
+	// slots are unique, like IDs 
+	if( other_slot == index )
 	{ return; }
 
 	// 12 uniform neighbors at a close packing distance, after dividing out all constants
 	static double simple_pressure_scale = 0.027288820670331; // 12 * (1 - sqrt(pi/(2*sqrt(3))))^2 
 	// 9.820170012151277; // 12 * ( 1 - sqrt(2*pi/sqrt(3)))^2
 
+	// positions, radii and coefficients come from the contiguous mechanics arena, 
+	// which the container refreshes at the start of each mechanics step 
+	const Cell_Mechanics_Arena& arena = get_container()->mechanics_arena; 
+	int a = index; 
+	int b = other_slot; 
+
+	double my_position[3] = { arena.position[0][a] , arena.position[1][a] , arena.position[2][a] }; 
+	double other_position[3] = { arena.position[0][b] , arena.position[1][b] , arena.position[2][b] }; 
+
 	double distance = 0; 
 	for( int i = 0 ; i < 3 ; i++ ) 
 	{ 
-		displacement[i] = position[i] - (*other_agent).position[i]; 
+		displacement[i] = my_position[i] - other_position[i]; 
 		distance += displacement[i] * displacement[i]; 
 	}
 	// Make sure that the distance is not zero
@@ -640,9 +678,9 @@ void Cell::add_potentials(Cell* other_agent)
 	distance = std::max(sqrt(distance), 0.00001); 
 	
 	//Repulsive
-	double R = phenotype.geometry.radius+ (*other_agent).phenotype.geometry.radius; 
+	double R = arena.radius[a] + arena.radius[b]; 
 	
-	double RN = phenotype.geometry.nuclear_radius + (*other_agent).phenotype.geometry.nuclear_radius;	
+	double RN = arena.nuclear_radius[a] + arena.nuclear_radius[b];	
 	double temp_r, c;
 	if( distance > R ) 
 	{
@@ -669,7 +707,7 @@ void Cell::add_potentials(Cell* other_agent)
 	}
 	
 	// August 2017 - back to the original if both have same coefficient 
-	double effective_repulsion = sqrt( phenotype.mechanics.cell_cell_repulsion_strength * other_agent->phenotype.mechanics.cell_cell_repulsion_strength ); 
+	double effective_repulsion = sqrt( arena.cell_cell_repulsion_strength[a] * arena.cell_cell_repulsion_strength[b] ); 
 	temp_r *= effective_repulsion; 
 	
 	// temp_r *= phenotype.mechanics.cell_cell_repulsion_strength; // original 
@@ -679,8 +717,8 @@ void Cell::add_potentials(Cell* other_agent)
 	//double max_interactive_distance = parameters.max_interaction_distance_factor * phenotype.geometry.radius + 
 	//	(*other_agent).parameters.max_interaction_distance_factor * (*other_agent).phenotype.geometry.radius;
 		
-	double max_interactive_distance = phenotype.mechanics.relative_maximum_adhesion_distance * phenotype.geometry.radius + 
-		(*other_agent).phenotype.mechanics.relative_maximum_adhesion_distance * (*other_agent).phenotype.geometry.radius;
+	double max_interactive_distance = arena.relative_maximum_adhesion_distance[a] * arena.radius[a] + 
+		arena.relative_maximum_adhesion_distance[b] * arena.radius[b];
 		
 	if(distance < max_interactive_distance ) 
 	{	
@@ -692,7 +730,7 @@ void Cell::add_potentials(Cell* other_agent)
 		// temp_a *= phenotype.mechanics.cell_cell_adhesion_strength; // original 
 		
 		// August 2017 - back to the original if both have same coefficient 
-		double effective_adhesion = sqrt( phenotype.mechanics.cell_cell_adhesion_strength * other_agent->phenotype.mechanics.cell_cell_adhesion_strength ); 
+		double effective_adhesion = sqrt( arena.cell_cell_adhesion_strength[a] * arena.cell_cell_adhesion_strength[b] ); 
 		temp_a *= effective_adhesion; 
 		
 		temp_r -= temp_a;
@@ -710,10 +748,92 @@ void Cell::add_potentials(Cell* other_agent)
 	return;
 }
 
+int Cell::mechanics_slot( void ) const
+{ return index; }
+
+double& Cell::mechanics_position( int dimension )
+{ return get_container()->mechanics_arena.position[dimension][index]; }
+
+double& Cell::mechanics_velocity( int dimension )
+{ return get_container()->mechanics_arena.velocity[dimension][index]; }
+
+double& Cell::mechanics_previous_velocity( int dimension )
+{ return get_container()->mechanics_arena.previous_velocity[dimension][index]; }
+
+double& Cell::mechanics_radius( void )
+{ return get_container()->mechanics_arena.radius[index]; }
+
+Cell_Pool cell_pool; 
+
+Cell_Pool::Cell_Pool()
+{
+	cells_per_slab = 256; 
+	number_of_cells = 0; 
+	return; 
+}
+
+Cell_Pool::~Cell_Pool()
+{
+	// Live cells are not destroyed here; their slabs are freed as they are. So 
+	// destroy a pool only once nothing uses its cells (e.g., cell_pool at exit). 
+	for( int i=0; i < slabs.size(); i++ )
+	{ ::operator delete( slabs[i] ); }
+	slabs.clear(); 
+	free_slots.clear(); 
+	return; 
+}
+
+void Cell_Pool::add_slab( void )
+{
+	char* pSlab = (char*) ::operator new( cells_per_slab * sizeof(Cell) ); 
+	slabs.push_back( pSlab ); 
+	
+	// push in reverse, so that the slab is handed out front to back 
+	for( int i = cells_per_slab-1; i >= 0 ; i-- )
+	{ free_slots.push_back( (Cell*) ( pSlab + i*sizeof(Cell) ) ); }
+	return; 
+}
+
+Cell* Cell_Pool::create( void )
+{
+	if( free_slots.size() == 0 )
+	{ add_slab(); }
+	
+	void* pSlot = free_slots.back(); 
+	free_slots.pop_back(); 
+	number_of_cells++; 
+	
+	return new (pSlot) Cell; 
+}
+
+void Cell_Pool::destroy( Cell* pCell )
+{
+	if( pCell == NULL )
+	{ return; }
+	
+	pCell->~Cell(); 
+	free_slots.push_back( pCell ); 
+	number_of_cells--; 
+	return; 
+}
+
+void Cell_Pool::reserve( int number_of_slots )
+{
+	while( capacity() < number_of_slots )
+	{ add_slab(); }
+	return; 
+}
+
+int Cell_Pool::size( void ) const
+{ return number_of_cells; }
+
+int Cell_Pool::capacity( void ) const
+{ return slabs.size() * cells_per_slab; }
+
 Cell* create_cell( void )
 {
 	Cell* pNew; 
-	pNew = new Cell;		
+	pNew = cell_pool.create();		
 	(*all_cells).push_back( pNew ); 
 	pNew->index=(*all_cells).size()-1;
 	
@@ -723,6 +843,12 @@ Cell* create_cell( void )
 	{
 		pNew->register_microenvironment( BioFVM::get_default_microenvironment() );
 	}
+	
+	// keep the container's mechanics arena in step with all_cells (if it is; 
+	// otherwise the next gather() resizes it) 
+	if( BioFVM::get_default_microenvironment() && pNew->get_container() && 
+		pNew->get_container()->mechanics_arena.size() == pNew->index )
+	{ pNew->get_container()->mechanics_arena.add_slot(); }
 
 	// All the phenotype and other data structures are already set 
 	// by virtue of the default Cell constructor. 
@@ -747,7 +873,7 @@ Cell* create_cell( Cell_Definition& cd )
 	pNew->phenotype = cd.phenotype; 
 	pNew->is_movable = true;
 	pNew->is_out_of_domain = false;
-	pNew->displacement.resize(3,0.0); // state? 
+	pNew->displacement = Vec3(); // state? 
 	
 	pNew->assign_orientation();
 	
@@ -762,10 +888,12 @@ Cell* create_cell( Cell_Definition& cd )
 
 void delete_cell( int index )
 {
+	Cell* pDelete = (*all_cells)[index]; 
+	Cell_Mechanics_Arena& arena = pDelete->get_container()->mechanics_arena; 
+	bool arena_in_step = ( arena.size() == (*all_cells).size() ); 
+	
 	// deregister agent in from the agent container
-	(*all_cells)[index]->get_container()->remove_agent((*all_cells)[index]);
-	// de-allocate (delete) the cell; 
-	delete (*all_cells)[index]; 
+	pDelete->get_container()->remove_agent( pDelete );
 
 	// performance goal: don't delete in the middle -- very expensive reallocation
 	// alternative: copy last element to index position, then shrink vector by 1 at the end O(constant)
@@ -775,6 +903,14 @@ void delete_cell( int index )
 	(*all_cells)[index] = (*all_cells)[ (*all_cells).size()-1 ];
 	// shrink the vector
 	(*all_cells).pop_back();	
+	// the mechanics arena mirrors all_cells slot for slot 
+	if( arena_in_step )
+	{ arena.remove_slot( index ); }
+	else
+	{ arena.clear(); }
+	
+	// de-allocate the cell, and give its slot back to the pool 
+	cell_pool.destroy( pDelete ); 
 	return; 
 }
 
@@ -70,6 +70,7 @@
 #include "../BioFVM/BioFVM.h"
 #include "./PhysiCell_phenotype.h"
 #include "./PhysiCell_cell_container.h"
+#include "./PhysiCell_mechanics_arena.h"
 #include "./PhysiCell_constants.h"
 
 using namespace BioFVM; 
@@ -137,12 +138,29 @@ class Cell_State
 	Cell_State(); 
 };
 
+/* Cells live in cell_pool (see Cell_Pool below): create them with create_cell() 
+   and remove them with delete_cell(), never with new or delete. The destructor is 
+   private, so only the pool can destroy a Cell. */ 
+
 class Cell : public Basic_Agent 
 {
  private: 
 	Cell_Container * container;
 	int current_mechanics_voxel_index;
 	int updated_current_mechanics_voxel_index; // keeps the updated voxel index for later adjusting of current voxel index
+	
+	// simulation snapshots (see PhysiCell_snapshot.h) 
+	friend bool write_cell_snapshot( Snapshot_Buffer& buffer , Cell* pCell ); 
+	friend bool read_cell_snapshot( Snapshot_Buffer& buffer , Cell* pCell ); 
+	
+	friend class Cell_Pool; 
+	~Cell(); 
+	
+	// the mechanics arena copies previous_velocity (protected in Basic_Agent) 
+	friend class Cell_Mechanics_Arena; 
+	
+	// the container rebins moved cells in one batch (see Cell_Container::rebin_moved_cells) 
+	friend class Cell_Container; 
 		
  public:
 	std::string type_name; 
@@ -158,6 +176,7 @@ class Cell : public Basic_Agent
 	void advance_bundled_phenotype_functions( double dt_ ); 
 	
 	void add_potentials(Cell*);       // Add repulsive and adhesive forces.
+	void add_potentials( int other_slot ); // the same, for the cell in that mechanics arena slot 
 	void set_previous_velocity(double xV, double yV, double zV);
 	int get_current_mechanics_voxel_index();
 	void turn_off_reactions(double); 		  // Turn off all the reactions of the cell
@@ -171,19 +190,32 @@ class Cell : public Basic_Agent
 	void start_death( int death_model_index ); 
 
 	Cell* divide( void );
+	// the steps of divide(), for batched divisions (see Cell_Container::divide_flagged_cells): 
+	// prepare_daughter_cell() only touches this cell and the daughter, so it may run in parallel; 
+	// register_daughter_cell() updates the agent grid and the per-voxel interaction distances 
+	void prepare_daughter_cell( Cell* child , double temp_angle , double temp_phi ); 
+	void register_daughter_cell( Cell* child ); 
 	void die( void );
 	void step(double dt);
 	Cell();
 	
 	bool assign_position(std::vector<double> new_position);
 	bool assign_position(double, double, double);
+	bool place_at(double, double, double); // like assign_position, but does not register in the agent grid 
 	void set_total_volume(double);
 	
 	double& get_total_volume(void); // NEW
 	
 	// mechanics 
 	void update_position( double dt ); //
-	std::vector<double> displacement; // this should be moved to state, or made private  
+	Vec3 displacement; // this should be moved to state, or made private  
+	
+	// this cell's slot in get_container()->mechanics_arena (see PhysiCell_mechanics_arena.h) 
+	int mechanics_slot( void ) const; 
+	double& mechanics_position( int dimension ); 
+	double& mechanics_velocity( int dimension ); 
+	double& mechanics_previous_velocity( int dimension ); 
+	double& mechanics_radius( void ); 
 
 	
 	void assign_orientation();  // if set_orientaion is defined, uses it to assign the orientation
@@ -210,6 +242,43 @@ Cell* create_cell( Cell_Definition& cd );
 
 void delete_cell( int ); 
 void delete_cell( Cell* ); 
+
+/* Storage for Cell objects. Cells are constructed in place inside large slabs 
+   rather than one heap block per cell, and the slot of a cell that dies is 
+   reused by the next new cell (most recently freed first, while it is still 
+   in cache). Slabs are never returned to the system while the pool lives. 
+   
+   create_cell() and delete_cell() use this pool; do not delete a Cell 
+   directly. The pool is not thread-safe: cells are created and destroyed in 
+   the serial parts of the time step. 
+   
+   cell_pool is a process-wide global, like all_cells, and not a member of 
+   Cell_Container: create_cell() does not know the container, and cells can 
+   be created before any container exists. */ 
+
+class Cell_Pool
+{
+ private:
+	std::vector<void*> slabs; 
+	std::vector<Cell*> free_slots; 
+	int cells_per_slab; 
+	int number_of_cells; 
+	
+	void add_slab( void ); 
+	
+ public:
+	Cell_Pool(); 
+	~Cell_Pool(); 
+	
+	Cell* create( void ); // default-constructs a Cell in a free slot 
+	void destroy( Cell* pCell ); // destroys the Cell, and frees its slot 
+	void reserve( int number_of_slots ); // makes room for this many live cells 
+	
+	int size( void ) const; // live cells 
+	int capacity( void ) const; // live cells plus free slots 
+}; 
+
+extern Cell_Pool cell_pool; 
 void save_all_cells_to_matlab( std::string filename ); 
 
 //function to check if a neighbor voxel contains any cell that can interact with me
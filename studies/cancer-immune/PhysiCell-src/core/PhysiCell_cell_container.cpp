@@ -66,6 +66,10 @@
 #include "PhysiCell_constants.h"
 #include "../BioFVM/BioFVM_vector.h"
 #include "PhysiCell_cell.h"
+#include "PhysiCell_utilities.h"
+
+#include <omp.h>
+#include <algorithm>
 
 using namespace BioFVM;
 
@@ -135,8 +139,8 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 	//if it is the time for running cell cycle, do it!
 	double time_since_last_cycle= t- last_cell_cycle_time;
 
-	static double phenotype_tolerance = 0.001 * phenotype_dt_; 
-	static double mechanics_tolerance = 0.001 * mechanics_dt_; 
+	double phenotype_tolerance = 0.001 * phenotype_dt_; 
+	double mechanics_tolerance = 0.001 * mechanics_dt_; 
 	
 	if( fabs(time_since_last_cycle- phenotype_dt_ ) < phenotype_tolerance || !initialzed)
 	{
@@ -251,8 +255,8 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 	//if it is the time for running cell cycle, do it!
 	double time_since_last_cycle= t- last_cell_cycle_time;
 
-	static double phenotype_dt_tolerance = 0.001 * phenotype_dt_; 
-	static double mechanics_dt_tolerance = 0.001 * mechanics_dt_; 
+	double phenotype_dt_tolerance = 0.001 * phenotype_dt_; 
+	double mechanics_dt_tolerance = 0.001 * mechanics_dt_; 
 	
 	if( fabs(time_since_last_cycle-phenotype_dt_ ) < phenotype_dt_tolerance || !initialzed)
 	{
@@ -267,7 +271,9 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 		
 		// new as of 1.2.1 -- bundles cell phenotype parameter update, volume update, geometry update, 
 		// checking for death, and advancing the cell cycle. Not motility, though. (that's in mechanics)
-		#pragma omp parallel for 
+		size_thread_flag_lists(); 
+		// static scheduling: see merge_thread_flag_lists() 
+		#pragma omp parallel for schedule(static) 
 		for( int i=0; i < (*all_cells).size(); i++ )
 		{
 			if((*all_cells)[i]->is_out_of_domain)
@@ -277,19 +283,12 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 		}
 		
 		// process divides / removes 
-		for( int i=0; i < cells_ready_to_divide.size(); i++ )
-		{
-			cells_ready_to_divide[i]->divide();
-		}
-		for( int i=0; i < cells_ready_to_die.size(); i++ )
-		{	
-			cells_ready_to_die[i]->die();	
-		}
+		merge_thread_flag_lists(); 
 		num_divisions_in_current_step+=  cells_ready_to_divide.size();
 		num_deaths_in_current_step+=  cells_ready_to_die.size();
 		
-		cells_ready_to_die.clear();
-		cells_ready_to_divide.clear();
+		divide_flagged_cells(); 
+		remove_flagged_cells(); 
 		last_cell_cycle_time= t;
 	}
 		
@@ -302,8 +301,14 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 		{
 			time_since_last_mechanics = mechanics_dt_;
 		}
-		// Compute velocities
-		#pragma omp parallel for 
+		// refresh the contiguous copy of positions, radii, and mechanics coefficients 
+		// that the velocity functions read for every neighbor pair 
+		mechanics_arena.gather( *all_cells ); 
+		mechanics_arena.gather_voxel_slots( agent_grid ); 
+		
+		// Compute velocities (custom cell rules may flag cells: static scheduling, 
+		// see merge_thread_flag_lists()) 
+		#pragma omp parallel for schedule(static) 
 		for( int i=0; i < (*all_cells).size(); i++ )
 		{
 
@@ -329,12 +334,8 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 			}
 		}
 		
-		// When somebody reviews this code, let's add proper braces for clarity!!! 
-		
 		// Update cell indices in the container
-		for( int i=0; i < (*all_cells).size(); i++ )
-			if(!(*all_cells)[i]->is_out_of_domain && (*all_cells)[i]->is_movable)
-				(*all_cells)[i]->update_voxel_in_container();
+		rebin_moved_cells(); 
 		last_mechanics_time=t;
 	}
 	
@@ -342,6 +343,144 @@ void Cell_Container::update_all_cells(double t, double phenotype_dt_ , double me
 	return;
 }
 
+void Cell_Container::rebin_moved_cells( void )
+{
+	// Update each cell's microenvironment voxel and find the cells that changed mechanics 
+	// voxels. Each thread lists its own movers, and the lists are joined in thread order 
+	// (the all_cells order, with static scheduling). 
+	int number_of_threads = omp_get_max_threads(); 
+	if( thread_moved_cells.size() < number_of_threads )
+	{ thread_moved_cells.resize( number_of_threads ); }
+	
+	#pragma omp parallel for schedule(static) 
+	for( int i=0; i < (*all_cells).size(); i++ )
+	{
+		Cell* pCell = (*all_cells)[i]; 
+		if( pCell->is_out_of_domain || !pCell->is_movable )
+		{ continue; }
+		pCell->update_voxel_index(); 
+		if( pCell->updated_current_mechanics_voxel_index != pCell->current_mechanics_voxel_index || 
+			pCell->updated_current_mechanics_voxel_index == -1 )
+		{
+			Moved_Cell move = { pCell , pCell->current_mechanics_voxel_index , pCell->updated_current_mechanics_voxel_index }; 
+			thread_moved_cells[ omp_get_thread_num() ].push_back( move ); 
+		}
+	}
+	
+	moved_cells.clear(); 
+	for( int i=0; i < thread_moved_cells.size(); i++ )
+	{
+		moved_cells.insert( moved_cells.end() , thread_moved_cells[i].begin() , thread_moved_cells[i].end() ); 
+		thread_moved_cells[i].clear(); 
+	}
+	int number_of_moves = moved_cells.size(); 
+	if( number_of_moves == 0 )
+	{ return; }
+	
+	// The counting sort below costs O(voxels) on every mechanics step (clearing the event 
+	// counts, their serial prefix sum, and the pass over all voxels), whatever the number 
+	// of movers. When few cells moved, move them one at a time (in all_cells order) instead. 
+	int number_of_voxels = agent_grid.size(); 
+	if( number_of_moves < number_of_voxels / 16 )
+	{
+		for( int k=0; k < number_of_moves; k++ )
+		{
+			Cell* pCell = moved_cells[k].pCell; 
+			if( moved_cells[k].old_voxel >= 0 )
+			{ remove_agent_from_voxel( pCell , moved_cells[k].old_voxel ); }
+			if( moved_cells[k].new_voxel >= 0 )
+			{ add_agent_to_voxel( pCell , moved_cells[k].new_voxel ); }
+			pCell->current_mechanics_voxel_index = moved_cells[k].new_voxel; 
+		}
+		add_pushed_out_cells_to_outer_voxels(); 
+		return; 
+	}
+	
+	// counting sort of the removals and additions by voxel (see voxel_events) 
+	voxel_event_start.assign( number_of_voxels+1 , 0 ); 
+	#pragma omp parallel for 
+	for( int k=0; k < number_of_moves; k++ )
+	{
+		if( moved_cells[k].old_voxel >= 0 )
+		{
+			#pragma omp atomic 
+			voxel_event_start[ moved_cells[k].old_voxel+1 ]++; 
+		}
+		if( moved_cells[k].new_voxel >= 0 )
+		{
+			#pragma omp atomic 
+			voxel_event_start[ moved_cells[k].new_voxel+1 ]++; 
+		}
+	}
+	for( int i=0; i < number_of_voxels; i++ )
+	{ voxel_event_start[i+1] += voxel_event_start[i]; }
+	
+	voxel_event_cursor.assign( voxel_event_start.begin() , voxel_event_start.end()-1 ); 
+	voxel_events.resize( voxel_event_start[number_of_voxels] ); 
+	#pragma omp parallel for 
+	for( int k=0; k < number_of_moves; k++ )
+	{
+		int slot; 
+		if( moved_cells[k].old_voxel >= 0 )
+		{
+			#pragma omp atomic capture 
+			slot = voxel_event_cursor[ moved_cells[k].old_voxel ]++; 
+			voxel_events[slot] = 2*k; 
+		}
+		if( moved_cells[k].new_voxel >= 0 )
+		{
+			#pragma omp atomic capture 
+			slot = voxel_event_cursor[ moved_cells[k].new_voxel ]++; 
+			voxel_events[slot] = 2*k+1; 
+		}
+	}
+	
+	// Each voxel's list is changed by one thread only. Its events are replayed in all_cells 
+	// order, so the list ends up in the same order as moving the cells one at a time 
+	// (which matters for the order of the force sums in add_potentials). 
+	#pragma omp parallel for 
+	for( int i=0; i < number_of_voxels; i++ )
+	{
+		int start = voxel_event_start[i]; 
+		int end = voxel_event_start[i+1]; 
+		if( start == end )
+		{ continue; }
+		// the slots above were claimed in no particular order 
+		std::sort( voxel_events.begin() + start , voxel_events.begin() + end ); 
+		for( int j=start; j < end; j++ )
+		{
+			Cell* pCell = moved_cells[ voxel_events[j] / 2 ].pCell; 
+			if( voxel_events[j] % 2 == 0 )
+			{ remove_agent_from_voxel( pCell , i ); }
+			else
+			{ add_agent_to_voxel( pCell , i ); }
+		}
+	}
+	
+	#pragma omp parallel for 
+	for( int k=0; k < number_of_moves; k++ )
+	{ moved_cells[k].pCell->current_mechanics_voxel_index = moved_cells[k].new_voxel; }
+	
+	add_pushed_out_cells_to_outer_voxels(); 
+	return; 
+}
+
+void Cell_Container::add_pushed_out_cells_to_outer_voxels( void )
+{
+	// cells pushed out of the domain (see Cell::update_voxel_in_container) 
+	for( int k=0; k < moved_cells.size(); k++ )
+	{
+		if( moved_cells[k].new_voxel == -1 )
+		{
+			Cell* pCell = moved_cells[k].pCell; 
+			add_agent_to_outer_voxel( pCell ); 
+			pCell->is_out_of_domain = true; 
+			pCell->is_active = false; 
+		}
+	}
+	return; 
+}
+
 void Cell_Container::register_agent( Cell* agent )
 {
 	agent_grid[agent->get_current_mechanics_voxel_index()].push_back(agent);
@@ -370,9 +509,9 @@ void Cell_Container::remove_agent_from_voxel(Cell* agent, int voxel_index)
 		delete_index++; 
 	}
 	// move last item to index location  
-	agent_grid[agent->get_current_mechanics_voxel_index()][delete_index] = agent_grid[agent->get_current_mechanics_voxel_index()][agent_grid[agent->get_current_mechanics_voxel_index()].size()-1 ]; 
+	agent_grid[voxel_index][delete_index] = agent_grid[voxel_index][agent_grid[voxel_index].size()-1 ]; 
 	// shrink the vector
-	agent_grid[agent->get_current_mechanics_voxel_index()].pop_back(); 
+	agent_grid[voxel_index].pop_back(); 
 	return; 
 }		
 
@@ -407,6 +546,13 @@ int find_escaping_face_index(Cell* agent)
 
 void Cell_Container::flag_cell_for_division( Cell* pCell )
 { 
+	int thread = omp_get_thread_num(); 
+	if( thread < thread_cells_ready_to_divide.size() )
+	{
+		thread_cells_ready_to_divide[thread].push_back( pCell ); 
+		return; 
+	}
+	// more threads than lists (e.g., flagged from a custom parallel region) 
 	#pragma omp critical 
 	{cells_ready_to_divide.push_back( pCell );} 
 	return; 
@@ -414,11 +560,120 @@ void Cell_Container::flag_cell_for_division( Cell* pCell )
 
 void Cell_Container::flag_cell_for_removal( Cell* pCell )
 { 
+	int thread = omp_get_thread_num(); 
+	if( thread < thread_cells_ready_to_die.size() )
+	{
+		thread_cells_ready_to_die[thread].push_back( pCell ); 
+		return; 
+	}
 	#pragma omp critical 
 	{cells_ready_to_die.push_back( pCell );} 
 	return; 
 }
 
+void Cell_Container::size_thread_flag_lists( void )
+{
+	int number_of_threads = omp_get_max_threads(); 
+	if( thread_cells_ready_to_divide.size() < number_of_threads )
+	{
+		thread_cells_ready_to_divide.resize( number_of_threads ); 
+		thread_cells_ready_to_die.resize( number_of_threads ); 
+	}
+	return; 
+}
+
+// The parallel loops that flag cells use schedule(static), so thread k flags cells from 
+// the k-th contiguous block of all_cells. Joining the lists in thread order then gives 
+// the same flag order (and the same divisions and all_cells order) as a serial loop. 
+void Cell_Container::merge_thread_flag_lists( void )
+{
+	for( int i=0; i < thread_cells_ready_to_divide.size(); i++ )
+	{
+		cells_ready_to_divide.insert( cells_ready_to_divide.end() , 
+			thread_cells_ready_to_divide[i].begin() , thread_cells_ready_to_divide[i].end() ); 
+		thread_cells_ready_to_divide[i].clear(); 
+	}
+	for( int i=0; i < thread_cells_ready_to_die.size(); i++ )
+	{
+		cells_ready_to_die.insert( cells_ready_to_die.end() , 
+			thread_cells_ready_to_die[i].begin() , thread_cells_ready_to_die[i].end() ); 
+		thread_cells_ready_to_die[i].clear(); 
+	}
+	return; 
+}
+
+bool Cell_Container::division_list_has_duplicates( void )
+{
+	division_marks.assign( (*all_cells).size() , 0 ); 
+	bool duplicates = false; 
+	for( int i=0; i < cells_ready_to_divide.size(); i++ )
+	{
+		char& mark = division_marks[ cells_ready_to_divide[i]->index ]; 
+		if( mark )
+		{ duplicates = true; }
+		mark = 1; 
+	}
+	return duplicates; 
+}
+
+void Cell_Container::divide_flagged_cells( void )
+{
+	int number_of_divisions = cells_ready_to_divide.size(); 
+	
+	// a cell flagged twice divides twice, which only works one division at a time 
+	if( division_list_has_duplicates() )
+	{
+		for( int i=0; i < number_of_divisions; i++ )
+		{ cells_ready_to_divide[i]->divide(); }
+		cells_ready_to_divide.clear();
+		return; 
+	}
+	
+	// Create the daughters and draw their random numbers serially, in flag order. This 
+	// gives the same random sequence and all_cells order as calling divide() one by one. 
+	cell_pool.reserve( cell_pool.size() + number_of_divisions ); 
+	daughter_cells.resize( number_of_divisions ); 
+	daughter_angles.resize( 2*number_of_divisions ); 
+	for( int i=0; i < number_of_divisions; i++ )
+	{
+		daughter_cells[i] = create_cell(); 
+		daughter_angles[2*i] = 6.28318530717959*UniformRandom();
+		daughter_angles[2*i+1] = 3.1415926535897932384626433832795*UniformRandom();
+	}
+	
+	// copy the parents' data and place the daughters 
+	#pragma omp parallel for schedule(static) 
+	for( int i=0; i < number_of_divisions; i++ )
+	{
+		cells_ready_to_divide[i]->prepare_daughter_cell( daughter_cells[i] , 
+			daughter_angles[2*i] , daughter_angles[2*i+1] ); 
+	}
+	
+	// one pass over the shared agent grid, in flag order 
+	for( int i=0; i < number_of_divisions; i++ )
+	{ cells_ready_to_divide[i]->register_daughter_cell( daughter_cells[i] ); }
+	
+	// the largest copy: each daughter inherits the (halved) parent phenotype 
+	#pragma omp parallel for schedule(static) 
+	for( int i=0; i < number_of_divisions; i++ )
+	{ daughter_cells[i]->phenotype = cells_ready_to_divide[i]->phenotype; }
+	
+	cells_ready_to_divide.clear();
+	return; 
+}
+
+void Cell_Container::remove_flagged_cells( void )
+{
+	// each removal moves the last cell into the freed slot, so removals stay serial 
+	// (in flag order) to keep all_cells in the same order 
+	for( int i=0; i < cells_ready_to_die.size(); i++ )
+	{	
+		cells_ready_to_die[i]->die();	
+	}
+	cells_ready_to_die.clear();
+	return; 
+}
+
 
 Cell_Container* create_cell_container_for_microenvironment( BioFVM::Microenvironment& m , double mechanics_voxel_size )
 {
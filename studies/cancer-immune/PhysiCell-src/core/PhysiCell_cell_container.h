@@ -70,6 +70,7 @@
 #include "../BioFVM/BioFVM_agent_container.h"
 #include "../BioFVM/BioFVM_mesh.h"
 #include "../BioFVM/BioFVM_microenvironment.h"
+#include "PhysiCell_mechanics_arena.h"
 
 namespace PhysiCell{
 
@@ -80,9 +81,44 @@ class Cell_Container : public BioFVM::Agent_Container
  private:	
 	std::vector<Cell*> cells_ready_to_divide; // the index of agents ready to divide
 	std::vector<Cell*> cells_ready_to_die;
+	// one list per OpenMP thread, so flagging from the parallel phenotype loop needs no lock. 
+	// They are appended to the lists above in thread order (the loop order, with static scheduling). 
+	std::vector< std::vector<Cell*> > thread_cells_ready_to_divide; 
+	std::vector< std::vector<Cell*> > thread_cells_ready_to_die; 
+	void size_thread_flag_lists( void ); 
+	void merge_thread_flag_lists( void ); 
+	
+	// scratch space for batched divisions 
+	std::vector<Cell*> daughter_cells; 
+	std::vector<double> daughter_angles; 
+	std::vector<char> division_marks; 
+	bool division_list_has_duplicates( void ); 
+	
+	// scratch space for moving cells between mechanics voxels after update_position. The 
+	// events (removals and additions) for voxel i are voxel_events[ voxel_event_start[i] ] 
+	// through voxel_events[ voxel_event_start[i+1]-1 ]: event 2k removes moved_cells[k] 
+	// from its old voxel, event 2k+1 adds it to its new one. 
+	struct Moved_Cell
+	{
+		Cell* pCell; 
+		int old_voxel; 
+		int new_voxel; 
+	}; 
+	std::vector< std::vector<Moved_Cell> > thread_moved_cells; 
+	std::vector<Moved_Cell> moved_cells; 
+	std::vector<int> voxel_event_start; 
+	std::vector<int> voxel_event_cursor; 
+	std::vector<int> voxel_events; 
+	void rebin_moved_cells( void ); 
+	void add_pushed_out_cells_to_outer_voxels( void ); // the moved_cells that left the domain 
+	
 	int boundary_condition_for_pushed_out_agents; 	// what to do with pushed out cells
 	bool initialzed = false;
 	
+	// simulation snapshots (see PhysiCell_snapshot.h) 
+	friend bool write_simulation_snapshot( BioFVM::Snapshot_Buffer& buffer , BioFVM::Microenvironment& m , double t ); 
+	friend bool read_simulation_snapshot( BioFVM::Snapshot_Buffer& buffer , BioFVM::Microenvironment& m , double& t ); 
+	
  public:
 	BioFVM::Cartesian_Mesh underlying_mesh;
 	std::vector<double> max_cell_interactive_distance_in_voxel;
@@ -97,6 +133,7 @@ class Cell_Container : public BioFVM::Agent_Container
 	void initialize(double x_start, double x_end, double y_start, double y_end, double z_start, double z_end , double dx, double dy, double dz);
 	std::vector<std::vector<Cell*> > agent_grid;
 	std::vector<std::vector<Cell*> > agents_in_outer_voxels;
+	Cell_Mechanics_Arena mechanics_arena; // see PhysiCell_mechanics_arena.h 
 	
 	void update_all_cells(double t);
 	void update_all_cells(double t, double dt);
@@ -111,6 +148,8 @@ class Cell_Container : public BioFVM::Agent_Container
 	
 	void flag_cell_for_division( Cell* pCell ); 
 	void flag_cell_for_removal( Cell* pCell ); 
+	void divide_flagged_cells( void ); 
+	void remove_flagged_cells( void ); 
 	bool contain_any_cell(int voxel_index);
 };
 
@@ -0,0 +1,178 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#include "PhysiCell_mechanics_arena.h"
+#include "PhysiCell_cell.h"
+
+namespace PhysiCell{
+
+int Cell_Mechanics_Arena::size( void ) const
+{ return radius.size(); }
+
+void Cell_Mechanics_Arena::resize( int number_of_slots )
+{
+	for( int i=0; i < 3 ; i++ )
+	{
+		position[i].resize( number_of_slots , 0.0 ); 
+		velocity[i].resize( number_of_slots , 0.0 ); 
+		previous_velocity[i].resize( number_of_slots , 0.0 ); 
+	}
+	radius.resize( number_of_slots , 0.0 ); 
+	nuclear_radius.resize( number_of_slots , 0.0 ); 
+	cell_cell_adhesion_strength.resize( number_of_slots , 0.0 ); 
+	cell_cell_repulsion_strength.resize( number_of_slots , 0.0 ); 
+	relative_maximum_adhesion_distance.resize( number_of_slots , 0.0 ); 
+	return; 
+}
+
+void Cell_Mechanics_Arena::clear( void )
+{
+	resize( 0 ); 
+	return; 
+}
+
+int Cell_Mechanics_Arena::add_slot( void )
+{
+	int slot = size(); 
+	resize( slot + 1 ); 
+	return slot; 
+}
+
+void Cell_Mechanics_Arena::remove_slot( int slot )
+{
+	int last = size() - 1; 
+	if( slot < 0 || slot > last )
+	{ return; }
+	
+	for( int i=0; i < 3 ; i++ )
+	{
+		position[i][slot] = position[i][last]; 
+		velocity[i][slot] = velocity[i][last]; 
+		previous_velocity[i][slot] = previous_velocity[i][last]; 
+	}
+	radius[slot] = radius[last]; 
+	nuclear_radius[slot] = nuclear_radius[last]; 
+	cell_cell_adhesion_strength[slot] = cell_cell_adhesion_strength[last]; 
+	cell_cell_repulsion_strength[slot] = cell_cell_repulsion_strength[last]; 
+	relative_maximum_adhesion_distance[slot] = relative_maximum_adhesion_distance[last]; 
+	
+	resize( last ); 
+	return; 
+}
+
+void Cell_Mechanics_Arena::store( Cell* pCell )
+{
+	int slot = pCell->index; 
+	store_kinematics( pCell ); 
+	
+	radius[slot] = pCell->phenotype.geometry.radius; 
+	nuclear_radius[slot] = pCell->phenotype.geometry.nuclear_radius; 
+	cell_cell_adhesion_strength[slot] = pCell->phenotype.mechanics.cell_cell_adhesion_strength; 
+	cell_cell_repulsion_strength[slot] = pCell->phenotype.mechanics.cell_cell_repulsion_strength; 
+	relative_maximum_adhesion_distance[slot] = pCell->phenotype.mechanics.relative_maximum_adhesion_distance; 
+	return; 
+}
+
+void Cell_Mechanics_Arena::store_kinematics( Cell* pCell )
+{
+	int slot = pCell->index; 
+	for( int i=0; i < 3 ; i++ )
+	{
+		position[i][slot] = pCell->position[i]; 
+		velocity[i][slot] = pCell->velocity[i]; 
+		previous_velocity[i][slot] = pCell->previous_velocity[i]; 
+	}
+	return; 
+}
+
+void Cell_Mechanics_Arena::gather( std::vector<Cell*>& cells )
+{
+	if( size() != cells.size() )
+	{ resize( cells.size() ); }
+	
+	#pragma omp parallel for 
+	for( int i=0; i < cells.size(); i++ )
+	{ store( cells[i] ); }
+	return; 
+}
+
+void Cell_Mechanics_Arena::gather_voxel_slots( std::vector< std::vector<Cell*> >& agent_grid )
+{
+	voxel_slot_start.resize( agent_grid.size() + 1 ); 
+	voxel_slot_start[0] = 0; 
+	for( int v=0; v < agent_grid.size() ; v++ )
+	{ voxel_slot_start[v+1] = voxel_slot_start[v] + agent_grid[v].size(); }
+	voxel_slots.resize( voxel_slot_start[ agent_grid.size() ] ); 
+	
+	#pragma omp parallel for schedule(static) 
+	for( int v=0; v < agent_grid.size() ; v++ )
+	{
+		int n = voxel_slot_start[v]; 
+		for( int k=0; k < agent_grid[v].size() ; k++ )
+		{ voxel_slots[n+k] = agent_grid[v][k]->index; }
+	}
+	return; 
+}
+
+};
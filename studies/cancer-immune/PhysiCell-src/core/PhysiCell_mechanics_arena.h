@@ -0,0 +1,129 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#ifndef __PhysiCell_mechanics_arena_h__
+#define __PhysiCell_mechanics_arena_h__
+
+#include <vector>
+#include "../BioFVM/BioFVM_density_storage.h"
+
+namespace PhysiCell{
+
+class Cell; 
+
+/* Contiguous storage for the fields that the mechanics loops read for every 
+   cell pair. Each Cell_Container owns one (Cell::get_container()->mechanics_arena). 
+   Each field is its own cache-aligned array (structure of arrays), and slot i 
+   belongs to (*all_cells)[i], so Cell::index doubles as the slot. 
+   
+   create_cell() and delete_cell() keep the slots in step with all_cells (a 
+   deleted slot is overwritten by the last one, exactly as in all_cells). The 
+   values are a copy: the Cell and its Phenotype remain the owners, and the 
+   Cell_Container refreshes the arena with gather() at the start of each 
+   mechanics step, along with gather_voxel_slots(), which lists the slots in 
+   each mechanics voxel so that the neighbor loops never touch the neighbor 
+   Cell objects. Within a mechanics step, velocity functions read neighbor 
+   positions, radii and mechanics coefficients from here, and update_position() 
+   writes the new kinematics back. Outside a mechanics step, the values may be 
+   stale. 
+   
+   In the cancer-immune model (about 18,400 cells, one thread), gather() (17 
+   doubles per cell) takes about 1.2 ms per mechanics step and 
+   gather_voxel_slots() about 0.9 ms, while the velocity loop that reads 
+   them takes about 64 ms (79 ms when it read each neighbor's Cell::index). */ 
+
+class Cell_Mechanics_Arena
+{
+ public:
+	BioFVM::aligned_vector position[3]; 
+	BioFVM::aligned_vector velocity[3]; 
+	BioFVM::aligned_vector previous_velocity[3]; 
+	
+	BioFVM::aligned_vector radius; 
+	BioFVM::aligned_vector nuclear_radius; 
+	BioFVM::aligned_vector cell_cell_adhesion_strength; 
+	BioFVM::aligned_vector cell_cell_repulsion_strength; 
+	BioFVM::aligned_vector relative_maximum_adhesion_distance; 
+	
+	int size( void ) const; 
+	void resize( int number_of_slots ); 
+	void clear( void ); 
+	
+	int add_slot( void ); // appends a zeroed slot, and returns its index 
+	void remove_slot( int slot ); // moves the last slot into slot, then shrinks by one 
+	
+	void store( Cell* pCell ); // copies all fields of pCell into slot pCell->index 
+	void store_kinematics( Cell* pCell ); // copies only position and (previous) velocity 
+	void gather( std::vector<Cell*>& cells ); // resizes to cells.size() and stores every cell 
+	
+	// the slots in mechanics voxel v, in agent_grid order, are 
+	// voxel_slots[ voxel_slot_start[v] ] through voxel_slots[ voxel_slot_start[v+1]-1 ] 
+	std::vector<int> voxel_slot_start; 
+	std::vector<int> voxel_slots; 
+	void gather_voxel_slots( std::vector< std::vector<Cell*> >& agent_grid ); 
+}; 
+
+};
+
+#endif
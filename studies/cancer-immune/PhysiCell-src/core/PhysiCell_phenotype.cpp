@@ -654,14 +654,14 @@ Motility::Motility()
 	persistence_time = 1.0;
 	migration_speed = 1.0;
 	
-	migration_bias_direction.resize( 3 , 0.0 ); 
+	migration_bias_direction = Vec3(); 
 	migration_bias = 0.0; 
 		
 	restrict_to_2D = false; 
 	
 	// update_migration_bias_direction = NULL; 
 	
-	motility_vector.resize( 3 , 0.0 ); 
+	motility_vector = Vec3(); 
 	
 	return; 
 }
@@ -742,6 +742,12 @@ void Secretion::advance( Basic_Agent* pCell, Phenotype& phenotype , double dt )
 		pCell->set_internal_uptake_constants( dt );
 	}
 
+	// with fused sources / sinks, the diffusion solver applies the secretion / uptake 
+	// at the start of its next step, binned by voxel 
+	
+	if( pMicroenvironment->fused_cell_sources_and_sinks )
+	{ return; }
+	
 	// now, call the BioFVM secretion/uptake function 
 	
 	pCell->simulate_secretion_and_uptake( pMicroenvironment , dt ); 
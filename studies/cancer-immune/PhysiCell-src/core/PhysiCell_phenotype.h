@@ -373,7 +373,7 @@ class Motility
 	double migration_speed; // migration speed along chosen direction, 
 		// in absence of all other adhesive / repulsive forces 
 	
-	std::vector<double> migration_bias_direction; // a unit vector
+	Vec3 migration_bias_direction; // a unit vector
 		// random motility is biased in this direction (e.g., chemotaxis)
 	double migration_bias; // how biased is motility
 		// if 0, completely random. if 1, deterministic along the bias vector 
@@ -381,7 +381,7 @@ class Motility
 	bool restrict_to_2D; 
 		// if true, set random motility to 2D only. 
 		
-	std::vector<double> motility_vector; 
+	Vec3 motility_vector; 
 		
 	Motility(); // done 
 };
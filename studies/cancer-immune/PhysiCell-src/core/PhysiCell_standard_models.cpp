@@ -444,12 +444,15 @@ void standard_update_cell_velocity( Cell* pCell, Phenotype& phenotype, double dt
 	
 	pCell->state.simple_pressure = 0.0; 
 	
+	// the neighbors come from the mechanics arena's per-voxel slot lists (same order as 
+	// agent_grid), so the loops below never touch the neighbor Cell objects 
+	Cell_Mechanics_Arena& arena = pCell->get_container()->mechanics_arena; 
+	
 	//First check the neighbors in my current voxel
-	std::vector<Cell*>::iterator neighbor;
-	std::vector<Cell*>::iterator end = pCell->get_container()->agent_grid[pCell->get_current_mechanics_voxel_index()].end();
-	for(neighbor = pCell->get_container()->agent_grid[pCell->get_current_mechanics_voxel_index()].begin(); neighbor != end; ++neighbor)
+	int voxel = pCell->get_current_mechanics_voxel_index(); 
+	for( int n = arena.voxel_slot_start[voxel]; n < arena.voxel_slot_start[voxel+1] ; n++ )
 	{
-		pCell->add_potentials(*neighbor);
+		pCell->add_potentials( arena.voxel_slots[n] );
 	}
 	std::vector<int>::iterator neighbor_voxel_index;
 	std::vector<int>::iterator neighbor_voxel_index_end = 
@@ -462,10 +465,9 @@ void standard_update_cell_velocity( Cell* pCell, Phenotype& phenotype, double dt
 	{
 		if(!is_neighbor_voxel(pCell, pCell->get_container()->underlying_mesh.voxels[pCell->get_current_mechanics_voxel_index()].center, pCell->get_container()->underlying_mesh.voxels[*neighbor_voxel_index].center, *neighbor_voxel_index))
 			continue;
-		end = pCell->get_container()->agent_grid[*neighbor_voxel_index].end();
-		for(neighbor = pCell->get_container()->agent_grid[*neighbor_voxel_index].begin();neighbor != end; ++neighbor)
+		for( int n = arena.voxel_slot_start[*neighbor_voxel_index]; n < arena.voxel_slot_start[*neighbor_voxel_index+1] ; n++ )
 		{
-			pCell->add_potentials(*neighbor);
+			pCell->add_potentials( arena.voxel_slots[n] );
 		}
 	}
 
@@ -578,46 +580,39 @@ void update_cell_and_death_parameters_O2_based( Cell* pCell, Phenotype& phenotyp
 	{ return; }
 	
 	// set up shortcuts to find the Q and K(1) phases (assuming Ki67 basic or advanced model)
-	static bool indices_initiated = false; 
-	static int start_phase_index; // Q_phase_index; 
-	static int end_phase_index; // K_phase_index;
-	static int necrosis_index; 
+	int start_phase_index = -1; // Q_phase_index; 
+	int end_phase_index = -1; // K_phase_index;
+	int necrosis_index = -1; 
 	
-	static int oxygen_substrate_index = pCell->get_microenvironment()->find_density_index( "oxygen" ); 
+	int oxygen_substrate_index = pCell->get_microenvironment()->find_density_index( "oxygen" ); 
 	
-	if( indices_initiated == false )
+	if( phenotype.cycle.model().code == PhysiCell_constants::advanced_Ki67_cycle_model || 
+		phenotype.cycle.model().code == PhysiCell_constants::basic_Ki67_cycle_model )
 	{
-		if( phenotype.cycle.model().code == PhysiCell_constants::advanced_Ki67_cycle_model || 
-			phenotype.cycle.model().code == PhysiCell_constants::basic_Ki67_cycle_model )
+		start_phase_index = phenotype.cycle.model().find_phase_index( PhysiCell_constants::Ki67_negative );
+		necrosis_index = phenotype.death.find_death_model_index( PhysiCell_constants::necrosis_death_model ); 
+		
+		if( phenotype.cycle.model().code == PhysiCell_constants::basic_Ki67_cycle_model )
 		{
-			start_phase_index = phenotype.cycle.model().find_phase_index( PhysiCell_constants::Ki67_negative );
-			necrosis_index = phenotype.death.find_death_model_index( PhysiCell_constants::necrosis_death_model ); 
-			
-			if( phenotype.cycle.model().code == PhysiCell_constants::basic_Ki67_cycle_model )
-			{
-				end_phase_index = 
-					phenotype.cycle.model().find_phase_index( PhysiCell_constants::Ki67_positive );
-				indices_initiated = true; 
-			}
-			if( phenotype.cycle.model().code == PhysiCell_constants::advanced_Ki67_cycle_model )
-			{
-				end_phase_index = 
-					phenotype.cycle.model().find_phase_index( PhysiCell_constants::Ki67_positive_premitotic );
-				indices_initiated = true; 
-			}
+			end_phase_index = 
+				phenotype.cycle.model().find_phase_index( PhysiCell_constants::Ki67_positive );
 		}
-			
-		if( phenotype.cycle.model().code ==  PhysiCell_constants::live_cells_cycle_model )
+		if( phenotype.cycle.model().code == PhysiCell_constants::advanced_Ki67_cycle_model )
 		{
-			start_phase_index = phenotype.cycle.model().find_phase_index( PhysiCell_constants::live );
-			necrosis_index = phenotype.death.find_death_model_index( PhysiCell_constants::necrosis_death_model ); 
-			end_phase_index = phenotype.cycle.model().find_phase_index( PhysiCell_constants::live );
-			indices_initiated = true; 
+			end_phase_index = 
+				phenotype.cycle.model().find_phase_index( PhysiCell_constants::Ki67_positive_premitotic );
 		}
 	}
+		
+	if( phenotype.cycle.model().code ==  PhysiCell_constants::live_cells_cycle_model )
+	{
+		start_phase_index = phenotype.cycle.model().find_phase_index( PhysiCell_constants::live );
+		necrosis_index = phenotype.death.find_death_model_index( PhysiCell_constants::necrosis_death_model ); 
+		end_phase_index = phenotype.cycle.model().find_phase_index( PhysiCell_constants::live );
+	}
 	
 	// don't continue if we never "figured out" the current cycle model. 
-	if( indices_initiated == false )
+	if( end_phase_index < 0 )
 	{
 		return; 
 	}
@@ -65,6 +65,8 @@
 #include "PhysiCell_utilities.h"
 #include "PhysiCell_constants.h"
 
+#include <sstream>
+
 namespace PhysiCell{
 
 std::random_device rd;
@@ -95,6 +97,20 @@ double NormalRandom( double mean, double standard_deviation )
 	return d(gen); 
 }
 
+std::string GetRandomState( void )
+{
+	std::ostringstream state; 
+	state << gen; 
+	return state.str(); 
+}
+
+bool SetRandomState( std::string state )
+{
+	std::istringstream input( state ); 
+	input >> gen; 
+	return !input.fail(); 
+}
+
 // Squared distance between two points
 // This is already in BioFVM_vector as: 
 // double norm_squared( const std::vector<double>& v ); 
@@ -79,6 +79,9 @@ long SeedRandom( long input );
 long SeedRandom( void );
 double UniformRandom( void );
 double NormalRandom( double mean, double standard_deviation );
+// the generator state, as text (for snapshots) 
+std::string GetRandomState( void ); 
+bool SetRandomState( std::string state ); 
 double dist_squared(std::vector<double> p1, std::vector<double> p2);
 double dist(std::vector<double> p1, std::vector<double> p2);
 
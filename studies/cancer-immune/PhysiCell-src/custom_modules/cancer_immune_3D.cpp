@@ -45,6 +45,32 @@ Cancer_Immune_Options::Cancer_Immune_Options()
 
 Cancer_Immune_Options cancer_immune_options; 
 
+Cancer_Immune_Indices::Cancer_Immune_Indices()
+{
+	oxygen = 0; 
+	immunostimulatory_factor = -1; 
+	
+	oncoprotein = -1; 
+	kill_rate = -1; 
+	attachment_lifetime = -1; 
+	attachment_rate = -1; 
+	return; 
+}
+
+void Cancer_Immune_Indices::resolve( Microenvironment& M , Custom_Cell_Data& custom_data )
+{
+	oxygen = M.find_density_index( "oxygen" ); 
+	immunostimulatory_factor = M.find_density_index( "immunostimulatory factor" ); 
+	
+	oncoprotein = custom_data.find_variable_index( "oncoprotein" ); 
+	kill_rate = custom_data.find_variable_index( "kill rate" ); 
+	attachment_lifetime = custom_data.find_variable_index( "attachment lifetime" ); 
+	attachment_rate = custom_data.find_variable_index( "attachment rate" ); 
+	return; 
+}
+
+Cancer_Immune_Indices cancer_immune_indices; 
+
 Cell_Definition immune_cell; 
 
 void create_immune_cell_type( void )
@@ -62,7 +88,7 @@ void create_immune_cell_type( void )
 	immune_cell.phenotype.cycle.data.transition_rate(cycle_start_index,cycle_end_index) = 0.0; 	
 	
 	int apoptosis_index = cell_defaults.phenotype.death.find_death_model_index( PhysiCell_constants::apoptosis_death_model ); 
-	int oxygen_i = microenvironment.find_density_index( "oxygen" ); 
+	int oxygen_i = cancer_immune_indices.oxygen; 
 	
 	// reduce o2 uptake 
 	
@@ -147,7 +173,7 @@ void create_cell_types( void )
 	
 	// set default uptake and secretion 
 	
-	int oxygen_i = microenvironment.find_density_index( "oxygen" ); 
+	int oxygen_i = cell_defaults.pMicroenvironment->find_density_index( "oxygen" ); 
 	
 	// oxygen 
 	cell_defaults.phenotype.secretion.secretion_rates[oxygen_i] = 0; 
@@ -156,7 +182,7 @@ void create_cell_types( void )
 
 	// immunostimulatory 
 	
-	int immune_factor_i = microenvironment.find_density_index( "immunostimulatory factor" ); 
+	int immune_factor_i = cell_defaults.pMicroenvironment->find_density_index( "immunostimulatory factor" ); 
 	
 	cell_defaults.phenotype.secretion.saturation_densities[immune_factor_i] = 1; 
 
@@ -182,6 +208,8 @@ void create_cell_types( void )
 	cell_defaults.custom_data.add_variable( "attachment lifetime" , "min" , 0 ); // how long it can stay attached 
 	cell_defaults.custom_data.add_variable( "attachment rate" , "1/min" ,0 ); // how long it wants to wander before attaching
 	
+	cancer_immune_indices.resolve( *cell_defaults.pMicroenvironment , cell_defaults.custom_data ); 
+	
 	// create the immune cell type 
 	create_immune_cell_type(); 
 	
@@ -207,6 +235,11 @@ void setup_microenvironment( void )
 	// gradients are needed for this example 
 
 	default_microenvironment_options.calculate_gradients = true; 
+	
+	// only the immune cells read gradients, so compute them on demand (where and 
+	// when the cells read them) 
+	
+	default_microenvironment_options.calculate_gradients_on_demand = true; 
 
 	// add the immunostimulatory factor 
 
@@ -220,6 +253,10 @@ void setup_microenvironment( void )
 	microenvironment.decay_rates[immune_factor_i] = cancer_immune_options.immunostimulatory_decay_rate; 
 		// .016; 
 	
+	// the immune cells only follow the immunostimulatory factor 
+	
+	default_microenvironment_options.gradient_activation_vector[oxygen_i] = false; 
+	
 	// let BioFVM use oxygen as the default 
 
 	default_microenvironment_options.use_oxygen_as_first_field = true; 
@@ -316,8 +353,7 @@ std::vector<std::vector<double>> create_cell_sphere_positions(double cell_radius
 
 void setup_tissue( void )
 {
-	// static int oncoprotein_i = pCell->custom_data.find_variable_index( "oncoprotein" ); 
-	static int oncoprotein_i = cell_defaults.custom_data.find_variable_index( "oncoprotein" ); 
+	int oncoprotein_i = cancer_immune_indices.oncoprotein; 
 	
 	// place a cluster of tumor cells at the center 
 	
@@ -373,16 +409,15 @@ void setup_tissue( void )
 // custom cell phenotype function to scale immunostimulatory factor with hypoxia 
 void tumor_cell_phenotype_with_and_immune_stimulation( Cell* pCell, Phenotype& phenotype, double dt )
 {
-	static int cycle_start_index = live.find_phase_index( PhysiCell_constants::live ); 
-	static int cycle_end_index = live.find_phase_index( PhysiCell_constants::live ); 
+	int cycle_start_index = live.find_phase_index( PhysiCell_constants::live ); 
+	int cycle_end_index = live.find_phase_index( PhysiCell_constants::live ); 
 	
-	// static int oncoprotein_i = pCell->custom_data.find_variable_index( "oncoprotein" ); 
-	static int oncoprotein_i = cell_defaults.custom_data.find_variable_index( "oncoprotein" ); 
+	int oncoprotein_i = cancer_immune_indices.oncoprotein; 
 	
 	// update secretion rates based on hypoxia 
 	
-	static int o2_index = microenvironment.find_density_index( "oxygen" ); 
-	static int immune_factor_index = microenvironment.find_density_index( "immunostimulatory factor" ); 
+	int o2_index = cancer_immune_indices.oxygen; 
+	int immune_factor_index = cancer_immune_indices.immunostimulatory_factor; 
 	double o2 = pCell->nearest_density_vector()[o2_index];	
 
 /*	
@@ -420,7 +455,7 @@ void tumor_cell_phenotype_with_and_immune_stimulation( Cell* pCell, Phenotype& p
 
 std::vector<std::string> cancer_immune_coloring_function( Cell* pCell )
 {
-	static int oncoprotein_i = pCell->custom_data.find_variable_index( "oncoprotein" ); 
+	int oncoprotein_i = cancer_immune_indices.oncoprotein; 
 	
 	// immune are black
 	std::vector< std::string > output( 4, "black" ); 
@@ -479,7 +514,7 @@ std::vector<std::string> cancer_immune_coloring_function( Cell* pCell )
 
 void add_elastic_velocity( Cell* pActingOn, Cell* pAttachedTo , double elastic_constant )
 {
-	std::vector<double> displacement = pAttachedTo->position - pActingOn->position; 
+	Vec3 displacement = pAttachedTo->position - pActingOn->position; 
 	axpy( &(pActingOn->velocity) , elastic_constant , displacement ); 
 	
 	return; 
@@ -571,7 +606,7 @@ void immune_cell_motility( Cell* pCell, Phenotype& phenotype, double dt )
 	// if attached, biased motility towards director chemoattractant 
 	// otherwise, biased motility towards cargo chemoattractant 
 	
-	static int immune_factor_index = microenvironment.find_density_index( "immunostimulatory factor" ); 
+	int immune_factor_index = cancer_immune_indices.immunostimulatory_factor; 
 
 	// if not docked, attempt biased chemotaxis 
 	if( pCell->state.neighbors.size() == 0 )
@@ -610,24 +645,24 @@ Cell* immune_cell_check_neighbors_for_attachment( Cell* pAttacker , double dt )
 
 bool immune_cell_attempt_attachment( Cell* pAttacker, Cell* pTarget , double dt )
 {
-	static int oncoprotein_i = pTarget->custom_data.find_variable_index( "oncoprotein" ); 
-	static int attach_rate_i = pAttacker->custom_data.find_variable_index( "attachment rate" ); 
+	int oncoprotein_i = cancer_immune_indices.oncoprotein; 
+	int attach_rate_i = cancer_immune_indices.attachment_rate; 
 
-	static double oncoprotein_saturation = cancer_immune_options.oncoprotein_saturation; 
+	double oncoprotein_saturation = cancer_immune_options.oncoprotein_saturation; 
 		// 2.0; 
-	static double oncoprotein_threshold = cancer_immune_options.oncoprotein_detection_threshold; 
+	double oncoprotein_threshold = cancer_immune_options.oncoprotein_detection_threshold; 
 		// 0.5; // 0.1; 
-	static double oncoprotein_difference = oncoprotein_saturation - oncoprotein_threshold;
+	double oncoprotein_difference = oncoprotein_saturation - oncoprotein_threshold;
 	
-	static double max_attachment_distance = cancer_immune_options.max_attachment_distance; 
+	double max_attachment_distance = cancer_immune_options.max_attachment_distance; 
 		// 18.0; 
-	static double min_attachment_distance = cancer_immune_options.min_attachment_distance; 
+	double min_attachment_distance = cancer_immune_options.min_attachment_distance; 
 		// 14.0; 
-	static double attachment_difference = max_attachment_distance - min_attachment_distance; 
+	double attachment_difference = max_attachment_distance - min_attachment_distance; 
 	
 	if( pTarget->custom_data[oncoprotein_i] > oncoprotein_threshold && pTarget->phenotype.death.dead == false )
 	{
-		std::vector<double> displacement = pTarget->position - pAttacker->position;
+		Vec3 displacement = pTarget->position - pAttacker->position;
 		double distance_scale = norm( displacement ); 
 		if( distance_scale > max_attachment_distance )
 		{ return false; } 
@@ -658,15 +693,14 @@ bool immune_cell_attempt_attachment( Cell* pAttacker, Cell* pTarget , double dt
 
 bool immune_cell_attempt_apoptosis( Cell* pAttacker, Cell* pTarget, double dt )
 {
-	static int oncoprotein_i = pTarget->custom_data.find_variable_index( "oncoprotein" ); 
-	static int apoptosis_model_index = pTarget->phenotype.death.find_death_model_index( "apoptosis" );	
-	static int kill_rate_index = pAttacker->custom_data.find_variable_index( "kill rate" ); 
+	int oncoprotein_i = cancer_immune_indices.oncoprotein; 
+	int kill_rate_index = cancer_immune_indices.kill_rate; 
 	
-	static double oncoprotein_saturation = cancer_immune_options.oncoprotein_saturation;
+	double oncoprotein_saturation = cancer_immune_options.oncoprotein_saturation;
 		// 2.0; 
-	static double oncoprotein_threshold = cancer_immune_options.oncoprotein_detection_threshold;
+	double oncoprotein_threshold = cancer_immune_options.oncoprotein_detection_threshold;
 		// 0.5; // 0.1; 
-	static double oncoprotein_difference = oncoprotein_saturation - oncoprotein_threshold;
+	double oncoprotein_difference = oncoprotein_saturation - oncoprotein_threshold;
 	
 	// new 
 	if( pTarget->custom_data[oncoprotein_i] < oncoprotein_threshold )
@@ -691,7 +725,7 @@ bool immune_cell_attempt_apoptosis( Cell* pAttacker, Cell* pTarget, double dt )
 
 bool immune_cell_trigger_apoptosis( Cell* pAttacker, Cell* pTarget )
 {
-	static int apoptosis_model_index = pTarget->phenotype.death.find_death_model_index( "apoptosis" );	
+	int apoptosis_model_index = pTarget->phenotype.death.find_death_model_index( "apoptosis" );	
 	
 	// if the Target cell is already dead, don't bother!
 	if( pTarget->phenotype.death.dead == true )
@@ -703,7 +737,7 @@ bool immune_cell_trigger_apoptosis( Cell* pAttacker, Cell* pTarget )
 
 void immune_cell_rule( Cell* pCell, Phenotype& phenotype, double dt )
 {
-	static int attach_lifetime_i = pCell->custom_data.find_variable_index( "attachment lifetime" ); 
+	int attach_lifetime_i = cancer_immune_indices.attachment_lifetime; 
 	
 	if( phenotype.death.dead == true )
 	{
@@ -737,8 +771,8 @@ void immune_cell_rule( Cell* pCell, Phenotype& phenotype, double dt )
 	
 		// detach if pulled too far apart 
 		
-		std::vector<double> displacement = pCell->position - pCell->state.neighbors[0]->position;
-		static double detachment_distance_squared = cancer_immune_options.break_adhesion_distance * cancer_immune_options.break_adhesion_distance; 
+		Vec3 displacement = pCell->position - pCell->state.neighbors[0]->position;
+		double detachment_distance_squared = cancer_immune_options.break_adhesion_distance * cancer_immune_options.break_adhesion_distance; 
 		if( norm_squared(displacement) > detachment_distance_squared )
 		{ detach_me = true; }
 		
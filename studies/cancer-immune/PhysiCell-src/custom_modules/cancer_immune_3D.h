@@ -81,6 +81,25 @@ class Cancer_Immune_Options
 
 extern Cancer_Immune_Options cancer_immune_options; 
 
+// substrate and custom data indices read by the cell rules below, resolved once by 
+// create_cell_types() instead of by name on every call 
+class Cancer_Immune_Indices
+{
+ public:
+	int oxygen; 
+	int immunostimulatory_factor; 
+	
+	int oncoprotein; 
+	int kill_rate; 
+	int attachment_lifetime; 
+	int attachment_rate; 
+	
+	Cancer_Immune_Indices(); 
+	void resolve( Microenvironment& M , Custom_Cell_Data& custom_data ); 
+};
+
+extern Cancer_Immune_Indices cancer_immune_indices; 
+
 // custom cell phenotype function to scale immunostimulatory factor with hypoxia 
 void tumor_cell_phenotype_with_and_immune_stimulation( Cell* pCell, Phenotype& phenotype, double dt ); 
 
@@ -83,52 +83,92 @@ using namespace PhysiCell;
 // set number of threads for OpenMP (parallel computing)
 int omp_num_threads = 8; // set this to # of CPU cores x 2 (for hyperthreading)
 
+bool detailed_output = false; 
+int rand_seed = 0; 
+std::vector<std::string> simulation_parameters; // the 9 values above, as given 
+
+// time setup 
+double t = 0.0; // current simulation time 
+
+double immune_activation_time = 60 * 24 * 14; // activate immune response at 14 days 
+
+double t_output_interval = 60; // 5; // output once per hour 
+double t_max = immune_activation_time + 60*24*7;  // activation time + one week
+double t_next_output_time = t; 
+int output_index = 0; // used for creating unique output filenames 	
+bool immune_cells_introduced = false; 
+
+// ensemble (parameter sweep) mode 
+std::vector< std::vector<std::string> > ensemble_parameters; 
+int ensemble_omp_num_threads = 0; // 0: use the thread count on each parameter line 
+
+// the pre-immune phase of an ensemble stops at immune activation and saves its state here, 
+// and the ensemble members resume from it 
+std::string pre_immune_snapshot_filename = "pre_immune_snapshot.bin"; 
+bool stop_at_immune_activation = false; 
+bool resume_from_snapshot = false; 
+
+// checkpoint/restart 
+double t_checkpoint_interval = 0.0; // 0: no periodic checkpoints 
+double t_next_checkpoint_time = 0.0; 
+std::string checkpoint_filename = "checkpoint.bin"; 
+std::string restart_filename = ""; 
+
+// output settings (see Output_Policy) 
+std::string settings_filename = "./config/PhysiCell_settings.xml"; 
+
+void print_usage( void ); 
+bool parse_options( int argc , char* argv[] , int first ); 
+bool apply_parameters( std::vector<std::string>& parameters ); 
+void setup_simulation( void ); 
+int run_simulation( void ); 
+bool save_simulation_snapshot( std::string filename ); 
+bool load_simulation_snapshot( std::string filename ); 
+int run_parameter_ensemble( std::string filename ); 
+int run_pre_immune_phase( void ); 
+int run_ensemble_member_simulation( int run_index ); 
+
 int main( int argc, char* argv[] )
 {
 	/* Process command line options here */
 	
-	bool detailed_output = false; 
-	
-	// time setup 
-	std::string time_units = "min"; 
-	double t = 0.0; // current simulation time 
-
-	double immune_activation_time = 60 * 24 * 14; // activate immune response at 14 days 
-	
-	double t_output_interval = 60; // 5; // output once per hour 
-	double t_max = immune_activation_time + 60*24*7;  // activation time + one week
-	double t_next_output_time = t; 
-	int output_index = 0; // used for creating unique output filenames 	
+	if( argc >= 3 && std::string( argv[1] ) == "--ensemble" )
+	{
+		int first = 3; 
+		if( argc > first && argv[first][0] != '-' )
+		{ default_ensemble_options.max_concurrent_runs = strtol( argv[first++] , NULL , 10 ); }
+		if( argc > first && argv[first][0] != '-' )
+		{ ensemble_omp_num_threads = strtol( argv[first++] , NULL , 10 ); }
+		if( !parse_options( argc , argv , first ) || restart_filename.size() > 0 )
+		{
+			print_usage(); 
+			return -1; 
+		}
+		return run_parameter_ensemble( argv[2] ); 
+	}
 	
+	if( argc == 3 && std::string( argv[1] ) == "--cell-frames-to-text" )
+	{
+		int number_of_frames = convert_cell_frames_to_text( argv[2] , 1000 ); 
+		if( number_of_frames < 0 )
+		{ return -1; }
+		std::cout << "wrote " << number_of_frames << " frames to output/" << std::endl; 
+		return 0; 
+	}
 	
-	if( argc != 10 )
+	if( argc < 10 )
 	{
-		std::cout << "use: " << std::endl  
-		<< "cancer-immune-EMEWS [attachment_rate] [attachment_lifetime] ... " << std::endl  
-		
-		<< "\t[oncoprotein_detection_threshold] [oncoprotein_saturation]" << std::endl << std::endl  
-		
-		<< "\t[migration_bias] [kill_rate]" << std::endl << std::endl  
-		
-		<< "\t[detailed_output (0 or 1)] [omp_num_threads] [random seed value]" << std::endl << std::endl  
-		
-		<< "Good defaults: " << std::endl 
-		<< "cancer-immune-EMEWS  0.2 60.0  0.5 2.0  0.5 0.067  0 8 0" << std::endl << std::endl; 
-
+		print_usage(); 
 		return -1; 
 	}
-	cancer_immune_options.attachment_rate = strtod( argv[1] , NULL ); 			
-	cancer_immune_options.attachment_lifetime = strtod( argv[2] , NULL ); 			
-
-	cancer_immune_options.oncoprotein_detection_threshold = strtod( argv[3] , NULL ); 			
-	cancer_immune_options.oncoprotein_saturation = strtod( argv[4] , NULL ); 		
-
-	cancer_immune_options.migration_bias = strtod( argv[5] , NULL ); 			
-	cancer_immune_options.kill_rate = strtod( argv[6] , NULL ); 			
+	std::vector<std::string> parameters( argv+1 , argv+10 ); 
+	apply_parameters( parameters ); 
 	
-	detailed_output = (bool) strtol( argv[7] , NULL , 10 ); 			
-	omp_num_threads = strtol( argv[8] , NULL , 10 ); 
-	int rand_seed = strtol( argv[9] , NULL , 10 ); 
+	if( !parse_options( argc , argv , 10 ) )
+	{
+		print_usage(); 
+		return -1; 
+	}
 	
 	// OpenMP setup
 	omp_set_num_threads(omp_num_threads);
@@ -141,6 +181,137 @@ int main( int argc, char* argv[] )
 	
 	/* end of processing command line options */ 
 
+	setup_simulation(); 
+	
+	// continue a previous run: its checkpoint replaces the freshly set up tissue 
+	if( restart_filename.size() > 0 )
+	{
+		if( load_simulation_snapshot( restart_filename ) == false )
+		{ return -1; }
+		std::cout << "restarting from " << restart_filename << " at t = " << t << " min" << std::endl; 
+		resume_from_snapshot = true; 
+		
+		// keep the cell frames written before the checkpoint 
+		FILE* fp = fopen( cell_output_options.binary_frames_filename.c_str() , "rb" ); 
+		if( fp != NULL )
+		{
+			fclose( fp ); 
+			cell_output_options.continue_binary_frames = 
+				truncate_cell_frames( cell_output_options.binary_frames_filename , t ); 
+		}
+	}
+	
+	return run_simulation(); 
+}
+
+void print_usage( void )
+{
+	std::cout << "use: " << std::endl  
+	<< "cancer-immune-EMEWS [attachment_rate] [attachment_lifetime] ... " << std::endl  
+	
+	<< "\t[oncoprotein_detection_threshold] [oncoprotein_saturation]" << std::endl << std::endl  
+	
+	<< "\t[migration_bias] [kill_rate]" << std::endl << std::endl  
+	
+	<< "\t[detailed_output (0 or 1)] [omp_num_threads] [random seed value]" << std::endl << std::endl  
+	
+	<< "Good defaults: " << std::endl 
+	<< "cancer-immune-EMEWS  0.2 60.0  0.5 2.0  0.5 0.067  0 8 0" << std::endl << std::endl
+	
+	<< "optionally followed by: " << std::endl 
+	<< "\t--checkpoint [interval (min)]   save the full state to " << checkpoint_filename << " this often" << std::endl 
+	<< "\t--restart [checkpoint file]     continue the run saved there (same 9 values)" << std::endl 
+	<< "\t--settings [file]               read the <save> output settings (default: " << settings_filename << ", if present)" << std::endl 
+	<< "\t--fused-sources                 apply cell secretion/uptake inside the diffusion solver (faster," << std::endl 
+	<< "\t                                but the results differ slightly; a restart needs the same choice)" << std::endl 
+	<< "\t--output [name]=[N, on, or off]  write that output at every N-th output time, e.g., svg=10 or pov=on" << std::endl 
+	<< "\t                                (svg, cell_frames, pov, cell_report, multicellds, simulation_report," << std::endl 
+	<< "\t                                initial_and_final, multicellds_cell_data)" << std::endl << std::endl 
+	
+	<< "or, to convert the binary cell frames (output/cells.bin) to the .pov and .txt files: " << std::endl 
+	<< "cancer-immune-EMEWS --cell-frames-to-text [cell frame file]" << std::endl << std::endl 
+	
+	<< "or, to run every line of a parameter file (one run per line, same 9 values): " << std::endl 
+	<< "cancer-immune-EMEWS --ensemble [parameter file] [max concurrent runs] [omp_num_threads per run]" << std::endl 
+	<< "\t(optionally followed by --checkpoint, --settings, --fused-sources, and --output)" << std::endl << std::endl; 
+	
+	return; 
+}
+
+bool parse_options( int argc , char* argv[] , int first )
+{
+	// the settings file comes first, so that the command line can override it 
+	bool settings_given = false; 
+	for( int i=first; i+1 < argc ; i++ )
+	{
+		if( std::string( argv[i] ) == "--settings" )
+		{
+			settings_filename = argv[i+1]; 
+			settings_given = true; 
+		}
+	}
+	FILE* fp = fopen( settings_filename.c_str() , "r" ); 
+	if( fp != NULL )
+	{
+		fclose( fp ); 
+		if( !output_policy.read_from_xml( settings_filename ) )
+		{ return false; }
+	}
+	else if( settings_given )
+	{
+		std::cout << "Error: could not open " << settings_filename << std::endl; 
+		return false; 
+	}
+	
+	for( int i=first; i < argc ; i++ )
+	{
+		std::string option = argv[i]; 
+		if( option == "--checkpoint" && i+1 < argc )
+		{ t_checkpoint_interval = strtod( argv[++i] , NULL ); }
+		else if( option == "--restart" && i+1 < argc )
+		{ restart_filename = argv[++i]; }
+		else if( option == "--settings" && i+1 < argc )
+		{ i++; }
+		else if( option == "--fused-sources" )
+		{ default_microenvironment_options.fused_cell_sources_and_sinks = true; }
+		else if( option == "--output" && i+1 < argc )
+		{
+			std::string setting = argv[++i]; 
+			size_t equals = setting.find( '=' ); 
+			if( equals == std::string::npos || 
+				!output_policy.set( setting.substr( 0 , equals ) , setting.substr( equals+1 ) ) )
+			{ return false; }
+		}
+		else
+		{ return false; }
+	}
+	return true; 
+}
+
+bool apply_parameters( std::vector<std::string>& parameters )
+{
+	if( parameters.size() != 9 )
+	{ return false; }
+	simulation_parameters = parameters; 
+	
+	cancer_immune_options.attachment_rate = strtod( parameters[0].c_str() , NULL ); 			
+	cancer_immune_options.attachment_lifetime = strtod( parameters[1].c_str() , NULL ); 			
+
+	cancer_immune_options.oncoprotein_detection_threshold = strtod( parameters[2].c_str() , NULL ); 			
+	cancer_immune_options.oncoprotein_saturation = strtod( parameters[3].c_str() , NULL ); 		
+
+	cancer_immune_options.migration_bias = strtod( parameters[4].c_str() , NULL ); 			
+	cancer_immune_options.kill_rate = strtod( parameters[5].c_str() , NULL ); 			
+	
+	detailed_output = (bool) strtol( parameters[6].c_str() , NULL , 10 ); 			
+	omp_num_threads = strtol( parameters[7].c_str() , NULL , 10 ); 
+	rand_seed = strtol( parameters[8].c_str() , NULL , 10 ); 
+	
+	return true; 
+}
+
+void setup_simulation( void )
+{
 	/* Microenvironment setup */ 
 
 	setup_microenvironment(); 
@@ -150,27 +321,39 @@ int main( int argc, char* argv[] )
 	// set mechanics voxel size, and match the data structure to BioFVM
 
 	double mechanics_voxel_size = 30; 
-	Cell_Container* cell_container = create_cell_container_for_microenvironment( microenvironment, mechanics_voxel_size );
+	create_cell_container_for_microenvironment( microenvironment, mechanics_voxel_size );
 
 	create_cell_types();
 
 	setup_tissue();
+	
+	// the cell definitions that snapshots need to know (cell_defaults is implied) 
+	register_snapshot_cell_definition( immune_cell ); 
 
 	/* Users typically start modifying here. START USERMODS */ 
 
 
 	/* Users typically stop modifying here. END USERMODS */ 
 	
+	return; 
+}
+
+int run_simulation( void )
+{
+	std::string time_units = "min"; 
+	
 	// set MultiCellDS save options 
 
 	set_save_biofvm_mesh_as_matlab( true ); 
 	set_save_biofvm_data_as_matlab( true ); 
-	set_save_biofvm_cell_data( true ); 
+	set_save_biofvm_cell_data( output_policy.MultiCellDS_cell_data ); 
 	set_save_biofvm_cell_data_as_custom_matlab( true );
-
-	// save a simulation snapshot 
-
-	save_PhysiCell_to_MultiCellDS_xml_pugi( "initial" , microenvironment , t ); 
+	
+	// detailed output: save MultiCellDS at every output time, unless the 
+	// output settings already give it a cadence 
+	if( detailed_output == true && output_policy.MultiCellDS.enabled() == false )
+	{ output_policy.MultiCellDS.interval = 1; }
+	output_policy.display( std::cout ); 
 
 	// save a quick SVG cross section through z = 0, after setting its 
 	// length bar to 200 microns 
@@ -181,15 +364,35 @@ int main( int argc, char* argv[] )
 	
 	std::vector<std::string> (*cell_coloring_function)(Cell*) = cancer_immune_coloring_function;
 	
-	SVG_plot( "initial.svg" , microenvironment, 0.0 , t, cell_coloring_function );
+	// format and write the SVG and text outputs on a background thread 
+	
+	output_writer.enabled = true; 
+	
+	// save a simulation snapshot (unless resuming from a saved state) 
+
+	if( resume_from_snapshot == false && output_policy.initial_and_final )
+	{
+		save_PhysiCell_to_MultiCellDS_xml_pugi( "initial" , microenvironment , t ); 
+		SVG_plot( "initial.svg" , microenvironment, 0.0 , t, cell_coloring_function );
+	}
 	
 	// set the performance timers 
 
 	BioFVM::RUNTIME_TIC();
 	BioFVM::TIC();
 	
-	std::ofstream report_file ("simulation_report.txt"); 	// create the data log file 
-	report_file<<"simulated time\tnum cells\tnum division\tnum death\twall time"<<std::endl;
+	std::ofstream report_file; 
+	if( output_policy.simulation_report.enabled() == false )
+	{ } // no data log file 
+	else if( restart_filename.size() > 0 )
+	{ report_file.open( "simulation_report.txt" , std::ios::app ); } // continue the data log file 
+	else
+	{
+		report_file.open( "simulation_report.txt" ); 	// create the data log file 
+		report_file<<"simulated time\tnum cells\tnum division\tnum death\twall time"<<std::endl;
+	}
+	
+	t_next_checkpoint_time = t + t_checkpoint_interval; 
 	
 	// main loop 
 	
@@ -197,22 +400,44 @@ int main( int argc, char* argv[] )
 	{	
 		while( t < t_max + 0.1*diffusion_dt )
 		{
+			// the pre-immune phase of an ensemble ends here 
+			if( stop_at_immune_activation && t > immune_activation_time - 0.01*diffusion_dt )
+			{
+				report_file.close(); 
+				output_writer.finish(); 
+				if( save_simulation_snapshot( pre_immune_snapshot_filename ) == false )
+				{ return -1; }
+				std::cout << "saved the state at immune activation (t = " << t << " " << time_units 
+					<< ") to " << pre_immune_snapshot_filename << std::endl; 
+				return 0; 
+			}
+			
+			// save a checkpoint if it's time (before this step's output, which a restart repeats) 
+			if( t_checkpoint_interval > 0.0 && t > t_next_checkpoint_time - 0.01*diffusion_dt )
+			{
+				if( save_simulation_snapshot( checkpoint_filename ) )
+				{ std::cout << "saved checkpoint " << checkpoint_filename << " at t = " << t << " " << time_units << std::endl; }
+				t_next_checkpoint_time += t_checkpoint_interval; 
+			}
+			
 			// save data if it's time. 
 			if(  fabs( t - t_next_output_time ) < 0.01 * diffusion_dt )
 			{
 				log_output(t, output_index, microenvironment, report_file);
 				
 				char filename[1024]; 
-				if( detailed_output == true )
+				if( output_policy.MultiCellDS.due( output_index ) )
 				{
 					sprintf( filename , "output%08u" , output_index ); 
 					save_PhysiCell_to_MultiCellDS_xml_pugi( filename , microenvironment , t ); 
 				}
-				 
-				sprintf( filename , "snapshot%08u.svg" , output_index ); 
-				SVG_plot( filename , microenvironment, 0.0 , t, cell_coloring_function );
 				
-				static bool immune_cells_introduced = false; 
+				if( output_policy.SVG.due( output_index ) )
+				{
+					sprintf( filename , "snapshot%08u.svg" , output_index ); 
+					SVG_plot( filename , microenvironment, 0.0 , t, cell_coloring_function );
+				}
+				
 				if( t > immune_activation_time - 0.01*diffusion_dt && immune_cells_introduced == false )
 				{
 					immune_cells_introduced = true; 
@@ -225,7 +450,8 @@ int main( int argc, char* argv[] )
 			}
 			// update the microenvironment
 			microenvironment.simulate_diffusion_decay( diffusion_dt );
-			if( default_microenvironment_options.calculate_gradients )
+			if( default_microenvironment_options.calculate_gradients && 
+				default_microenvironment_options.calculate_gradients_on_demand == false )
 			{ microenvironment.compute_all_gradient_vectors(); }
 			
 			// run PhysiCell 
@@ -243,8 +469,12 @@ int main( int argc, char* argv[] )
 	
 	// save a final simulation snapshot 
 	
-	save_PhysiCell_to_MultiCellDS_xml_pugi( "final" , microenvironment , t ); 
-	SVG_plot( "final.svg" , microenvironment, 0.0 , t, cell_coloring_function );
+	if( output_policy.initial_and_final )
+	{
+		save_PhysiCell_to_MultiCellDS_xml_pugi( "final" , microenvironment , t ); 
+		SVG_plot( "final.svg" , microenvironment, 0.0 , t, cell_coloring_function );
+	}
+	output_writer.finish(); 
 	
 	// timer 
 	
@@ -253,3 +483,147 @@ int main( int argc, char* argv[] )
 
 	return 0; 
 }
+
+int run_parameter_ensemble( std::string filename )
+{
+	std::vector<std::string> lines = read_ensemble_parameter_lines( filename ); 
+	for( int n=0; n < lines.size() ; n++ )
+	{
+		std::vector<std::string> parameters = split_parameter_line( lines[n] ); 
+		if( parameters.size() != 9 )
+		{
+			std::cout << "Error: line " << n+1 << " of " << filename << " does not have 9 values" << std::endl; 
+			return -1; 
+		}
+		ensemble_parameters.push_back( parameters ); 
+	}
+	if( ensemble_parameters.size() == 0 )
+	{
+		print_usage(); 
+		return -1; 
+	}
+	
+	// The microenvironment and the initial tumor do not depend on the swept 
+	// parameters (create_cell_types() reseeds the PRNG before placing cells), 
+	// so set them up once here. Each ensemble member is forked from this 
+	// process and shares its state copy-on-write. Stay on one OpenMP 
+	// thread until then: libgomp cannot be used after fork() once it has 
+	// started a thread team. 
+	
+	apply_parameters( ensemble_parameters[0] ); 
+	omp_set_num_threads( 1 ); 
+	SeedRandom( rand_seed ); 
+	
+	setup_simulation(); 
+	
+	// Nor does anything before immune activation. Simulate that once, in a child process 
+	// (so that this one never starts OpenMP threads), save the state at activation, and 
+	// restore it here. Each member then starts from the restored state. 
+	
+	std::string pre_immune_directory = default_ensemble_options.run_directory_prefix + "pre_immune"; 
+	std::cout << "simulating the pre-immune phase in " << pre_immune_directory << std::endl; 
+	if( run_in_forked_process( pre_immune_directory , run_pre_immune_phase , default_ensemble_options ) != 0 || 
+		load_simulation_snapshot( pre_immune_directory + "/" + pre_immune_snapshot_filename ) == false )
+	{
+		std::cout << "Error: the pre-immune phase failed" << std::endl; 
+		return -1; 
+	}
+	resume_from_snapshot = true; 
+	
+	std::cout << "running " << ensemble_parameters.size() << " simulations from " << filename 
+		<< " (" << default_ensemble_options.max_concurrent_runs << " at a time) from t = " << t << " min" << std::endl; 
+	
+	int failures = run_ensemble( ensemble_parameters.size() , run_ensemble_member_simulation , default_ensemble_options ); 
+	
+	std::cout << ensemble_parameters.size() - failures << " of " << ensemble_parameters.size() 
+		<< " simulations completed" << std::endl; 
+	
+	if( failures > 0 )
+	{ return -1; }
+	return 0; 
+}
+
+int run_ensemble_member_simulation( int run_index )
+{
+	apply_parameters( ensemble_parameters[run_index] ); 
+	if( ensemble_omp_num_threads > 0 )
+	{ omp_num_threads = ensemble_omp_num_threads; }
+	omp_set_num_threads( omp_num_threads ); 
+	
+	std::cout << "parameters: "; 
+	for( int i=0; i < ensemble_parameters[run_index].size() ; i++ )
+	{ std::cout << ensemble_parameters[run_index][i] << " "; }
+	std::cout << std::endl; 
+	
+	// the immune cell definition is the only part of the setup 
+	// that depends on the swept parameters 
+	create_immune_cell_type(); 
+	
+	return run_simulation(); 
+}
+
+int run_pre_immune_phase( void )
+{
+	if( ensemble_omp_num_threads > 0 )
+	{ omp_num_threads = ensemble_omp_num_threads; }
+	omp_set_num_threads( omp_num_threads ); 
+	
+	stop_at_immune_activation = true; 
+	return run_simulation(); 
+}
+
+bool save_simulation_snapshot( std::string filename )
+{
+	Snapshot_Buffer buffer; 
+	if( write_simulation_snapshot( buffer , microenvironment , t ) == false )
+	{ return false; }
+	
+	// main loop state 
+	buffer.write_value( t_output_interval ); 
+	buffer.write_value( t_next_output_time ); 
+	buffer.write_value( output_index ); 
+	buffer.write_value( immune_cells_introduced ); 
+	
+	buffer.write_value( (int) simulation_parameters.size() ); 
+	for( int i=0; i < simulation_parameters.size() ; i++ )
+	{ buffer.write_string( simulation_parameters[i] ); }
+	
+	return write_checkpoint_file( filename , buffer ); 
+}
+
+bool load_simulation_snapshot( std::string filename )
+{
+	Snapshot_Buffer buffer; 
+	if( read_checkpoint_file( filename , buffer ) == false || 
+		read_simulation_snapshot( buffer , microenvironment , t ) == false )
+	{ return false; }
+	
+	buffer.read_value( t_output_interval ); 
+	buffer.read_value( t_next_output_time ); 
+	buffer.read_value( output_index ); 
+	buffer.read_value( immune_cells_introduced ); 
+	
+	// the snapshot only continues the same model: all values but the thread count must match 
+	int number_of_parameters = 0; 
+	buffer.read_value( number_of_parameters ); 
+	bool parameters_match = ( number_of_parameters == simulation_parameters.size() ); 
+	for( int i=0; i < number_of_parameters && buffer.read_failed == false ; i++ )
+	{
+		std::string value; 
+		buffer.read_string( value ); 
+		if( i != 7 && ( i >= simulation_parameters.size() || 
+			strtod( value.c_str() , NULL ) != strtod( simulation_parameters[i].c_str() , NULL ) ) )
+		{ parameters_match = false; }
+	}
+	if( buffer.read_failed )
+	{
+		std::cout << "Error: truncated simulation state in " << filename << std::endl; 
+		return false; 
+	}
+	if( parameters_match == false )
+	{
+		std::cout << "Error: " << filename << " was saved with different parameters" << std::endl; 
+		return false; 
+	}
+	return true; 
+}
@@ -70,7 +70,7 @@ void add_PhysiCell_cell_to_open_xml_pugi(  pugi::xml_document& xml_dom, Cell& C
 
 void add_PhysiCell_cells_to_open_xml_pugi( pugi::xml_document& xml_dom, std::string filename_base, Microenvironment& M  )
 {
-	static double temp_zero = 0.0; 
+	double temp_zero = 0.0; 
 	
 	if( BioFVM::save_cell_data == false )
 	{ return; }
@@ -82,21 +82,14 @@ void add_PhysiCell_cells_to_open_xml_pugi( pugi::xml_document& xml_dom, std::str
 	// Let's reduce memory allocations and sprintf calls. 
 	// This reduces execution time by around 30%. (e.g., write time for 1,000,000 cells decreases from 
 	// 45 to 30 seconds on an older machine. 
-	static char* temp; 
-	static bool initialized = false; 
+	char temp [1024]; 
 	
-	static char rate_chars [1024]; 
-	static char volume_chars [1024]; 
-	static char diffusion_chars [1024]; 
-	if( !initialized )
-	{ 
-		temp = new char [1024]; 
-		initialized = true; 
-		
-		sprintf( rate_chars, "1/%s" , M.time_units.c_str() ); 
-		sprintf( volume_chars, "%s^3" , M.spatial_units.c_str() ); 
-		sprintf( diffusion_chars , "%s^2/%s", M.spatial_units.c_str() , M.time_units.c_str() ); 
-	}
+	char rate_chars [1024]; 
+	char volume_chars [1024]; 
+	char diffusion_chars [1024]; 
+	sprintf( rate_chars, "1/%s" , M.time_units.c_str() ); 
+	sprintf( volume_chars, "%s^3" , M.spatial_units.c_str() ); 
+	sprintf( diffusion_chars , "%s^2/%s", M.spatial_units.c_str() , M.time_units.c_str() ); 
 	
 	node = node.child( "cell_populations" ); 
 	if( !node )
@@ -0,0 +1,160 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#include "./PhysiCell_async_output.h"
+
+namespace PhysiCell{
+
+Async_Output_Writer output_writer; 
+
+Async_Output_Writer::Async_Output_Writer()
+{
+	worker_running = false; 
+	job_in_progress = false; 
+	stopping = false; 
+	
+	enabled = false; 
+	max_queued_jobs = 2; 
+	
+	return; 
+}
+
+Async_Output_Writer::~Async_Output_Writer()
+{
+	finish(); 
+	if( worker_running )
+	{
+		{
+			std::lock_guard<std::mutex> lock( queue_mutex ); 
+			stopping = true; 
+		}
+		queue_changed.notify_all(); 
+		worker.join(); 
+	}
+	return; 
+}
+
+void Async_Output_Writer::run( void )
+{
+	while( true )
+	{
+		std::function<void(void)> job; 
+		{
+			std::unique_lock<std::mutex> lock( queue_mutex ); 
+			while( jobs.empty() && !stopping )
+			{ queue_changed.wait( lock ); }
+			if( jobs.empty() )
+			{ return; }
+			job = jobs.front(); 
+			jobs.pop_front(); 
+			job_in_progress = true; 
+		}
+		queue_changed.notify_all(); 
+		
+		job(); 
+		
+		{
+			std::lock_guard<std::mutex> lock( queue_mutex ); 
+			job_in_progress = false; 
+		}
+		queue_changed.notify_all(); 
+	}
+}
+
+void Async_Output_Writer::submit( std::function<void(void)> job )
+{
+	if( !enabled )
+	{
+		job(); 
+		return; 
+	}
+	
+	std::unique_lock<std::mutex> lock( queue_mutex ); 
+	if( !worker_running )
+	{
+		stopping = false; 
+		worker = std::thread( &Async_Output_Writer::run , this ); 
+		worker_running = true; 
+	}
+	
+	// back-pressure: wait for room in the queue 
+	int max_queued = max_queued_jobs > 1 ? max_queued_jobs : 1; 
+	while( jobs.size() >= max_queued )
+	{ queue_changed.wait( lock ); }
+	
+	jobs.push_back( job ); 
+	lock.unlock(); 
+	queue_changed.notify_all(); 
+	return; 
+}
+
+void Async_Output_Writer::finish( void )
+{
+	std::unique_lock<std::mutex> lock( queue_mutex ); 
+	while( !jobs.empty() || job_in_progress )
+	{ queue_changed.wait( lock ); }
+	return; 
+}
+
+};
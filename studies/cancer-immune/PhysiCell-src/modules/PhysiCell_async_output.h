@@ -0,0 +1,122 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#ifndef __PhysiCell_async_output_h__
+#define __PhysiCell_async_output_h__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace PhysiCell{
+
+/* 
+   Runs output jobs (formatting and writing files) on a background thread, 
+   so that the next simulation steps can proceed while they are written. 
+   A job must only use data it owns: the caller stages a copy of whatever 
+   it needs from the cells and the microenvironment before submitting it 
+   (see stage_cell_records() and stage_SVG_plot()). 
+   
+   At most max_queued_jobs jobs wait at a time. submit() blocks while the 
+   queue is full, so a slow disk slows the simulation down instead of 
+   letting staged copies pile up in memory. 
+   
+   While enabled is false (the default), submit() runs each job right away 
+   on the calling thread. The thread is started by the first submitted job, 
+   so a process that is later forked (e.g., an ensemble driver) never owns 
+   it. Call finish() before relying on the files, and before exiting. 
+*/ 
+
+class Async_Output_Writer
+{
+ private:
+	std::thread worker; 
+	bool worker_running; 
+	std::mutex queue_mutex; 
+	std::condition_variable queue_changed; 
+	std::deque< std::function<void(void)> > jobs; 
+	bool job_in_progress; 
+	bool stopping; 
+	
+	void run( void ); 
+	
+ public:
+	bool enabled; 
+	int max_queued_jobs; 
+	
+	Async_Output_Writer(); 
+	~Async_Output_Writer(); 
+	
+	void submit( std::function<void(void)> job ); 
+	// waits until every submitted job is written 
+	void finish( void ); 
+};
+
+extern Async_Output_Writer output_writer; 
+
+};
+
+#endif
@@ -0,0 +1,260 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "./PhysiCell_ensemble.h"
+
+namespace PhysiCell{
+
+Ensemble_Options::Ensemble_Options()
+{
+	max_concurrent_runs = 1; 
+	run_directory_prefix = "run_"; 
+	redirect_output = true; 
+	
+	return; 
+}
+
+Ensemble_Options default_ensemble_options; 
+
+std::vector<std::string> read_ensemble_parameter_lines( std::string filename )
+{
+	std::vector<std::string> output; 
+	
+	std::ifstream input( filename.c_str() , std::ios::in ); 
+	if( !input )
+	{
+		std::cout << "Error: could not open ensemble parameter file " << filename << std::endl; 
+		return output; 
+	}
+	
+	std::string line; 
+	while( std::getline( input , line ) )
+	{
+		// skip blank lines and comments 
+		size_t first = line.find_first_not_of( " \t\r" ); 
+		if( first == std::string::npos || line[first] == '#' )
+		{ continue; }
+		output.push_back( line ); 
+	}
+	
+	return output; 
+}
+
+std::vector<std::string> split_parameter_line( std::string line )
+{
+	std::vector<std::string> output; 
+	std::istringstream stream( line ); 
+	std::string token; 
+	while( stream >> token )
+	{ output.push_back( token ); }
+	return output; 
+}
+
+std::string ensemble_run_directory( int run_index , Ensemble_Options& options )
+{
+	char suffix[64]; 
+	sprintf( suffix , "%04d" , run_index ); 
+	return options.run_directory_prefix + suffix; 
+}
+
+bool enter_run_directory( std::string directory , Ensemble_Options& options )
+{
+	// log_output() writes into output/ relative to the working directory 
+	mkdir( directory.c_str() , 0755 ); 
+	if( chdir( directory.c_str() ) != 0 )
+	{
+		std::cout << "Error: could not enter run directory " << directory << std::endl; 
+		return false; 
+	}
+	mkdir( "output" , 0755 ); 
+	
+	if( options.redirect_output && freopen( "stdout.txt" , "w" , stdout ) == NULL )
+	{ std::cout << "Warning: could not redirect output in " << directory << std::endl; }
+	
+	return true; 
+}
+
+int wait_for_ensemble_member( std::vector<pid_t>& pids )
+{
+	int status = 0; 
+	pid_t pid = wait( &status ); 
+	if( pid < 0 )
+	{ return 0; }
+	
+	int run_index = -1; 
+	for( int i=0 ; i < pids.size() ; i++ )
+	{
+		if( pids[i] == pid )
+		{ run_index = i; }
+	}
+	
+	if( WIFEXITED(status) && WEXITSTATUS(status) == 0 )
+	{
+		std::cout << "ensemble member " << run_index << " finished" << std::endl; 
+		return 0; 
+	}
+	
+	std::cout << "Error: ensemble member " << run_index << " failed ("; 
+	if( WIFSIGNALED(status) )
+	{ std::cout << "signal " << WTERMSIG(status) << ")" << std::endl; }
+	else
+	{ std::cout << "exit code " << WEXITSTATUS(status) << ")" << std::endl; }
+	return 1; 
+}
+
+int run_ensemble( int number_of_runs , int (*run_function)(int) , Ensemble_Options& options )
+{
+	std::vector<pid_t> pids( number_of_runs , -1 ); 
+	int number_running = 0; 
+	int failures = 0; 
+	
+	int max_concurrent = options.max_concurrent_runs; 
+	if( max_concurrent < 1 )
+	{ max_concurrent = 1; }
+	
+	for( int n=0 ; n < number_of_runs ; n++ )
+	{
+		while( number_running >= max_concurrent )
+		{
+			failures += wait_for_ensemble_member( pids ); 
+			number_running--; 
+		}
+		
+		// don't let the child inherit (and later repeat) unflushed output 
+		std::cout.flush(); 
+		fflush( NULL ); 
+		
+		pid_t pid = fork(); 
+		if( pid < 0 )
+		{
+			std::cout << "Error: could not start ensemble member " << n << std::endl; 
+			failures++; 
+			continue; 
+		}
+		if( pid == 0 )
+		{
+			int result = -1; 
+			if( enter_run_directory( ensemble_run_directory( n , options ) , options ) )
+			{ result = run_function( n ); }
+			std::cout.flush(); 
+			fflush( NULL ); 
+			_exit( result == 0 ? 0 : 1 ); 
+		}
+		
+		pids[n] = pid; 
+		number_running++; 
+		std::cout << "started ensemble member " << n << " in " 
+			<< ensemble_run_directory( n , options ) << std::endl; 
+	}
+	
+	while( number_running > 0 )
+	{
+		failures += wait_for_ensemble_member( pids ); 
+		number_running--; 
+	}
+	
+	return failures; 
+}
+
+int run_in_forked_process( std::string directory , int (*run_function)(void) , Ensemble_Options& options )
+{
+	std::cout.flush(); 
+	fflush( NULL ); 
+	
+	pid_t pid = fork(); 
+	if( pid < 0 )
+	{
+		std::cout << "Error: could not start a process in " << directory << std::endl; 
+		return -1; 
+	}
+	if( pid == 0 )
+	{
+		int result = -1; 
+		if( enter_run_directory( directory , options ) )
+		{ result = run_function(); }
+		std::cout.flush(); 
+		fflush( NULL ); 
+		_exit( result == 0 ? 0 : 1 ); 
+	}
+	
+	int status = 0; 
+	if( waitpid( pid , &status , 0 ) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+	{
+		std::cout << "Error: the process in " << directory << " failed" << std::endl; 
+		return -1; 
+	}
+	return 0; 
+}
+
+};
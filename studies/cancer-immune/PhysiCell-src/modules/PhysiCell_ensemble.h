@@ -0,0 +1,129 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#ifndef __PhysiCell_ensemble_h__
+#define __PhysiCell_ensemble_h__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../core/PhysiCell.h"
+
+namespace PhysiCell{
+
+/* 
+   Runs an ensemble of simulations (e.g., every line of an EMEWS parameter 
+   file) from a single executable. The driver sets up the model once, then 
+   forks one process per ensemble member. Each member starts from a 
+   copy-on-write image of the fully initialized process, so its 
+   microenvironment, all_cells, cell_defaults, options and PRNG state form 
+   a private simulation context without being rebuilt. A shared phase of 
+   the simulation can run once in a separate forked process, save its state 
+   (see PhysiCell_snapshot.h), and be restored in the driver before the 
+   members are forked. 
+   
+   Members are processes, not threads, because the simulation state is 
+   still process-wide: max_basic_agent_ID, all_cells and cell_pool (as well 
+   as microenvironment, cell_defaults and the model options) are globals, 
+   and each Cell_Container's mechanics arena is indexed by the global 
+   all_cells. So N simulations cannot run as N threads of one process. 
+   
+   OpenMP (libgomp) does not survive fork() once it has started a thread 
+   team, so the driver process must run with one OpenMP thread until all 
+   members are forked. Each member may then set its own thread count. 
+*/ 
+
+class Ensemble_Options
+{
+ public:
+	int max_concurrent_runs; // how many members run at once 
+	std::string run_directory_prefix; // member i runs in prefix + i (e.g., run_0003) 
+	bool redirect_output; // send each member's std::cout to stdout.txt in its directory 
+	
+	Ensemble_Options(); 
+};
+
+extern Ensemble_Options default_ensemble_options; 
+
+// one line per ensemble member; blank lines and lines starting with # are skipped 
+std::vector<std::string> read_ensemble_parameter_lines( std::string filename ); 
+std::vector<std::string> split_parameter_line( std::string line ); 
+
+std::string ensemble_run_directory( int run_index , Ensemble_Options& options ); 
+
+// Forks a process for each of number_of_runs members (at most 
+// options.max_concurrent_runs at a time). Each child creates and enters 
+// its run directory, calls run_function( run_index ), and exits with its 
+// return value. Returns the number of members that failed. 
+int run_ensemble( int number_of_runs , int (*run_function)(int) , Ensemble_Options& options ); 
+
+// Runs run_function() in a single forked process inside directory and waits 
+// for it (e.g., a shared phase that the members later resume from). 
+// Returns 0 on success. 
+int run_in_forked_process( std::string directory , int (*run_function)(void) , Ensemble_Options& options ); 
+
+};
+
+#endif
@@ -63,6 +63,9 @@
 */
 
 #include "./PhysiCell_pathology.h"
+#include "./PhysiCell_async_output.h"
+
+#include <memory>
 
 namespace PhysiCell{
 
@@ -71,7 +74,7 @@ PhysiCell_SVG_options_struct PhysiCell_SVG_options;
 // cyto_color, cyto_outline , nuclear_color, nuclear_outline
 std::vector<std::string> simple_cell_coloring( Cell* pCell )
 {
-	static std::vector< std::string > output( 4 , "rgb(0,0,0)" ); 
+	std::vector< std::string > output( 4 , "rgb(0,0,0)" ); 
 	output[0] = "rgb(255,0,0)";
 	output[2] = "rgb(0,0,255)";
 	
@@ -81,7 +84,7 @@ std::vector<std::string> simple_cell_coloring( Cell* pCell )
 // works for any Ki67-based cell cycle model 
 std::vector<std::string> false_cell_coloring_Ki67( Cell* pCell )
 {
-	static std::vector< std::string > output( 4 , "rgb(0,0,0)" );
+	std::vector< std::string > output( 4 , "rgb(0,0,0)" );
     
     // output[0] = cyto_color, output[1] = cyto_outline , output[2] = nuclear_color, output[3] = nuclear_outline
 
@@ -125,7 +128,7 @@ std::vector<std::string> false_cell_coloring_Ki67( Cell* pCell )
 
 std::vector<std::string> false_cell_coloring_live_dead( Cell* pCell )
 {
-	static std::vector< std::string > output( 4 , "rgb(0,0,0)" );
+	std::vector< std::string > output( 4 , "rgb(0,0,0)" );
     
 	// output[0] = cyto_color, output[1] = cyto_outline , output[2] = nuclear_color, output[3] = nuclear_outline
 
@@ -162,7 +165,7 @@ std::vector<double> transmission( std::vector<double>& incoming_light, std::vect
 {
 	double param = thickness * stain / 255.0; 
 
-	static std::vector<double> output( 3, 0.0 );
+	std::vector<double> output( 3, 0.0 );
  
 	for( int i=0; i < 3 ; i++ )
 	{ output[i] = incoming_light[i] * exp( -param * absorb_color[i] ); }
@@ -172,7 +175,7 @@ std::vector<double> transmission( std::vector<double>& incoming_light, std::vect
 
 std::vector<std::string> hematoxylin_and_eosin_cell_coloring( Cell* pCell )
 {
-	static std::vector<std::string> out( 4, "rgb(255,255,255)" );
+	std::vector<std::string> out( 4, "rgb(255,255,255)" );
 	// cyto_color, cyto_outline , nuclear_color, nuclear_outline
 
 	// cytoplasm colors 
@@ -181,12 +184,12 @@ std::vector<std::string> hematoxylin_and_eosin_cell_coloring( Cell* pCell )
 	double solid_fraction = pCell->phenotype.volume.cytoplasmic_solid / (pCell->phenotype.volume.cytoplasmic + 1e-10);
 	double calc_fraction  = pCell->phenotype.volume.calcified_fraction; 
  
-	static double thickness = 20;
+	double thickness = 20;
  
-	static std::vector<double> light( 3, 255.0 ); 
+	std::vector<double> light( 3, 255.0 ); 
  
-	static std::vector<double> eosin_absorb = {2.55,33.15,2.55}; // ( 3 , 3.0 ); // (3,33,3)
-	static std::vector<double> hematoxylin_absorb = {45.90,51.00,20.40}; // ( 3, 45.0 ); // (45,51,20)
+	std::vector<double> eosin_absorb = {2.55,33.15,2.55}; // ( 3 , 3.0 ); // (3,33,3)
+	std::vector<double> hematoxylin_absorb = {45.90,51.00,20.40}; // ( 3, 45.0 ); // (45,51,20)
 /*	
 	static bool setup_done = false; 
 	if( !setup_done )
@@ -198,12 +201,12 @@ std::vector<std::string> hematoxylin_and_eosin_cell_coloring( Cell* pCell )
 	}
 */	
 
-	static std::vector<double> temp( 3, 0.0 );
+	std::vector<double> temp( 3, 0.0 );
  
 	temp = transmission( light, eosin_absorb , thickness , solid_fraction );
 	temp = transmission( temp , hematoxylin_absorb ,thickness, calc_fraction );
  
-	static char szTempString [128]; 
+	char szTempString [128]; 
 	sprintf( szTempString , "rgb(%u,%u,%u)", (int) round( temp[0] ) , (int) round( temp[1] ) , (int) round( temp[2]) ); 
 	out[0].assign( szTempString ); 
 	out[1] = out[0]; 
@@ -224,7 +227,7 @@ std::vector<std::string> hematoxylin_and_eosin_cell_coloring( Cell* pCell )
 
 std::string formatted_minutes_to_DDHHMM( double minutes )
 {
-	static std::string output; 
+	std::string output; 
 	output.resize( 1024 ); 
 	
 	int nMinutes = rint(minutes); // round( minutes ); 
@@ -242,13 +245,53 @@ std::string formatted_minutes_to_DDHHMM( double minutes )
 	return output ;
 }
 
-void SVG_plot( std::string filename , Microenvironment& M, double z_slice , double time, std::vector<std::string> (*cell_coloring_function)(Cell*) )
+void stage_SVG_plot( Staged_SVG_Plot& plot , Microenvironment& M, double z_slice , double time, std::vector<std::string> (*cell_coloring_function)(Cell*) )
+{
+	for( int i=0; i < 6 ; i++ )
+	{ plot.bounding_box[i] = M.mesh.bounding_box[i]; }
+	plot.dx = M.mesh.dx; 
+	plot.dy = M.mesh.dy; 
+	plot.z_slice = z_slice; 
+	plot.time = time; 
+	plot.total_cell_count = all_cells->size(); 
+	plot.options = PhysiCell_SVG_options; 
+	
+	// keep the cells that intersect the slice 
+	plot.cells.clear(); 
+	for( int i=0 ; i < plot.total_cell_count ; i++ )
+	{
+		Cell* pC = (*all_cells)[i]; 
+		if( fabs( (pC->position)[2] - z_slice ) < pC->phenotype.geometry.radius )
+		{
+			Staged_SVG_Cell cell; 
+			cell.ID = pC->ID; 
+			cell.x = (pC->position)[0]; 
+			cell.y = (pC->position)[1]; 
+			cell.z = (pC->position)[2]; 
+			cell.radius = pC->phenotype.geometry.radius; 
+			cell.nuclear_radius = pC->phenotype.geometry.nuclear_radius; 
+			cell.colors = cell_coloring_function( pC ); 
+			plot.cells.push_back( cell ); 
+		}
+	}
+	
+	RUNTIME_TOC(); 
+	plot.formatted_runtime = format_stopwatch_value( runtime_stopwatch_value() );
+	
+	return; 
+}
+
+void write_SVG_plot( std::string filename , Staged_SVG_Plot& plot )
 {
-	double X_lower = M.mesh.bounding_box[0];
-	double X_upper = M.mesh.bounding_box[3];
+	// draw with the options as they were when the plot was staged 
+	PhysiCell_SVG_options_struct& PhysiCell_SVG_options = plot.options; 
+	double z_slice = plot.z_slice; 
+	
+	double X_lower = plot.bounding_box[0];
+	double X_upper = plot.bounding_box[3];
  
-	double Y_lower = M.mesh.bounding_box[1]; 
-	double Y_upper = M.mesh.bounding_box[4]; 
+	double Y_lower = plot.bounding_box[1]; 
+	double Y_upper = plot.bounding_box[4]; 
 
 	double plot_width = X_upper - X_lower; 
 	double plot_height = Y_upper - Y_lower; 
@@ -263,8 +306,8 @@ void SVG_plot( std::string filename , Microenvironment& M, double z_slice , doub
 	// draw the background 
 	Write_SVG_rect( os , 0 , 0 , plot_width, plot_height + top_margin , 0.002 * plot_height , "white", "white" );
 
-	double dx_stroma = M.mesh.dx; 
-	double dy_stroma = M.mesh.dy; 
+	double dx_stroma = plot.dx; 
+	double dy_stroma = plot.dy; 
 	
 	os << " <g id=\"ECM\">" << std::endl; 
   
@@ -332,9 +375,9 @@ void SVG_plot( std::string filename , Microenvironment& M, double z_slice , doub
 	char* szString; 
 	szString = new char [1024]; 
  
-	int total_cell_count = all_cells->size(); 
+	int total_cell_count = plot.total_cell_count; 
  
-	double temp_time = time; 
+	double temp_time = plot.time; 
 
 	std::string time_label = formatted_minutes_to_DDHHMM( temp_time ); 
  
@@ -347,37 +390,31 @@ void SVG_plot( std::string filename , Microenvironment& M, double z_slice , doub
  
 	// plot intersecting cells 
 	os << " <g id=\"cells\">" << std::endl; 
-	for( int i=0 ; i < total_cell_count ; i++ )
+	for( int i=0 ; i < plot.cells.size() ; i++ )
 	{
-		Cell* pC = (*all_cells)[i]; // global_cell_list[i]; 
-  
-		static std::vector<std::string> Colors; 
-		if( fabs( (pC->position)[2] - z_slice ) < pC->phenotype.geometry.radius )
-		{
-			double r = pC->phenotype.geometry.radius ; 
-			double rn = pC->phenotype.geometry.nuclear_radius ; 
-			double z = fabs( (pC->position)[2] - z_slice) ; 
-   
-			Colors = cell_coloring_function( pC ); 
+		Staged_SVG_Cell& C = plot.cells[i]; 
+		std::vector<std::string>& Colors = C.colors; 
+		double r = C.radius ; 
+		double rn = C.nuclear_radius ; 
+		double z = fabs( C.z - z_slice) ; 
 
-			os << "  <g id=\"cell" << pC->ID << "\">" << std::endl; 
+		os << "  <g id=\"cell" << C.ID << "\">" << std::endl; 
   
-			// figure out how much of the cell intersects with z = 0 
+		// figure out how much of the cell intersects with z = 0 
    
-			double plot_radius = sqrt( r*r - z*z ); 
-
-			Write_SVG_circle( os, (pC->position)[0]-X_lower, (pC->position)[1]+top_margin-Y_lower, 
-				plot_radius , 0.5, Colors[1], Colors[0] ); 
-
-			// plot the nucleus if it, too intersects z = 0;
-			if( fabs(z) < rn && PhysiCell_SVG_options.plot_nuclei == true )
-			{   
-				plot_radius = sqrt( rn*rn - z*z ); 
-			 	Write_SVG_circle( os, (pC->position)[0]-X_lower, (pC->position)[1]+top_margin-Y_lower, 
-					plot_radius, 0.5, Colors[3],Colors[2]); 
-			}					  
-			os << "  </g>" << std::endl;
-		}
+		double plot_radius = sqrt( r*r - z*z ); 
+
+		Write_SVG_circle( os, C.x-X_lower, C.y+top_margin-Y_lower, 
+			plot_radius , 0.5, Colors[1], Colors[0] ); 
+
+		// plot the nucleus if it, too intersects z = 0;
+		if( fabs(z) < rn && PhysiCell_SVG_options.plot_nuclei == true )
+		{   
+			plot_radius = sqrt( rn*rn - z*z ); 
+		 	Write_SVG_circle( os, C.x-X_lower, C.y+top_margin-Y_lower, 
+				plot_radius, 0.5, Colors[3],Colors[2]); 
+		}					  
+		os << "  </g>" << std::endl;
 	}
 	os << "</g>" << std::endl; 
 	
@@ -439,8 +476,7 @@ void SVG_plot( std::string filename , Microenvironment& M, double z_slice , doub
 
 	// plot runtime 
 	szString = new char [1024]; 
-	RUNTIME_TOC(); 
-	std::string formatted_stopwatch_value = format_stopwatch_value( runtime_stopwatch_value() );
+	std::string& formatted_stopwatch_value = plot.formatted_runtime; 
 	Write_SVG_text( os, formatted_stopwatch_value.c_str() , bar_margin , top_margin + plot_height - bar_margin , 0.75 * font_size , 
 		PhysiCell_SVG_options.font_color.c_str() , PhysiCell_SVG_options.font.c_str() );
 	delete [] szString; 
@@ -455,4 +491,14 @@ void SVG_plot( std::string filename , Microenvironment& M, double z_slice , doub
 	return; 
 }
 
+void SVG_plot( std::string filename , Microenvironment& M, double z_slice , double time, std::vector<std::string> (*cell_coloring_function)(Cell*) )
+{
+	// stage what the plot needs now, and draw it in the background 
+	std::shared_ptr<Staged_SVG_Plot> plot( new Staged_SVG_Plot ); 
+	stage_SVG_plot( *plot , M , z_slice , time , cell_coloring_function ); 
+	output_writer.submit( [filename,plot]() { write_SVG_plot( filename , *plot ); } ); 
+	
+	return; 
+}
+
 };
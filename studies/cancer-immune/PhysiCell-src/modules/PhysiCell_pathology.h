@@ -108,6 +108,36 @@ std::vector<std::string> hematoxylin_and_eosin_stroma_coloring( double& ECM_frac
 
 std::string formatted_minutes_to_DDHHMM( double minutes ); 
 
+// a copy of what SVG_plot() draws, so that it can be drawn while the simulation continues 
+class Staged_SVG_Cell
+{
+ public:
+	int ID; 
+	double x; 
+	double y; 
+	double z; 
+	double radius; 
+	double nuclear_radius; 
+	std::vector<std::string> colors; 
+};
+
+class Staged_SVG_Plot
+{
+ public:
+	double bounding_box[6]; 
+	double dx; 
+	double dy; 
+	double z_slice; 
+	double time; 
+	int total_cell_count; 
+	std::vector<Staged_SVG_Cell> cells; // the cells that intersect the slice 
+	PhysiCell_SVG_options_struct options; 
+	std::string formatted_runtime; 
+};
+
+void stage_SVG_plot( Staged_SVG_Plot& plot , Microenvironment& M, double z_slice , double time, std::vector<std::string> (*cell_coloring_function)(Cell*) ); 
+void write_SVG_plot( std::string filename , Staged_SVG_Plot& plot ); 
+// stages the plot and draws it through output_writer 
 void SVG_plot( std::string filename , Microenvironment& M, double z_slice , double time, std::vector<std::string> (*cell_coloring_function)(Cell*) ); // done
 
 void SVG_plot_with_stroma( std::string filename , Microenvironment& M, double z_slice , double time, std::vector<std::string> (*cell_coloring_function)(Cell*) , 
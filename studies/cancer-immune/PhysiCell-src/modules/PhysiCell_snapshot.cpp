@@ -0,0 +1,749 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include "./PhysiCell_snapshot.h"
+
+namespace PhysiCell{
+
+std::vector<Cell_Definition*> snapshot_cell_definitions; 
+
+// lookup tables for function pointers and cycle models, rebuilt for each snapshot 
+typedef void (*snapshot_function)( void ); 
+std::vector<snapshot_function> snapshot_functions; 
+std::vector<Cycle_Model*> snapshot_cycle_models; 
+
+static const int snapshot_null_code = -1; 
+static const int snapshot_own_code = -2; // the cell's own functions.cycle_model or phenotype 
+static const int snapshot_unknown_code = -3; 
+
+static const int number_of_cell_functions = 8; 
+
+void register_snapshot_cell_definition( Cell_Definition& cd )
+{
+	for( int i=0; i < snapshot_cell_definitions.size() ; i++ )
+	{
+		if( snapshot_cell_definitions[i] == &cd )
+		{ return; }
+	}
+	snapshot_cell_definitions.push_back( &cd ); 
+	return; 
+}
+
+std::vector<snapshot_function> cell_function_list( Cell_Functions& functions )
+{
+	std::vector<snapshot_function> output( number_of_cell_functions ); 
+	output[0] = (snapshot_function) functions.volume_update_function; 
+	output[1] = (snapshot_function) functions.update_migration_bias; 
+	output[2] = (snapshot_function) functions.custom_cell_rule; 
+	output[3] = (snapshot_function) functions.update_phenotype; 
+	output[4] = (snapshot_function) functions.update_velocity; 
+	output[5] = (snapshot_function) functions.add_cell_basement_membrane_interactions; 
+	output[6] = (snapshot_function) functions.calculate_distance_to_membrane; 
+	output[7] = (snapshot_function) functions.set_orientation; 
+	return output; 
+}
+
+void set_cell_functions( Cell_Functions& functions , std::vector<snapshot_function>& list )
+{
+	typedef void (*cell_function)( Cell* , Phenotype& , double ); 
+	functions.volume_update_function = (cell_function) list[0]; 
+	functions.update_migration_bias = (cell_function) list[1]; 
+	functions.custom_cell_rule = (cell_function) list[2]; 
+	functions.update_phenotype = (cell_function) list[3]; 
+	functions.update_velocity = (cell_function) list[4]; 
+	functions.add_cell_basement_membrane_interactions = (cell_function) list[5]; 
+	functions.calculate_distance_to_membrane = (double (*)( Cell* , Phenotype& , double )) list[6]; 
+	functions.set_orientation = (cell_function) list[7]; 
+	return; 
+}
+
+void build_snapshot_tables( void )
+{
+	register_snapshot_cell_definition( cell_defaults ); 
+	
+	snapshot_functions.clear(); 
+	snapshot_cycle_models.clear(); 
+	
+	Cycle_Model* standard_models[] = { &Ki67_advanced, &Ki67_basic, &live, &apoptosis, &necrosis, &inert }; 
+	snapshot_cycle_models.assign( standard_models , standard_models + 6 ); 
+	
+	for( int i=0; i < snapshot_cell_definitions.size() ; i++ )
+	{
+		Cell_Definition* pCD = snapshot_cell_definitions[i]; 
+		std::vector<snapshot_function> functions = cell_function_list( pCD->functions ); 
+		snapshot_functions.insert( snapshot_functions.end() , functions.begin() , functions.end() ); 
+		
+		snapshot_cycle_models.push_back( &(pCD->functions.cycle_model) ); 
+	}
+	return; 
+}
+
+int find_snapshot_definition( int type )
+{
+	for( int i=0; i < snapshot_cell_definitions.size() ; i++ )
+	{
+		if( snapshot_cell_definitions[i]->type == type )
+		{ return i; }
+	}
+	return snapshot_unknown_code; 
+}
+
+int snapshot_function_code( snapshot_function function )
+{
+	if( function == NULL )
+	{ return snapshot_null_code; }
+	for( int i=0; i < snapshot_functions.size() ; i++ )
+	{
+		if( snapshot_functions[i] == function )
+		{ return i; }
+	}
+	return snapshot_unknown_code; 
+}
+
+int snapshot_cycle_model_code( Cycle_Model* pModel , Cell* pCell )
+{
+	if( pModel == NULL )
+	{ return snapshot_null_code; }
+	if( pModel == &(pCell->functions.cycle_model) )
+	{ return snapshot_own_code; }
+	for( int i=0; i < snapshot_cycle_models.size() ; i++ )
+	{
+		if( snapshot_cycle_models[i] == pModel )
+		{ return i; }
+	}
+	return snapshot_unknown_code; 
+}
+
+bool snapshot_cycle_model_from_code( int code , Cell* pCell , Cycle_Model*& pModel )
+{
+	if( code == snapshot_null_code )
+	{ pModel = NULL; }
+	else if( code == snapshot_own_code )
+	{ pModel = &(pCell->functions.cycle_model); }
+	else if( code >= 0 && code < snapshot_cycle_models.size() )
+	{ pModel = snapshot_cycle_models[code]; }
+	else
+	{ return false; }
+	return true; 
+}
+
+bool write_cell_snapshot( Snapshot_Buffer& buffer , Cell* pCell )
+{
+	// pointers first, so that nothing is written for a cell that can't be saved 
+	std::vector<snapshot_function> functions = cell_function_list( pCell->functions ); 
+	std::vector<int> function_codes( number_of_cell_functions ); 
+	for( int i=0; i < number_of_cell_functions ; i++ )
+	{
+		function_codes[i] = snapshot_function_code( functions[i] ); 
+		if( function_codes[i] == snapshot_unknown_code )
+		{
+			std::cout << "Error: cell " << pCell->ID << " uses a function that is not in a registered cell definition" << std::endl; 
+			return false; 
+		}
+	}
+	
+	Phenotype& phenotype = pCell->phenotype; 
+	std::vector<int> death_model_codes( phenotype.death.models.size() ); 
+	for( int i=0; i < death_model_codes.size() ; i++ )
+	{ death_model_codes[i] = snapshot_cycle_model_code( phenotype.death.models[i] , pCell ); }
+	int cycle_model_code = snapshot_cycle_model_code( phenotype.cycle.pCycle_Model , pCell ); 
+	
+	bool known_models = ( cycle_model_code != snapshot_unknown_code ); 
+	for( int i=0; i < death_model_codes.size() ; i++ )
+	{ known_models = known_models && ( death_model_codes[i] != snapshot_unknown_code ); }
+	if( !known_models )
+	{
+		std::cout << "Error: cell " << pCell->ID << " uses an unregistered cycle or death model" << std::endl; 
+		return false; 
+	}
+	
+	int reference_phenotype_code = snapshot_null_code; 
+	if( pCell->parameters.pReference_live_phenotype == &(pCell->phenotype) )
+	{ reference_phenotype_code = snapshot_own_code; }
+	for( int i=0; i < snapshot_cell_definitions.size() ; i++ )
+	{
+		if( pCell->parameters.pReference_live_phenotype == &(snapshot_cell_definitions[i]->phenotype) )
+		{ reference_phenotype_code = i; }
+	}
+	
+	pCell->Basic_Agent::write_snapshot( buffer ); 
+	
+	// cell 
+	buffer.write_string( pCell->type_name ); 
+	buffer.write_value( pCell->is_out_of_domain ); 
+	buffer.write_value( pCell->is_movable ); 
+	buffer.write_vector( pCell->displacement ); 
+	buffer.write_value( pCell->current_mechanics_voxel_index ); 
+	buffer.write_value( pCell->updated_current_mechanics_voxel_index ); 
+	
+	buffer.write_value( (int) pCell->custom_data.variables.size() ); 
+	for( int i=0; i < pCell->custom_data.variables.size() ; i++ )
+	{ buffer.write_value( pCell->custom_data.variables[i].value ); }
+	buffer.write_value( (int) pCell->custom_data.vector_variables.size() ); 
+	for( int i=0; i < pCell->custom_data.vector_variables.size() ; i++ )
+	{ buffer.write_vector( pCell->custom_data.vector_variables[i].value ); }
+	
+	Cell_Parameters& parameters = pCell->parameters; 
+	buffer.write_value( parameters.o2_hypoxic_threshold ); 
+	buffer.write_value( parameters.o2_hypoxic_response ); 
+	buffer.write_value( parameters.o2_hypoxic_saturation ); 
+	buffer.write_value( parameters.o2_proliferation_saturation ); 
+	buffer.write_value( parameters.o2_proliferation_threshold ); 
+	buffer.write_value( parameters.o2_reference ); 
+	buffer.write_value( parameters.o2_necrosis_threshold ); 
+	buffer.write_value( parameters.o2_necrosis_max ); 
+	buffer.write_value( parameters.max_necrosis_rate ); 
+	buffer.write_value( parameters.necrosis_type ); 
+	buffer.write_value( reference_phenotype_code ); 
+	
+	buffer.write_vector( function_codes ); 
+	
+	buffer.write_vector( pCell->state.orientation ); 
+	buffer.write_value( pCell->state.simple_pressure ); 
+	
+	// phenotype 
+	buffer.write_value( phenotype.flagged_for_division ); 
+	buffer.write_value( phenotype.flagged_for_removal ); 
+	
+	buffer.write_value( cycle_model_code ); 
+	buffer.write_string( phenotype.cycle.data.time_units ); 
+	buffer.write_value( (int) phenotype.cycle.data.transition_rates.size() ); 
+	for( int i=0; i < phenotype.cycle.data.transition_rates.size() ; i++ )
+	{ buffer.write_vector( phenotype.cycle.data.transition_rates[i] ); }
+	buffer.write_value( phenotype.cycle.data.current_phase_index ); 
+	buffer.write_value( phenotype.cycle.data.elapsed_time_in_phase ); 
+	
+	buffer.write_vector( phenotype.death.rates ); 
+	buffer.write_vector( death_model_codes ); 
+	buffer.write_value( (int) phenotype.death.parameters.size() ); 
+	for( int i=0; i < phenotype.death.parameters.size() ; i++ )
+	{
+		Death_Parameters& death_parameters = phenotype.death.parameters[i]; 
+		buffer.write_string( death_parameters.time_units ); 
+		buffer.write_value( death_parameters.unlysed_fluid_change_rate ); 
+		buffer.write_value( death_parameters.lysed_fluid_change_rate ); 
+		buffer.write_value( death_parameters.cytoplasmic_biomass_change_rate ); 
+		buffer.write_value( death_parameters.nuclear_biomass_change_rate ); 
+		buffer.write_value( death_parameters.calcification_rate ); 
+		buffer.write_value( death_parameters.relative_rupture_volume ); 
+	}
+	buffer.write_value( phenotype.death.dead ); 
+	buffer.write_value( phenotype.death.current_death_model_index ); 
+	
+	// these hold only doubles, and are copied whole 
+	buffer.write_value( phenotype.volume ); 
+	buffer.write_value( phenotype.geometry ); 
+	buffer.write_value( phenotype.mechanics ); 
+	
+	buffer.write_value( phenotype.motility.is_motile ); 
+	buffer.write_value( phenotype.motility.persistence_time ); 
+	buffer.write_value( phenotype.motility.migration_speed ); 
+	buffer.write_vector( phenotype.motility.migration_bias_direction ); 
+	buffer.write_value( phenotype.motility.migration_bias ); 
+	buffer.write_value( phenotype.motility.restrict_to_2D ); 
+	buffer.write_vector( phenotype.motility.motility_vector ); 
+	
+	buffer.write_vector( phenotype.secretion.secretion_rates ); 
+	buffer.write_vector( phenotype.secretion.uptake_rates ); 
+	buffer.write_vector( phenotype.secretion.saturation_densities ); 
+	
+	return true; 
+}
+
+bool read_cell_snapshot( Snapshot_Buffer& buffer , Cell* pCell )
+{
+	pCell->Basic_Agent::read_snapshot( buffer ); 
+	
+	// cell 
+	buffer.read_string( pCell->type_name ); 
+	buffer.read_value( pCell->is_out_of_domain ); 
+	buffer.read_value( pCell->is_movable ); 
+	buffer.read_vector( pCell->displacement ); 
+	buffer.read_value( pCell->current_mechanics_voxel_index ); 
+	buffer.read_value( pCell->updated_current_mechanics_voxel_index ); 
+	pCell->container = NULL; // found again from the microenvironment 
+	
+	int number_of_variables = 0; 
+	buffer.read_value( number_of_variables ); 
+	if( number_of_variables != pCell->custom_data.variables.size() )
+	{
+		std::cout << "Error: snapshot cell " << pCell->ID << " has " << number_of_variables 
+			<< " custom variables, but its cell definition has " << pCell->custom_data.variables.size() << std::endl; 
+		return false; 
+	}
+	for( int i=0; i < number_of_variables ; i++ )
+	{ buffer.read_value( pCell->custom_data.variables[i].value ); }
+	buffer.read_value( number_of_variables ); 
+	if( number_of_variables != pCell->custom_data.vector_variables.size() )
+	{
+		std::cout << "Error: snapshot cell " << pCell->ID << " has " << number_of_variables 
+			<< " custom vector variables, but its cell definition has " << pCell->custom_data.vector_variables.size() << std::endl; 
+		return false; 
+	}
+	for( int i=0; i < number_of_variables ; i++ )
+	{ buffer.read_vector( pCell->custom_data.vector_variables[i].value ); }
+	
+	Cell_Parameters& parameters = pCell->parameters; 
+	int reference_phenotype_code = 0; 
+	buffer.read_value( parameters.o2_hypoxic_threshold ); 
+	buffer.read_value( parameters.o2_hypoxic_response ); 
+	buffer.read_value( parameters.o2_hypoxic_saturation ); 
+	buffer.read_value( parameters.o2_proliferation_saturation ); 
+	buffer.read_value( parameters.o2_proliferation_threshold ); 
+	buffer.read_value( parameters.o2_reference ); 
+	buffer.read_value( parameters.o2_necrosis_threshold ); 
+	buffer.read_value( parameters.o2_necrosis_max ); 
+	buffer.read_value( parameters.max_necrosis_rate ); 
+	buffer.read_value( parameters.necrosis_type ); 
+	buffer.read_value( reference_phenotype_code ); 
+	if( reference_phenotype_code == snapshot_own_code )
+	{ parameters.pReference_live_phenotype = &(pCell->phenotype); }
+	else if( reference_phenotype_code >= 0 && reference_phenotype_code < snapshot_cell_definitions.size() )
+	{ parameters.pReference_live_phenotype = &(snapshot_cell_definitions[reference_phenotype_code]->phenotype); }
+	else
+	{ parameters.pReference_live_phenotype = NULL; }
+	
+	std::vector<int> function_codes; 
+	buffer.read_vector( function_codes ); 
+	if( function_codes.size() != number_of_cell_functions )
+	{ return false; }
+	std::vector<snapshot_function> functions( number_of_cell_functions , (snapshot_function) NULL ); 
+	for( int i=0; i < number_of_cell_functions ; i++ )
+	{
+		if( function_codes[i] >= (int) snapshot_functions.size() || function_codes[i] < snapshot_null_code )
+		{ return false; }
+		if( function_codes[i] >= 0 )
+		{ functions[i] = snapshot_functions[ function_codes[i] ]; }
+	}
+	set_cell_functions( pCell->functions , functions ); 
+	
+	buffer.read_vector( pCell->state.orientation ); 
+	buffer.read_value( pCell->state.simple_pressure ); 
+	pCell->state.neighbors.clear(); // restored after all cells exist 
+	
+	// phenotype 
+	Phenotype& phenotype = pCell->phenotype; 
+	buffer.read_value( phenotype.flagged_for_division ); 
+	buffer.read_value( phenotype.flagged_for_removal ); 
+	
+	int cycle_model_code = 0; 
+	Cycle_Model* pCycle_Model = NULL; 
+	buffer.read_value( cycle_model_code ); 
+	if( !snapshot_cycle_model_from_code( cycle_model_code , pCell , pCycle_Model ) || pCycle_Model == NULL )
+	{ return false; }
+	// the phase maps come from the model; the rates and progress from the snapshot 
+	phenotype.cycle.sync_to_cycle_model( *pCycle_Model ); 
+	buffer.read_string( phenotype.cycle.data.time_units ); 
+	int number_of_phases = 0; 
+	buffer.read_value( number_of_phases ); 
+	if( number_of_phases != phenotype.cycle.data.transition_rates.size() )
+	{ return false; }
+	for( int i=0; i < number_of_phases ; i++ )
+	{ buffer.read_vector( phenotype.cycle.data.transition_rates[i] ); }
+	buffer.read_value( phenotype.cycle.data.current_phase_index ); 
+	buffer.read_value( phenotype.cycle.data.elapsed_time_in_phase ); 
+	
+	std::vector<int> death_model_codes; 
+	buffer.read_vector( phenotype.death.rates ); 
+	buffer.read_vector( death_model_codes ); 
+	phenotype.death.models.resize( death_model_codes.size() ); 
+	for( int i=0; i < death_model_codes.size() ; i++ )
+	{
+		if( !snapshot_cycle_model_from_code( death_model_codes[i] , pCell , phenotype.death.models[i] ) )
+		{ return false; }
+	}
+	int number_of_death_parameters = 0; 
+	buffer.read_value( number_of_death_parameters ); 
+	if( number_of_death_parameters < 0 || number_of_death_parameters > death_model_codes.size() )
+	{ return false; }
+	phenotype.death.parameters.resize( number_of_death_parameters ); 
+	for( int i=0; i < number_of_death_parameters ; i++ )
+	{
+		Death_Parameters& death_parameters = phenotype.death.parameters[i]; 
+		buffer.read_string( death_parameters.time_units ); 
+		buffer.read_value( death_parameters.unlysed_fluid_change_rate ); 
+		buffer.read_value( death_parameters.lysed_fluid_change_rate ); 
+		buffer.read_value( death_parameters.cytoplasmic_biomass_change_rate ); 
+		buffer.read_value( death_parameters.nuclear_biomass_change_rate ); 
+		buffer.read_value( death_parameters.calcification_rate ); 
+		buffer.read_value( death_parameters.relative_rupture_volume ); 
+	}
+	buffer.read_value( phenotype.death.dead ); 
+	buffer.read_value( phenotype.death.current_death_model_index ); 
+	
+	buffer.read_value( phenotype.volume ); 
+	buffer.read_value( phenotype.geometry ); 
+	buffer.read_value( phenotype.mechanics ); 
+	
+	buffer.read_value( phenotype.motility.is_motile ); 
+	buffer.read_value( phenotype.motility.persistence_time ); 
+	buffer.read_value( phenotype.motility.migration_speed ); 
+	buffer.read_vector( phenotype.motility.migration_bias_direction ); 
+	buffer.read_value( phenotype.motility.migration_bias ); 
+	buffer.read_value( phenotype.motility.restrict_to_2D ); 
+	buffer.read_vector( phenotype.motility.motility_vector ); 
+	
+	buffer.read_vector( phenotype.secretion.secretion_rates ); 
+	buffer.read_vector( phenotype.secretion.uptake_rates ); 
+	buffer.read_vector( phenotype.secretion.saturation_densities ); 
+	phenotype.secretion.pMicroenvironment = pCell->get_microenvironment(); 
+	
+	// link the agent's rate vectors to the phenotype, as Secretion::advance() would 
+	if( pCell->secretion_rates != &(phenotype.secretion.secretion_rates) )
+	{
+		delete pCell->secretion_rates; 
+		delete pCell->uptake_rates; 
+		delete pCell->saturation_densities; 
+		
+		pCell->secretion_rates = &(phenotype.secretion.secretion_rates); 
+		pCell->uptake_rates = &(phenotype.secretion.uptake_rates); 
+		pCell->saturation_densities = &(phenotype.secretion.saturation_densities); 
+	}
+	
+	return !buffer.read_failed; 
+}
+
+std::vector<int> cell_indices( std::vector<Cell*>& cells )
+{
+	std::vector<int> output( cells.size() ); 
+	for( int i=0; i < cells.size() ; i++ )
+	{ output[i] = cells[i]->index; }
+	return output; 
+}
+
+bool cells_from_indices( std::vector<int>& indices , std::vector<Cell*>& cells )
+{
+	cells.resize( indices.size() ); 
+	for( int i=0; i < indices.size() ; i++ )
+	{
+		if( indices[i] < 0 || indices[i] >= (*all_cells).size() )
+		{ return false; }
+		cells[i] = (*all_cells)[ indices[i] ]; 
+	}
+	return true; 
+}
+
+bool write_simulation_snapshot( Snapshot_Buffer& buffer , Microenvironment& m , double t )
+{
+	size_t start = buffer.bytes.size(); 
+	build_snapshot_tables(); 
+	
+	Cell_Container* pContainer = (Cell_Container*) m.agent_container; 
+	
+	buffer.write_value( t ); 
+	m.write_snapshot( buffer ); 
+	
+	// cells, each preceded by the index of its cell definition 
+	buffer.write_value( (int) (*all_cells).size() ); 
+	for( int i=0; i < (*all_cells).size() ; i++ )
+	{
+		Cell* pCell = (*all_cells)[i]; 
+		int definition_index = find_snapshot_definition( pCell->type ); 
+		buffer.write_value( definition_index ); 
+		if( definition_index == snapshot_unknown_code || !write_cell_snapshot( buffer , pCell ) )
+		{
+			if( definition_index == snapshot_unknown_code )
+			{ std::cout << "Error: no registered cell definition for cell type " << pCell->type << std::endl; }
+			buffer.bytes.resize( start ); 
+			return false; 
+		}
+	}
+	
+	// attachments 
+	for( int i=0; i < (*all_cells).size() ; i++ )
+	{ buffer.write_vector( cell_indices( (*all_cells)[i]->state.neighbors ) ); }
+	
+	// the mechanics grid (in order, since the order of interactions depends on it) 
+	buffer.write_value( (int) pContainer->agent_grid.size() ); 
+	for( int i=0; i < pContainer->agent_grid.size() ; i++ )
+	{ buffer.write_vector( cell_indices( pContainer->agent_grid[i] ) ); }
+	buffer.write_value( (int) pContainer->agents_in_outer_voxels.size() ); 
+	for( int i=0; i < pContainer->agents_in_outer_voxels.size() ; i++ )
+	{ buffer.write_vector( cell_indices( pContainer->agents_in_outer_voxels[i] ) ); }
+	buffer.write_vector( pContainer->max_cell_interactive_distance_in_voxel ); 
+	
+	buffer.write_value( pContainer->num_divisions_in_current_step ); 
+	buffer.write_value( pContainer->num_deaths_in_current_step ); 
+	buffer.write_value( pContainer->last_diffusion_time ); 
+	buffer.write_value( pContainer->last_cell_cycle_time ); 
+	buffer.write_value( pContainer->last_mechanics_time ); 
+	buffer.write_value( pContainer->initialzed ); 
+	
+	buffer.write_value( max_basic_agent_ID ); 
+	buffer.write_string( GetRandomState() ); 
+	buffer.write_string( BioFVM::get_random_state() ); 
+	
+	return true; 
+}
+
+bool read_simulation_snapshot( Snapshot_Buffer& buffer , Microenvironment& m , double& t )
+{
+	build_snapshot_tables(); 
+	
+	Cell_Container* pContainer = (Cell_Container*) m.agent_container; 
+	
+	double snapshot_time = 0.0; 
+	buffer.read_value( snapshot_time ); 
+	if( !m.read_snapshot( buffer ) )
+	{ return false; }
+	
+	// remove the current cells 
+	for( int i=0; i < (*all_cells).size() ; i++ )
+	{ cell_pool.destroy( (*all_cells)[i] ); }
+	(*all_cells).clear(); 
+	pContainer->mechanics_arena.clear(); 
+	for( int i=0; i < pContainer->agent_grid.size() ; i++ )
+	{ pContainer->agent_grid[i].clear(); }
+	for( int i=0; i < pContainer->agents_in_outer_voxels.size() ; i++ )
+	{ pContainer->agents_in_outer_voxels[i].clear(); }
+	
+	int number_of_cells = 0; 
+	buffer.read_value( number_of_cells ); 
+	for( int i=0; i < number_of_cells && !buffer.read_failed ; i++ )
+	{
+		int definition_index = snapshot_unknown_code; 
+		buffer.read_value( definition_index ); 
+		if( definition_index < 0 || definition_index >= snapshot_cell_definitions.size() )
+		{
+			std::cout << "Error: snapshot cell " << i << " uses an unregistered cell definition" << std::endl; 
+			return false; 
+		}
+		Cell* pCell = create_cell( *snapshot_cell_definitions[definition_index] ); 
+		if( !read_cell_snapshot( buffer , pCell ) )
+		{
+			std::cout << "Error: could not restore snapshot cell " << i << std::endl; 
+			return false; 
+		}
+	}
+	
+	std::vector<int> indices; 
+	for( int i=0; i < number_of_cells ; i++ )
+	{
+		buffer.read_vector( indices ); 
+		if( !cells_from_indices( indices , (*all_cells)[i]->state.neighbors ) )
+		{ return false; }
+	}
+	
+	int number_of_voxels = 0; 
+	buffer.read_value( number_of_voxels ); 
+	if( number_of_voxels != pContainer->agent_grid.size() )
+	{
+		std::cout << "Error: the snapshot mechanics grid (" << number_of_voxels << " voxels) does not match this one (" 
+			<< pContainer->agent_grid.size() << " voxels)" << std::endl; 
+		return false; 
+	}
+	for( int i=0; i < number_of_voxels ; i++ )
+	{
+		buffer.read_vector( indices ); 
+		if( !cells_from_indices( indices , pContainer->agent_grid[i] ) )
+		{ return false; }
+	}
+	int number_of_faces = 0; 
+	buffer.read_value( number_of_faces ); 
+	if( number_of_faces != pContainer->agents_in_outer_voxels.size() )
+	{ return false; }
+	for( int i=0; i < number_of_faces ; i++ )
+	{
+		buffer.read_vector( indices ); 
+		if( !cells_from_indices( indices , pContainer->agents_in_outer_voxels[i] ) )
+		{ return false; }
+	}
+	buffer.read_vector( pContainer->max_cell_interactive_distance_in_voxel ); 
+	
+	buffer.read_value( pContainer->num_divisions_in_current_step ); 
+	buffer.read_value( pContainer->num_deaths_in_current_step ); 
+	buffer.read_value( pContainer->last_diffusion_time ); 
+	buffer.read_value( pContainer->last_cell_cycle_time ); 
+	buffer.read_value( pContainer->last_mechanics_time ); 
+	buffer.read_value( pContainer->initialzed ); 
+	
+	// last, since creating the cells above may have drawn random numbers 
+	std::string physicell_random_state; 
+	std::string biofvm_random_state; 
+	buffer.read_value( max_basic_agent_ID ); 
+	buffer.read_string( physicell_random_state ); 
+	buffer.read_string( biofvm_random_state ); 
+	if( buffer.read_failed || !SetRandomState( physicell_random_state ) || 
+		!BioFVM::set_random_state( biofvm_random_state ) )
+	{
+		std::cout << "Error: truncated or malformed simulation snapshot" << std::endl; 
+		return false; 
+	}
+	
+	t = snapshot_time; 
+	return true; 
+}
+
+// checkpoint files 
+
+static const char checkpoint_magic[8] = { 'P','C','C','K','P','T','\0','\0' }; 
+static const unsigned int checkpoint_format_version = 1; 
+static const unsigned int checkpoint_byte_order_mark = 0x01020304; 
+
+unsigned long long checkpoint_checksum( const char* data , size_t size )
+{
+	// 64-bit FNV-1a 
+	unsigned long long hash = 14695981039346656037ULL; 
+	for( size_t i=0; i < size ; i++ )
+	{
+		hash ^= (unsigned char) data[i]; 
+		hash *= 1099511628211ULL; 
+	}
+	return hash; 
+}
+
+void write_checkpoint_header( Snapshot_Buffer& header , Snapshot_Buffer& buffer )
+{
+	header.write( checkpoint_magic , sizeof(checkpoint_magic) ); 
+	header.write_value( checkpoint_format_version ); 
+	header.write_value( checkpoint_byte_order_mark ); 
+	// the snapshot stores native types, so a checkpoint only loads where they match 
+	header.write_value( (unsigned char) sizeof(int) ); 
+	header.write_value( (unsigned char) sizeof(long) ); 
+	header.write_value( (unsigned char) sizeof(double) ); 
+	header.write_value( (unsigned char) sizeof(bool) ); 
+	header.write_value( (unsigned long long) buffer.bytes.size() ); 
+	header.write_value( checkpoint_checksum( buffer.bytes.data() , buffer.bytes.size() ) ); 
+	return; 
+}
+
+bool write_checkpoint_file( std::string filename , Snapshot_Buffer& buffer )
+{
+	Snapshot_Buffer header; 
+	write_checkpoint_header( header , buffer ); 
+	
+	// write to a temporary file and rename it, so that an interrupted write 
+	// never replaces the last good checkpoint 
+	std::string temporary_filename = filename + ".tmp"; 
+	FILE* fp = fopen( temporary_filename.c_str() , "wb" ); 
+	if( fp == NULL )
+	{
+		std::cout << "Error: could not open " << temporary_filename << " for writing" << std::endl; 
+		return false; 
+	}
+	setvbuf( fp , NULL , _IONBF , 0 ); 
+	bool success = fwrite( header.bytes.data() , 1 , header.bytes.size() , fp ) == header.bytes.size() && 
+		fwrite( buffer.bytes.data() , 1 , buffer.bytes.size() , fp ) == buffer.bytes.size(); 
+	if( fsync( fileno( fp ) ) != 0 )
+	{ success = false; }
+	if( fclose( fp ) != 0 )
+	{ success = false; }
+	if( success && rename( temporary_filename.c_str() , filename.c_str() ) != 0 )
+	{ success = false; }
+	
+	if( !success )
+	{
+		std::cout << "Error: could not write checkpoint " << filename << std::endl; 
+		remove( temporary_filename.c_str() ); 
+	}
+	return success; 
+}
+
+bool read_checkpoint_file( std::string filename , Snapshot_Buffer& buffer )
+{
+	if( buffer.read_from_file( filename ) == false )
+	{ return false; }
+	
+	Snapshot_Buffer expected_header; 
+	Snapshot_Buffer empty; 
+	write_checkpoint_header( expected_header , empty ); 
+	// everything but the payload size and checksum must match 
+	size_t compared_size = expected_header.bytes.size() - 2*sizeof(unsigned long long); 
+	
+	if( buffer.bytes.size() < expected_header.bytes.size() || 
+		memcmp( buffer.bytes.data() , checkpoint_magic , sizeof(checkpoint_magic) ) != 0 )
+	{
+		std::cout << "Error: " << filename << " is not a PhysiCell checkpoint" << std::endl; 
+		buffer.clear(); 
+		return false; 
+	}
+	if( memcmp( buffer.bytes.data() , expected_header.bytes.data() , compared_size ) != 0 )
+	{
+		std::cout << "Error: " << filename << " was written by an incompatible version or platform" << std::endl; 
+		buffer.clear(); 
+		return false; 
+	}
+	
+	buffer.read_position = compared_size; 
+	unsigned long long payload_size = 0; 
+	unsigned long long checksum = 0; 
+	buffer.read_value( payload_size ); 
+	buffer.read_value( checksum ); 
+	if( payload_size != buffer.bytes.size() - buffer.read_position || 
+		checksum != checkpoint_checksum( buffer.bytes.data() + buffer.read_position , payload_size ) )
+	{
+		std::cout << "Error: checkpoint " << filename << " is truncated or corrupted" << std::endl; 
+		buffer.clear(); 
+		return false; 
+	}
+	
+	// leave the read position at the start of the snapshot 
+	return true; 
+}
+
+};
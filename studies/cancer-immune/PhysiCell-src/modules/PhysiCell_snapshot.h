@@ -0,0 +1,122 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+#ifndef __PhysiCell_snapshot_h__
+#define __PhysiCell_snapshot_h__
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../core/PhysiCell.h"
+
+namespace PhysiCell{
+
+/* 
+   Binary snapshots of the full simulation state: the substrate densities and 
+   diffusion schedule, every cell (phenotype, custom data, state including 
+   attachments, velocities, and its place in the mechanics grid), the cell 
+   container, the agent ID counter, and both random number generators. 
+   Restoring a snapshot into a process that was set up the same way (same 
+   mesh, substrates, cell definitions, and cycle and death models) continues 
+   the simulation exactly where the snapshot was taken. 
+   
+   Function pointers and cycle models are not stored as addresses. They are 
+   matched against the registered cell definitions and the standard cycle 
+   and death models, so every cell definition in use must be registered with 
+   register_snapshot_cell_definition(). (cell_defaults is always registered.) 
+   A cell's functions.cycle_model is taken from the definition of its type. 
+   
+   The application can append its own state (e.g., output counters) to the 
+   buffer after write_simulation_snapshot(), and read it back in the same 
+   order after read_simulation_snapshot(). 
+*/ 
+
+void register_snapshot_cell_definition( Cell_Definition& cd ); 
+
+// one cell; returns false if it uses an unregistered function or cycle model 
+bool write_cell_snapshot( Snapshot_Buffer& buffer , Cell* pCell ); 
+bool read_cell_snapshot( Snapshot_Buffer& buffer , Cell* pCell ); 
+
+// returns false (and leaves the buffer unchanged) if a cell uses an unregistered 
+// cell definition, function, or cycle model 
+bool write_simulation_snapshot( Snapshot_Buffer& buffer , Microenvironment& m , double t ); 
+// replaces all cells; returns false if the snapshot does not match this setup 
+bool read_simulation_snapshot( Snapshot_Buffer& buffer , Microenvironment& m , double& t ); 
+
+/* 
+   Checkpoint files hold one snapshot buffer behind a small header (format 
+   version, byte order, native type sizes, payload size, and a checksum), so 
+   that a stale, foreign, or partially written file is rejected instead of 
+   restored. The file is written with one sequential write to a temporary 
+   file, which then replaces the old checkpoint. 
+*/ 
+
+bool write_checkpoint_file( std::string filename , Snapshot_Buffer& buffer ); 
+// on success, the buffer's read position is at the start of the snapshot 
+bool read_checkpoint_file( std::string filename , Snapshot_Buffer& buffer ); 
+
+};
+
+#endif
@@ -72,5 +72,8 @@
 #include "./PhysiCell_pathology.h"
 #include "./PhysiCell_MultiCellDS.h"
 #include "./PhysiCell_various_outputs.h"
+#include "./PhysiCell_ensemble.h"
+#include "./PhysiCell_snapshot.h"
+#include "./PhysiCell_async_output.h"
 
 #endif
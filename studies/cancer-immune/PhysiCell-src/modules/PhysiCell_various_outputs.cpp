@@ -64,11 +64,382 @@
 
 #include "../core/PhysiCell.h"
 #include "./PhysiCell_various_outputs.h"
+#include "./PhysiCell_async_output.h"
+
+#include <cstdio>
+#include <memory>
+#include <unistd.h>
 
 namespace PhysiCell{
 
+Output_Artifact::Output_Artifact()
+{
+	interval = 1; 
+	return; 
+}
+
+Output_Artifact::Output_Artifact( int interval )
+{
+	this->interval = interval; 
+	return; 
+}
+
+bool Output_Artifact::enabled( void )
+{ return interval > 0; }
+
+bool Output_Artifact::due( int output_index )
+{ return interval > 0 && output_index % interval == 0; }
+
+Output_Policy output_policy; 
+
+Output_Policy::Output_Policy()
+{
+	SVG = Output_Artifact( 1 ); 
+	cell_frames = Output_Artifact( 1 ); 
+	POV = Output_Artifact( 0 ); 
+	cell_report = Output_Artifact( 0 ); 
+	MultiCellDS = Output_Artifact( 0 ); 
+	simulation_report = Output_Artifact( 1 ); 
+	
+	initial_and_final = true; 
+	MultiCellDS_cell_data = true; 
+	return; 
+}
+
+bool Output_Policy::set( std::string name , std::string value )
+{
+	int interval = 0; 
+	if( value == "on" || value == "true" )
+	{ interval = 1; }
+	else if( value == "off" || value == "false" )
+	{ interval = 0; }
+	else
+	{
+		char* end = NULL; 
+		interval = strtol( value.c_str() , &end , 10 ); 
+		if( value.size() == 0 || *end != '\0' || interval < 0 )
+		{
+			std::cout << "Error: " << value << " is not an output interval (use a number, on, or off)" << std::endl; 
+			return false; 
+		}
+	}
+	
+	if( name == "svg" )
+	{ SVG.interval = interval; }
+	else if( name == "cell_frames" )
+	{ cell_frames.interval = interval; }
+	else if( name == "pov" )
+	{ POV.interval = interval; }
+	else if( name == "cell_report" )
+	{ cell_report.interval = interval; }
+	else if( name == "multicellds" )
+	{ MultiCellDS.interval = interval; }
+	else if( name == "simulation_report" )
+	{ simulation_report.interval = interval; }
+	else if( name == "initial_and_final" )
+	{ initial_and_final = ( interval > 0 ); }
+	else if( name == "multicellds_cell_data" )
+	{ MultiCellDS_cell_data = ( interval > 0 ); }
+	else
+	{
+		std::cout << "Error: unknown output " << name << std::endl; 
+		return false; 
+	}
+	return true; 
+}
+
+bool Output_Policy::read_from_xml( std::string filename )
+{
+	pugi::xml_document doc; 
+	pugi::xml_parse_result result = doc.load_file( filename.c_str() ); 
+	if( !result )
+	{
+		std::cout << "Error: could not read " << filename << " (" << result.description() << ")" << std::endl; 
+		return false; 
+	}
+	
+	pugi::xml_node node = doc.child( "PhysiCell_settings" ).child( "save" ); 
+	for( node = node.first_child(); node ; node = node.next_sibling() )
+	{
+		if( node.type() != pugi::node_element )
+		{ continue; }
+		std::string value = node.child_value(); 
+		value.erase( 0 , value.find_first_not_of( " \t\r\n" ) ); 
+		value.erase( value.find_last_not_of( " \t\r\n" ) + 1 ); 
+		if( !set( node.name() , value ) )
+		{ return false; }
+	}
+	return true; 
+}
+
+void Output_Policy::display( std::ostream& os )
+{
+	os << "outputs (every N-th output time; 0: off): " 
+		<< "svg " << SVG.interval << ", cell_frames " << cell_frames.interval 
+		<< ", pov " << POV.interval << ", cell_report " << cell_report.interval 
+		<< ", multicellds " << MultiCellDS.interval << ", simulation_report " << simulation_report.interval 
+		<< ", initial_and_final " << initial_and_final 
+		<< ", multicellds_cell_data " << MultiCellDS_cell_data << std::endl; 
+	return; 
+}
+
+Cell_Output_Options cell_output_options; 
+
+Cell_Output_Options::Cell_Output_Options()
+{
+	binary_frames_filename = "output//cells.bin"; 
+	continue_binary_frames = false; 
+	
+	binary_frames_started = false; 
+	return; 
+}
+
+void Cell_Output_Frame::resize( int n )
+{
+	ID.resize( n ); 
+	type.resize( n ); 
+	phase_code.resize( n ); 
+	elapsed_time_in_phase.resize( n ); 
+	position_x.resize( n ); 
+	position_y.resize( n ); 
+	position_z.resize( n ); 
+	radius.resize( n ); 
+	volume_total.resize( n ); 
+	volume_nuclear_fluid.resize( n ); 
+	volume_nuclear_solid.resize( n ); 
+	volume_cytoplasmic_fluid.resize( n ); 
+	volume_cytoplasmic_solid.resize( n ); 
+	volume_calcified_fraction.resize( n ); 
+	return; 
+}
+
+int Cell_Output_Frame::size( void )
+{ return ID.size(); }
+
+// the columns of a frame, in file order 
+std::vector< std::vector<int>* > Cell_Output_Frame::int_columns( void )
+{
+	std::vector< std::vector<int>* > output; 
+	output.push_back( &ID ); 
+	output.push_back( &type ); 
+	output.push_back( &phase_code ); 
+	return output; 
+}
+
+std::vector< std::vector<double>* > Cell_Output_Frame::double_columns( void )
+{
+	std::vector< std::vector<double>* > output; 
+	output.push_back( &elapsed_time_in_phase ); 
+	output.push_back( &position_x ); 
+	output.push_back( &position_y ); 
+	output.push_back( &position_z ); 
+	output.push_back( &radius ); 
+	output.push_back( &volume_total ); 
+	output.push_back( &volume_nuclear_fluid ); 
+	output.push_back( &volume_nuclear_solid ); 
+	output.push_back( &volume_cytoplasmic_fluid ); 
+	output.push_back( &volume_cytoplasmic_solid ); 
+	output.push_back( &volume_calcified_fraction ); 
+	return output; 
+}
+
+void stage_cell_frame( std::vector<Cell*>& cells , double time , Cell_Output_Frame& frame )
+{
+	frame.time = time; 
+	frame.resize( cells.size() ); 
+	for( int i=0; i < cells.size() ; i++ )
+	{
+		Cell* pCell = cells[i]; 
+		
+		frame.ID[i] = pCell->ID; 
+		frame.type[i] = pCell->type; 
+		frame.phase_code[i] = -1; 
+		if( pCell->phenotype.cycle.pCycle_Model != NULL )
+		{ frame.phase_code[i] = pCell->phenotype.cycle.current_phase().code; }
+		frame.elapsed_time_in_phase[i] = pCell->phenotype.cycle.data.elapsed_time_in_phase; 
+		
+		frame.position_x[i] = pCell->position[0]; 
+		frame.position_y[i] = pCell->position[1]; 
+		frame.position_z[i] = pCell->position[2]; 
+		frame.radius[i] = pCell->phenotype.geometry.radius; 
+		
+		Volume& volume = pCell->phenotype.volume; 
+		frame.volume_total[i] = volume.total; 
+		frame.volume_nuclear_fluid[i] = volume.nuclear_fluid; 
+		frame.volume_nuclear_solid[i] = volume.nuclear_solid; 
+		frame.volume_cytoplasmic_fluid[i] = volume.cytoplasmic_fluid; 
+		frame.volume_cytoplasmic_solid[i] = volume.cytoplasmic_solid; 
+		frame.volume_calcified_fraction[i] = volume.calcified_fraction; 
+	}
+	return; 
+}
+
+// binary cell frames 
+
+static const char cell_frames_magic[8] = { 'P','C','F','R','A','M','E','S' }; 
+static const unsigned int cell_frames_version = 1; 
+static const unsigned int cell_frame_marker = 0x454D5246; // "FRME" 
+
+static const char* cell_frame_int_names[] = { "ID" , "type" , "phase_code" }; 
+static const char* cell_frame_double_names[] = { "elapsed_time_in_phase" , 
+	"position_x" , "position_y" , "position_z" , "radius" , 
+	"volume_total" , "volume_nuclear_fluid" , "volume_nuclear_solid" , 
+	"volume_cytoplasmic_fluid" , "volume_cytoplasmic_solid" , "volume_calcified_fraction" }; 
+static const int number_of_cell_frame_int_columns = 3; 
+static const int number_of_cell_frame_double_columns = 11; 
+
+// type codes in the schema 
+static const unsigned char cell_frame_int32 = 0; 
+static const unsigned char cell_frame_float64 = 1; 
+
+std::string cell_frames_header( void )
+{
+	std::string output( cell_frames_magic , sizeof(cell_frames_magic) ); 
+	unsigned int number_of_columns = number_of_cell_frame_int_columns + number_of_cell_frame_double_columns; 
+	output.append( (const char*) &cell_frames_version , sizeof(unsigned int) ); 
+	output.append( (const char*) &number_of_columns , sizeof(unsigned int) ); 
+	for( int i=0; i < number_of_columns ; i++ )
+	{
+		bool is_int = ( i < number_of_cell_frame_int_columns ); 
+		std::string name = is_int ? cell_frame_int_names[i] : cell_frame_double_names[i-number_of_cell_frame_int_columns]; 
+		unsigned int length = name.size(); 
+		output.push_back( is_int ? cell_frame_int32 : cell_frame_float64 ); 
+		output.append( (const char*) &length , sizeof(unsigned int) ); 
+		output.append( name ); 
+	}
+	return output; 
+}
+
+bool append_cell_frame( std::string filename , Cell_Output_Frame& frame , bool start_new_file )
+{
+	FILE* fp = fopen( filename.c_str() , start_new_file ? "wb" : "ab" ); 
+	if( fp == NULL )
+	{
+		std::cout << "Error: could not open " << filename << " for writing" << std::endl; 
+		return false; 
+	}
+	
+	bool success = true; 
+	if( start_new_file )
+	{
+		std::string header = cell_frames_header(); 
+		success = fwrite( header.data() , 1 , header.size() , fp ) == header.size(); 
+	}
+	
+	unsigned long long number_of_cells = frame.size(); 
+	success = success && fwrite( &cell_frame_marker , sizeof(unsigned int) , 1 , fp ) == 1 && 
+		fwrite( &frame.time , sizeof(double) , 1 , fp ) == 1 && 
+		fwrite( &number_of_cells , sizeof(unsigned long long) , 1 , fp ) == 1; 
+	
+	// one contiguous array per field 
+	std::vector< std::vector<int>* > int_columns = frame.int_columns(); 
+	for( int i=0; success && i < int_columns.size() ; i++ )
+	{ success = fwrite( int_columns[i]->data() , sizeof(int) , number_of_cells , fp ) == number_of_cells; }
+	std::vector< std::vector<double>* > double_columns = frame.double_columns(); 
+	for( int i=0; success && i < double_columns.size() ; i++ )
+	{ success = fwrite( double_columns[i]->data() , sizeof(double) , number_of_cells , fp ) == number_of_cells; }
+	
+	if( fclose( fp ) != 0 )
+	{ success = false; }
+	if( !success )
+	{ std::cout << "Error: could not write a cell frame to " << filename << std::endl; }
+	return success; 
+}
+
+FILE* open_cell_frames( std::string filename )
+{
+	FILE* fp = fopen( filename.c_str() , "rb" ); 
+	if( fp == NULL )
+	{
+		std::cout << "Error: could not open " << filename << std::endl; 
+		return NULL; 
+	}
+	
+	std::string expected = cell_frames_header(); 
+	std::string header( expected.size() , '\0' ); 
+	if( fread( &header[0] , 1 , header.size() , fp ) != header.size() || header != expected )
+	{
+		std::cout << "Error: " << filename << " is not a cell frame file of this version" << std::endl; 
+		fclose( fp ); 
+		return NULL; 
+	}
+	return fp; 
+}
+
+bool read_cell_frame( FILE* fp , Cell_Output_Frame& frame )
+{
+	unsigned int marker = 0; 
+	unsigned long long number_of_cells = 0; 
+	if( fread( &marker , sizeof(unsigned int) , 1 , fp ) != 1 || marker != cell_frame_marker || 
+		fread( &frame.time , sizeof(double) , 1 , fp ) != 1 || 
+		fread( &number_of_cells , sizeof(unsigned long long) , 1 , fp ) != 1 )
+	{ return false; }
+	
+	frame.resize( number_of_cells ); 
+	std::vector< std::vector<int>* > int_columns = frame.int_columns(); 
+	for( int i=0; i < int_columns.size() ; i++ )
+	{
+		if( fread( int_columns[i]->data() , sizeof(int) , number_of_cells , fp ) != number_of_cells )
+		{ return false; }
+	}
+	std::vector< std::vector<double>* > double_columns = frame.double_columns(); 
+	for( int i=0; i < double_columns.size() ; i++ )
+	{
+		if( fread( double_columns[i]->data() , sizeof(double) , number_of_cells , fp ) != number_of_cells )
+		{ return false; }
+	}
+	return true; 
+}
+
+bool truncate_cell_frames( std::string filename , double time )
+{
+	FILE* fp = open_cell_frames( filename ); 
+	if( fp == NULL )
+	{ return false; }
+	
+	// find the first frame at or after time (or an incomplete frame) 
+	Cell_Output_Frame frame; 
+	long keep = ftell( fp ); 
+	while( read_cell_frame( fp , frame ) && frame.time < time - 1e-10 )
+	{ keep = ftell( fp ); }
+	fclose( fp ); 
+	
+	if( truncate( filename.c_str() , keep ) != 0 )
+	{
+		std::cout << "Error: could not truncate " << filename << std::endl; 
+		return false; 
+	}
+	return true; 
+}
+
+int convert_cell_frames_to_text( std::string filename , double scale )
+{
+	FILE* fp = open_cell_frames( filename ); 
+	if( fp == NULL )
+	{ return -1; }
+	
+	int number_of_frames = 0; 
+	Cell_Output_Frame frame; 
+	while( read_cell_frame( fp , frame ) )
+	{
+		writePov( frame , scale ); 
+		writeCellReport( frame ); 
+		number_of_frames++; 
+	}
+	fclose( fp ); 
+	return number_of_frames; 
+}
+
 int writePov(std::vector<Cell*> all_cells, double timepoint, double scale)
 {
+	Cell_Output_Frame frame; 
+	stage_cell_frame( all_cells , timepoint , frame ); 
+	return writePov( frame , scale ); 
+}
+
+int writePov(Cell_Output_Frame& frame, double scale)
+{
+	double timepoint = frame.time; 
 	std::string filename; 
 	filename.resize( 1024 ); 
 	sprintf( (char*) filename.c_str() , "output//cells_%i.pov" , (int)round(timepoint) ); 
@@ -76,13 +447,13 @@ int writePov(std::vector<Cell*> all_cells, double timepoint, double scale)
 	povFile<<"#include \"colors.inc\" \n";
 	povFile<<"#include \"header.inc\" \n";
 	
-	for(int i=0;i<all_cells.size();i++)
+	for(int i=0;i<frame.size();i++)
 	{
 		std::string _nameCore;
 
-		if( all_cells[i]->phenotype.cycle.pCycle_Model )
+		if( frame.phase_code[i] >= 0 )
 		{
-			int code= all_cells[i]->phenotype.cycle.current_phase().code;
+			int code= frame.phase_code[i];
 			if (code ==PhysiCell_constants::Ki67_positive_premitotic || code==PhysiCell_constants::Ki67_positive_postmitotic || code==PhysiCell_constants::Ki67_positive || code==PhysiCell_constants::Ki67_negative || code==PhysiCell_constants::live)
 				_nameCore="LIVE";
 			else if (code==PhysiCell_constants::apoptotic)
@@ -94,14 +465,14 @@ int writePov(std::vector<Cell*> all_cells, double timepoint, double scale)
 			else
 				_nameCore="MISC";
 		}
-		else if(all_cells[i]->type==PhysiCell_constants::TUMOR_TYPE)
+		else if(frame.type[i]==PhysiCell_constants::TUMOR_TYPE)
 			_nameCore="LIVE";
-		else if(all_cells[i]->type==PhysiCell_constants::VESSEL_TYPE)
+		else if(frame.type[i]==PhysiCell_constants::VESSEL_TYPE)
 			_nameCore="ENDO";
 		else
 			_nameCore="MISC";
-		std::string center= "<" + std::to_string(all_cells[i]->position[0]/scale) + "," + std::to_string(all_cells[i]->position[1]/scale) +","+ std::to_string(all_cells[i]->position[2]/scale) +">";
-		std::string core = "sphere {\n\t" + center + "\n\t " + std::to_string( all_cells[i]->phenotype.geometry.radius/scale) + "\n\t FinishMacro ( " + center +","+ _nameCore+ "Finish,"+ _nameCore + "*1)\n}\n";
+		std::string center= "<" + std::to_string(frame.position_x[i]/scale) + "," + std::to_string(frame.position_y[i]/scale) +","+ std::to_string(frame.position_z[i]/scale) +">";
+		std::string core = "sphere {\n\t" + center + "\n\t " + std::to_string( frame.radius[i]/scale) + "\n\t FinishMacro ( " + center +","+ _nameCore+ "Finish,"+ _nameCore + "*1)\n}\n";
 		povFile<< core;		
 	}
 	
@@ -112,28 +483,32 @@ int writePov(std::vector<Cell*> all_cells, double timepoint, double scale)
 
 int writeCellReport(std::vector<Cell*> all_cells, double timepoint)
 {
+	Cell_Output_Frame frame; 
+	stage_cell_frame( all_cells , timepoint , frame ); 
+	return writeCellReport( frame ); 
+}
+
+int writeCellReport(Cell_Output_Frame& frame)
+{
+	double timepoint = frame.time; 
 	std::string filename; 
 	filename.resize( 1024 ); 
 	sprintf( (char*) filename.c_str() , "output//cells_%i.txt" , (int)round(timepoint) ); 
 	std::ofstream povFile (filename.c_str(), std::ofstream::out);
 	povFile<<"\tID\tx\ty\tz\tradius\tvolume_total\tvolume_nuclear_fluid\tvolume_nuclear_solid\tvolume_cytoplasmic_fluid\tvolume_cytoplasmic_solid\tvolume_calcified_fraction\tphenotype\telapsed_time\n";
-	int phenotype_code;
-	for(int i=0;i<all_cells.size();i++)
-	{
-		phenotype_code = all_cells[i]->phenotype.cycle.current_phase().code;
-		// phenotype_code = phases.size()>0?all_cells[i]->phenotype.cycle.phases[all_cells[i]->phenotype.current_phase_index].code:-1;
-		povFile<<i<<"\t"<<all_cells[i]->ID<<"\t"<<all_cells[i]->position[0]<<"\t" << all_cells[i]->position[1] <<"\t"<< all_cells[i]->position[2]<<"\t";
-		povFile<<all_cells[i]->phenotype.geometry.radius<<"\t"<<all_cells[i]->phenotype.volume.total<<"\t"<<all_cells[i]->phenotype.volume.nuclear_fluid
-		<<"\t"<<all_cells[i]->phenotype.volume.nuclear_solid<<"\t"<<all_cells[i]->phenotype.volume.cytoplasmic_fluid<<"\t"<<
-		all_cells[i]->phenotype.volume.cytoplasmic_solid<<"\t"<<all_cells[i]->phenotype.volume.calcified_fraction<<"\t"<<phenotype_code<< 
-		// "\t"<< all_cells[i]->phenotype.cycle.phases[all_cells[i]->phenotype.current_phase_index].elapsed_time <<std::endl;		
-		"\t"<< all_cells[i]->phenotype.cycle.data.elapsed_time_in_phase <<std::endl;		
+	for(int i=0;i<frame.size();i++)
+	{
+		povFile<<i<<"\t"<<frame.ID[i]<<"\t"<<frame.position_x[i]<<"\t" << frame.position_y[i] <<"\t"<< frame.position_z[i]<<"\t";
+		povFile<<frame.radius[i]<<"\t"<<frame.volume_total[i]<<"\t"<<frame.volume_nuclear_fluid[i]
+		<<"\t"<<frame.volume_nuclear_solid[i]<<"\t"<<frame.volume_cytoplasmic_fluid[i]<<"\t"<<
+		frame.volume_cytoplasmic_solid[i]<<"\t"<<frame.volume_calcified_fraction[i]<<"\t"<<frame.phase_code[i]<< 
+		"\t"<< frame.elapsed_time_in_phase[i] <<std::endl;		
 	}
 	povFile.close();
 	return 0;
 }
 
-void log_output(double t, int output_index, Microenvironment microenvironment, std::ofstream& report_file)
+void log_output(double t, int output_index, Microenvironment& microenvironment, std::ofstream& report_file)
 {
 	double scale=1000;
 	int num_new_cells= 0;
@@ -152,19 +527,38 @@ void log_output(double t, int output_index, Microenvironment microenvironment, s
 	num_new_cells=t==0?all_basic_agents.size():((Cell_Container *)microenvironment.agent_container)->num_divisions_in_current_step;
 	num_deaths=((Cell_Container *)microenvironment.agent_container)->num_deaths_in_current_step;
 	std::cout<<"total number of agents (newly born, deaths): " << (*all_cells).size()<<"("<<num_new_cells<<", "<<num_deaths<<")" << std::endl; 
-	report_file<<t<<"\t"<<(*all_cells).size()<<"\t"<<num_new_cells<<"\t"<<num_deaths<<"\t"<<BioFVM::stopwatch_value()<< std::endl; 
-	BioFVM::TIC();
+	// the counts and the interval stopwatch cover the time since the last report line 
+	if( output_policy.simulation_report.due( output_index ) || !output_policy.simulation_report.enabled() )
+	{
+		if( output_policy.simulation_report.enabled() )
+		{ report_file<<t<<"\t"<<(*all_cells).size()<<"\t"<<num_new_cells<<"\t"<<num_deaths<<"\t"<<BioFVM::stopwatch_value()<< std::endl; }
+		((Cell_Container *)microenvironment.agent_container)->num_divisions_in_current_step=0;
+		((Cell_Container *)microenvironment.agent_container)->num_deaths_in_current_step=0;
+		BioFVM::TIC();
+	}
 	
-	((Cell_Container *)microenvironment.agent_container)->num_divisions_in_current_step=0;
-	((Cell_Container *)microenvironment.agent_container)->num_deaths_in_current_step=0;
-	writePov(*all_cells, t, scale);
-	writeCellReport(*all_cells, t);
-	std::string filename; 
-	filename.resize( 1024 , '\0' ); 
-	sprintf( (char*) filename.c_str() , "output%08d.mat" , output_index ); 
-	filename.resize( strlen( filename.c_str() ) ); 
-	// std::cout << "\tWriting to file " << filename << " ... " << std::endl; 
-	// microenvironment.write_to_matlab( filename ); 
+	bool write_frame = output_policy.cell_frames.due( output_index ); 
+	bool write_pov = output_policy.POV.due( output_index ); 
+	bool write_cell_report = output_policy.cell_report.due( output_index ); 
+	if( !write_frame && !write_pov && !write_cell_report )
+	{ return; }
+	
+	// stage a copy of the cells, and write the files in the background 
+	std::shared_ptr<Cell_Output_Frame> frame( new Cell_Output_Frame ); 
+	stage_cell_frame( *all_cells , t , *frame ); 
+	std::string frames_filename = cell_output_options.binary_frames_filename; 
+	bool start_new_file = !( cell_output_options.binary_frames_started || cell_output_options.continue_binary_frames ); 
+	if( write_frame )
+	{ cell_output_options.binary_frames_started = true; }
+	output_writer.submit( [frame,frames_filename,start_new_file,write_frame,write_pov,write_cell_report,scale]() 
+	{
+		if( write_frame )
+		{ append_cell_frame( frames_filename , *frame , start_new_file ); }
+		if( write_pov )
+		{ writePov(*frame, scale); }
+		if( write_cell_report )
+		{ writeCellReport(*frame); }
+	} ); 
 	
 	return;
 }
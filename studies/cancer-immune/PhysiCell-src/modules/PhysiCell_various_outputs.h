@@ -66,6 +66,7 @@
 #define __PhysiCell_various_outputs_h__
 
 #include <iostream>
+#include <cstdio>
 #include <ctime>
 #include <cmath>
 #include <string>
@@ -78,9 +79,125 @@
 
 namespace PhysiCell{
 
+/* 
+   Which outputs are written, and how often. Each artifact has an interval, 
+   counted in output times (the main loop's output_index): 1 writes it at every 
+   output, N at every N-th, and 0 never (and then skips staging it, too). 
+   Settings can come from the <save> element of PhysiCell_settings.xml, e.g., 
+   
+   <save>
+      <svg>10</svg>
+      <pov>off</pov>
+   </save>
+   
+   or from set() (e.g., a command-line "svg=10"). Values are a number, on (1), 
+   or off (0). 
+*/ 
+
+class Output_Artifact
+{
+ public:
+	int interval; 
+	
+	Output_Artifact(); 
+	Output_Artifact( int interval ); 
+	
+	bool enabled( void ); 
+	bool due( int output_index ); 
+};
+
+class Output_Policy
+{
+ public:
+	Output_Artifact SVG; // snapshot%08u.svg 
+	Output_Artifact cell_frames; // binary cell frames (see append_cell_frame) 
+	Output_Artifact POV; // output//cells_<t>.pov 
+	Output_Artifact cell_report; // output//cells_<t>.txt 
+	Output_Artifact MultiCellDS; // output%08u.xml and its .mat files 
+	Output_Artifact simulation_report; // a line of simulation_report.txt 
+	
+	bool initial_and_final; // initial and final MultiCellDS (.xml, .mat) and .svg 
+	bool MultiCellDS_cell_data; // include the cells (.mat) in MultiCellDS outputs 
+	
+	Output_Policy(); 
+	
+	// names: svg, cell_frames, pov, cell_report, multicellds, simulation_report, 
+	// initial_and_final, multicellds_cell_data 
+	bool set( std::string name , std::string value ); 
+	bool read_from_xml( std::string filename ); 
+	void display( std::ostream& os ); 
+};
+
+extern Output_Policy output_policy; 
+
+// where log_output() writes the binary cell frames 
+class Cell_Output_Options
+{
+ public:
+	std::string binary_frames_filename; 
+	bool continue_binary_frames; // append to the existing file (e.g., after a restart) instead of starting a new one 
+	
+	bool binary_frames_started; 
+	
+	Cell_Output_Options(); 
+};
+
+extern Cell_Output_Options cell_output_options; 
+
+// a copy of the per-cell output fields, one column per field 
+class Cell_Output_Frame
+{
+ public:
+	double time; 
+	
+	std::vector<int> ID; 
+	std::vector<int> type; 
+	std::vector<int> phase_code; // -1 without a cycle model 
+	
+	std::vector<double> elapsed_time_in_phase; 
+	std::vector<double> position_x; 
+	std::vector<double> position_y; 
+	std::vector<double> position_z; 
+	std::vector<double> radius; 
+	std::vector<double> volume_total; 
+	std::vector<double> volume_nuclear_fluid; 
+	std::vector<double> volume_nuclear_solid; 
+	std::vector<double> volume_cytoplasmic_fluid; 
+	std::vector<double> volume_cytoplasmic_solid; 
+	std::vector<double> volume_calcified_fraction; 
+	
+	void resize( int n ); 
+	int size( void ); 
+	
+	std::vector< std::vector<int>* > int_columns( void ); 
+	std::vector< std::vector<double>* > double_columns( void ); 
+};
+
+void stage_cell_frame( std::vector<Cell*>& cells , double time , Cell_Output_Frame& frame ); 
+
+/* 
+   Binary cell frames: one file per run, starting with a schema header (magic, 
+   version, and the type and name of each column), followed by one record per 
+   output time: a marker, the time, the number of cells n, and then each column 
+   as n contiguous values (int32 or float64, native byte order). 
+*/ 
+
+bool append_cell_frame( std::string filename , Cell_Output_Frame& frame , bool start_new_file ); 
+// returns NULL if the file does not start with the expected schema 
+FILE* open_cell_frames( std::string filename ); 
+bool read_cell_frame( FILE* fp , Cell_Output_Frame& frame ); 
+// drops the frames at or after time (to continue a run from a checkpoint) 
+bool truncate_cell_frames( std::string filename , double time ); 
+// writes the .pov and cell report text files of every frame; returns the number of frames 
+int convert_cell_frames_to_text( std::string filename , double scale ); 
+
 int writePov(std::vector<Cell*> all_cells, double timepoint, double scale);
+int writePov(Cell_Output_Frame& frame, double scale);
 int writeCellReport(std::vector<Cell*> all_cells, double timepoint);
-void log_output(double t, int output_index, Microenvironment microenvironment, std::ofstream& report_file);
+int writeCellReport(Cell_Output_Frame& frame);
+// writes what output_policy asks for at this output_index; the cell frames and 
+// text reports are written through output_writer 
+void log_output(double t, int output_index, Microenvironment& microenvironment, std::ofstream& report_file);
 	
 };
 
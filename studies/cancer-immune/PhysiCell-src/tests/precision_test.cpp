@@ -0,0 +1,189 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+/* 
+   Accuracy check for single-precision densities (BIOFVM_SINGLE_PRECISION_DENSITIES). 
+   This file is built twice: 
+   
+   precision_test_double : solves a 3D diffusion-decay problem with the LOD solver 
+                           and writes the final fields (as doubles) to a file 
+   precision_test_single : solves the same problem with single-precision densities, 
+                           and compares with that file 
+   
+   The test fails if the largest relative error (relative to each value, but at least 
+   1e-6 of the substrate's largest value) is above the bound. The first step runs on 
+   one thread and the rest on four, so the solvers' per-thread work space must follow 
+   a change in the thread count. 
+   
+   build and run with: make -f Makefile-immune precision-test 
+*/
+
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <omp.h>
+
+#include "../BioFVM/BioFVM.h"
+
+using namespace BioFVM; 
+
+void solve_test_problem( Microenvironment& M )
+{
+	M.name = "precision test"; 
+	M.set_density( 0 , "oxygen" , "mmHg" , 1e5 , 0.1 ); 
+	M.add_density( "factor" , "dimensionless" , 1e3 , 0.01 ); 
+	M.resize_space_uniform( -200 , 200 , -200 , 200 , -200 , 200 , 20 ); 
+	M.diffusion_decay_solver = diffusion_decay_solver__constant_coefficients_LOD_3D; 
+	
+	// oxygen: fixed at 38 mmHg on the boundary, 0 inside. factor: a Gaussian bump. 
+	std::vector<double> boundary_value( 2 , 38.0 ); 
+	for( int n=0; n < M.number_of_voxels() ; n++ )
+	{
+		std::vector<double>& center = M.voxels(n).center; 
+		double r2 = center[0]*center[0] + center[1]*center[1] + center[2]*center[2]; 
+		M.density_vector(n)[0] = 0.0; 
+		M.density_vector(n)[1] = exp( -r2 / ( 2.0 * 60.0 * 60.0 ) ); 
+		
+		std::vector<int> indices = M.cartesian_indices(n); 
+		int last = M.mesh.x_coordinates.size()-1; 
+		if( indices[0] == 0 || indices[1] == 0 || indices[2] == 0 || 
+			indices[0] == last || indices[1] == last || indices[2] == last )
+		{ M.add_dirichlet_node( n , boundary_value ); }
+	}
+	M.set_substrate_dirichlet_activation( 1 , false ); 
+	
+	double dt = 0.01; 
+	omp_set_num_threads( 1 ); 
+	M.simulate_diffusion_decay( dt ); 
+	omp_set_num_threads( 4 ); 
+	for( int i=1; i < 200 ; i++ )
+	{ M.simulate_diffusion_decay( dt ); }
+	return; 
+}
+
+int main( int argc, char* argv[] )
+{
+	const double relative_error_bound = 1e-5; 
+	
+	std::string filename = "precision_test_reference.bin"; 
+	if( argc > 1 )
+	{ filename = argv[1]; }
+	
+	Microenvironment M; 
+	solve_test_problem( M ); 
+	int number_of_voxels = M.number_of_voxels(); 
+	int number_of_densities = M.number_of_densities(); 
+	
+#ifndef BIOFVM_SINGLE_PRECISION_DENSITIES
+	std::vector<double> values( number_of_voxels*number_of_densities ); 
+	for( int n=0; n < number_of_voxels ; n++ )
+	{
+		for( int q=0; q < number_of_densities ; q++ )
+		{ values[ n*number_of_densities + q ] = M.density_vector(n)[q]; }
+	}
+	std::ofstream file( filename.c_str() , std::ios::binary ); 
+	file.write( (const char*) values.data() , values.size()*sizeof(double) ); 
+	if( !file )
+	{
+		std::cout << "Error: could not write " << filename << std::endl; 
+		return 1; 
+	}
+	std::cout << "wrote the double-precision reference to " << filename << std::endl; 
+	return 0; 
+#else
+	std::vector<double> reference( number_of_voxels*number_of_densities ); 
+	std::ifstream file( filename.c_str() , std::ios::binary ); 
+	file.read( (char*) reference.data() , reference.size()*sizeof(double) ); 
+	if( !file )
+	{
+		std::cout << "Error: could not read the double-precision reference " << filename << std::endl; 
+		return 1; 
+	}
+	
+	bool passed = true; 
+	for( int q=0; q < number_of_densities ; q++ )
+	{
+		double largest_value = 0.0; 
+		for( int n=0; n < number_of_voxels ; n++ )
+		{ largest_value = std::max( largest_value , fabs( reference[ n*number_of_densities + q ] ) ); }
+		
+		double max_relative_error = 0.0; 
+		for( int n=0; n < number_of_voxels ; n++ )
+		{
+			double value = reference[ n*number_of_densities + q ]; 
+			double scale = std::max( fabs( value ) , 1e-6 * largest_value ); 
+			double error = fabs( M.density_vector(n)[q] - value ) / scale; 
+			max_relative_error = std::max( max_relative_error , error ); 
+		}
+		bool substrate_passed = ( max_relative_error <= relative_error_bound ); 
+		std::cout << ( substrate_passed ? "PASS " : "FAIL " ) << M.density_names[q] 
+			<< ": max relative error (single vs double) " << max_relative_error 
+			<< " (bound " << relative_error_bound << ")" << std::endl; 
+		passed = passed && substrate_passed; 
+	}
+	return passed ? 0 : 1; 
+#endif 
+}
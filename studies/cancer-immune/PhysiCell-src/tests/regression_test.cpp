@@ -0,0 +1,189 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+/* 
+   Regression test for the solver and mechanics changes: runs a small 
+   cancer-immune problem (200 micron domain, 100 immune cells) for 700 
+   diffusion steps on one thread, and compares checksums of the final 
+   substrate fields and cell positions with reference values. 
+   
+   regression_test          default options; the reference is the output of 
+                            the code before the performance work (PhysiCell 
+                            1.2.1 / BioFVM as originally shipped here) 
+   regression_test fused    with fused_cell_sources_and_sinks, which moves the 
+                            cell secretion/uptake into the next diffusion step 
+                            and so changes the results (factor sum by about 
+                            2e-4, positions by about 2e-5); its reference was 
+                            recorded with that option on 
+   
+   The references were recorded on x86-64 (g++ -march=native). Other targets 
+   (or other SIMD kernels) round differently, so the sums are compared 
+   to a relative tolerance rather than bit for bit. 
+   
+   build and run both with: make -f Makefile-immune regression-test 
+*/
+
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <omp.h>
+
+#include "../core/PhysiCell.h"
+#include "../modules/PhysiCell_standard_modules.h" 
+#include "../custom_modules/cancer_immune_3D.h" 
+
+using namespace BioFVM; 
+using namespace PhysiCell; 
+
+bool check_value( std::string name , double value , double reference , double tolerance )
+{
+	double error = fabs( value - reference ) / fabs( reference ); 
+	bool passed = ( error <= tolerance ); 
+	std::cout << ( passed ? "PASS " : "FAIL " ) << name << ": " << value 
+		<< " (reference " << reference << ", relative error " << error << ")" << std::endl; 
+	return passed; 
+}
+
+int main( int argc, char* argv[] )
+{
+	bool fused = ( argc > 1 && std::string( argv[1] ) == "fused" ); 
+	
+	const int number_of_steps = 700; 
+	const double tolerance = 1e-8; 
+	
+	// default options: recorded with the code before the performance work 
+	int reference_cell_count = 693; 
+	double reference_oxygen_sum = 2.956684571478e+05; 
+	double reference_factor_sum = 4.206194145211e+03; 
+	double reference_position_sum = 3.050993733151e+03; 
+	if( fused )
+	{
+		// fused cell sources and sinks: recorded with that option on 
+		reference_cell_count = 693; 
+		reference_oxygen_sum = 2.956684571698e+05; 
+		reference_factor_sum = 4.207024740519e+03; 
+		reference_position_sum = 3.051060674283e+03; 
+	}
+	
+	omp_set_num_threads( 1 ); 
+	SeedRandom( 0 ); 
+	
+	cancer_immune_options.domain_size = 200; 
+	cancer_immune_options.initial_tumor_radius = 80; 
+	cancer_immune_options.number_of_immune_cells = 100; 
+	cancer_immune_options.attachment_rate = 0.2; 
+	cancer_immune_options.attachment_lifetime = 60; 
+	cancer_immune_options.oncoprotein_detection_threshold = 0.5; 
+	cancer_immune_options.oncoprotein_saturation = 2.0; 
+	cancer_immune_options.migration_bias = 0.5; 
+	cancer_immune_options.kill_rate = 0.067; 
+	
+	default_microenvironment_options.density_layout = density_layout_voxel_major; 
+	default_microenvironment_options.fused_cell_sources_and_sinks = fused; 
+	
+	setup_microenvironment(); 
+	Cell_Container* cell_container = create_cell_container_for_microenvironment( microenvironment, 30 ); 
+	create_cell_types(); 
+	setup_tissue(); 
+	introduce_immune_cells(); 
+	
+	double t = 0.0; 
+	for( int n=0; n < number_of_steps ; n++ )
+	{
+		microenvironment.simulate_diffusion_decay( diffusion_dt ); 
+		if( default_microenvironment_options.calculate_gradients && 
+			!default_microenvironment_options.calculate_gradients_on_demand )
+		{ microenvironment.compute_all_gradient_vectors(); }
+		cell_container->update_all_cells( t ); 
+		t += diffusion_dt; 
+	}
+	if( microenvironment.fused_cell_sources_and_sinks )
+	{ microenvironment.simulate_binned_cell_sources_and_sinks( diffusion_dt ); }
+	
+	double oxygen_sum = 0.0; 
+	double factor_sum = 0.0; 
+	for( int n=0; n < microenvironment.number_of_voxels() ; n++ )
+	{
+		oxygen_sum += microenvironment.density_vector(n)[0]; 
+		factor_sum += microenvironment.density_vector(n)[1] * ( 1 + n%7 ); 
+	}
+	double position_sum = 0.0; 
+	for( int i=0; i < (*all_cells).size() ; i++ )
+	{
+		Cell* pCell = (*all_cells)[i]; 
+		position_sum += pCell->position[0] * ( 1 + pCell->ID % 5 ) + pCell->position[1] + 0.5 * pCell->position[2]; 
+	}
+	
+	std::cout.precision( 13 ); 
+	std::cout << "fused cell sources and sinks: " << ( fused ? "on" : "off" ) << std::endl; 
+	bool passed = ( (*all_cells).size() == reference_cell_count ); 
+	std::cout << ( passed ? "PASS " : "FAIL " ) << "cells: " << (*all_cells).size() 
+		<< " (reference " << reference_cell_count << ")" << std::endl; 
+	passed = check_value( "oxygen" , oxygen_sum , reference_oxygen_sum , tolerance ) && passed; 
+	passed = check_value( "immunostimulatory factor" , factor_sum , reference_factor_sum , tolerance ) && passed; 
+	passed = check_value( "positions" , position_sum , reference_position_sum , tolerance ) && passed; 
+	
+	return passed ? 0 : 1; 
+}
@@ -0,0 +1,217 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+/* 
+   Compares the batched Thomas kernels (generic, and AVX2 / AVX-512 where the 
+   CPU has them) with a plain scalar Thomas solve on random LOD-type systems. 
+   The SIMD kernels fuse multiply-adds, so they are checked to a relative 
+   tolerance, not bit for bit. This file is compiled with -ffp-contract=off 
+   so that the scalar reference is not contracted either. 
+   
+   build and run with: make -f Makefile-immune thomas-kernel-test 
+*/
+
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../BioFVM/BioFVM_simd.h"
+
+using namespace BioFVM; 
+
+struct Test_Systems
+{
+	int width; 
+	int length; 
+	long step; 
+	std::vector<double> c1; // [lane]
+	std::vector<double> denom; // [position][lane] 
+	std::vector<double> c; // [position][lane] 
+	std::vector<double> right_hand_side; // [position*step + lane] 
+}; 
+
+// LOD-type systems: -a x[p-1] + (1+2a+decay) x[p] - a x[p+1] = rhs[p] (zero flux at the ends), 
+// with the coefficients of the forward elimination precomputed as in the solvers 
+void setup_test_systems( Test_Systems& systems , int width , int length , std::mt19937_64& generator )
+{
+	std::uniform_real_distribution<double> a_distribution( 0.1 , 4.0 ); 
+	std::uniform_real_distribution<double> decay_distribution( 0.0 , 0.1 ); 
+	std::uniform_real_distribution<double> value_distribution( 0.5 , 1.5 ); 
+	
+	systems.width = width; 
+	systems.length = length; 
+	systems.step = width + 5; // padding between positions, as in a strided sweep 
+	systems.c1.resize( width ); 
+	systems.denom.resize( length*width ); 
+	systems.c.resize( length*width ); 
+	systems.right_hand_side.assign( length*systems.step , 0.0 ); 
+	
+	for( int l=0; l < width ; l++ )
+	{
+		double a = a_distribution( generator ); 
+		double decay = decay_distribution( generator ); 
+		systems.c1[l] = a; 
+		for( int p=0; p < length ; p++ )
+		{
+			double diagonal = 1.0 + 2.0*a + decay; 
+			if( p == 0 || p == length-1 )
+			{ diagonal = 1.0 + a + decay; }
+			double denom = diagonal; 
+			if( p > 0 )
+			{ denom -= a * ( -systems.c[ (p-1)*width + l ] ); }
+			systems.denom[ p*width + l ] = denom; 
+			systems.c[ p*width + l ] = -a / denom; 
+		}
+	}
+	for( int p=0; p < length ; p++ )
+	{
+		for( int l=0; l < width ; l++ )
+		{ systems.right_hand_side[ p*systems.step + l ] = value_distribution( generator ); }
+	}
+	return; 
+}
+
+// one lane at a time, no fused multiply-adds 
+void scalar_thomas( Test_Systems& systems , std::vector<double>& x )
+{
+	x = systems.right_hand_side; 
+	int width = systems.width; 
+	long step = systems.step; 
+	for( int l=0; l < width ; l++ )
+	{
+		x[l] /= systems.denom[l]; 
+		for( int p=1; p < systems.length ; p++ )
+		{
+			double product = systems.c1[l] * x[ (p-1)*step + l ]; 
+			x[ p*step + l ] += product; 
+			x[ p*step + l ] /= systems.denom[ p*width + l ]; 
+		}
+		for( int p=systems.length-2; p >= 0 ; p-- )
+		{
+			double product = systems.c[ p*width + l ] * x[ (p+1)*step + l ]; 
+			x[ p*step + l ] -= product; 
+		}
+	}
+	return; 
+}
+
+bool test_kernel( std::string name , batched_thomas_kernel kernel , double tolerance )
+{
+	const int widths[] = { 1 , 3 , 8 , 16 , 37 , 64 }; 
+	const int lengths[] = { 2 , 13 , 100 }; 
+	
+	std::mt19937_64 generator( 1 ); 
+	double max_relative_error = 0.0; 
+	for( int i=0; i < 6 ; i++ )
+	{
+		for( int j=0; j < 3 ; j++ )
+		{
+			Test_Systems systems; 
+			setup_test_systems( systems , widths[i] , lengths[j] , generator ); 
+			std::vector<double> reference; 
+			scalar_thomas( systems , reference ); 
+			
+			std::vector<double> x = systems.right_hand_side; 
+			kernel( x.data() , systems.step , systems.width , systems.length , 
+				systems.c1.data() , systems.denom.data() , systems.c.data() , systems.width ); 
+			
+			for( int p=0; p < systems.length ; p++ )
+			{
+				for( int l=0; l < systems.width ; l++ )
+				{
+					long n = p*systems.step + l; 
+					double error = fabs( x[n] - reference[n] ) / fabs( reference[n] ); 
+					if( error > max_relative_error )
+					{ max_relative_error = error; }
+				}
+			}
+		}
+	}
+	
+	bool passed = ( max_relative_error <= tolerance ); 
+	std::cout << ( passed ? "PASS " : "FAIL " ) << name << " kernel: max relative error " 
+		<< max_relative_error << " (tolerance " << tolerance << ")" << std::endl; 
+	return passed; 
+}
+
+int main( int argc, char* argv[] )
+{
+	const double tolerance = 1e-12; 
+	
+	bool passed = test_kernel( "generic" , batched_thomas_generic , tolerance ); 
+#ifdef BIOFVM_X86_SIMD
+	if( cpu_supports_avx2() )
+	{ passed = test_kernel( "AVX2" , batched_thomas_avx2 , tolerance ) && passed; }
+	else
+	{ std::cout << "SKIP AVX2 kernel (not supported by this CPU)" << std::endl; }
+	if( cpu_supports_avx512() )
+	{ passed = test_kernel( "AVX-512" , batched_thomas_avx512 , tolerance ) && passed; }
+	else
+	{ std::cout << "SKIP AVX-512 kernel (not supported by this CPU)" << std::endl; }
+#endif 
+	
+	return passed ? 0 : 1; 
+}
@@ -0,0 +1,197 @@
+/*
+#############################################################################
+# If you use PhysiCell in your project, please cite PhysiCell and the ver-  #
+# sion number, such as below:                                               #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1].  #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# Because PhysiCell extensively uses BioFVM, we suggest you also cite       #
+#     BioFVM as below:                                                      #
+#                                                                           #
+# We implemented and solved the model using PhysiCell (Version 1.2.1) [1],  #
+# with BioFVM [2] to solve the transport equations.                         #
+#                                                                           #
+# [1] A Ghaffarizadeh, SH Friedman, SM Mumenthaler, and P Macklin,          #
+#     PhysiCell: an Open Source Physics-Based Cell Simulator for            #
+#     Multicellular Systems, PLoS Comput. Biol. 2017 (in revision).         #
+#     preprint DOI: 10.1101/088773                                          #
+#                                                                           #
+# [2] A Ghaffarizadeh, SH Friedman, and P Macklin, BioFVM: an efficient     #
+#    parallelized diffusive transport solver for 3-D biological simulations,#
+#    Bioinformatics 32(8): 1256-8, 2016. DOI: 10.1093/bioinformatics/btv730 #
+#                                                                           #
+#############################################################################
+#                                                                           #
+# BSD 3-Clause License (see https://opensource.org/licenses/BSD-3-Clause)   #
+#                                                                           #
+# Copyright (c) 2015-2017, Paul Macklin and the PhysiCell Project           #
+# All rights reserved.                                                      #
+#                                                                           #
+# Redistribution and use in source and binary forms, with or without        #
+# modification, are permitted provided that the following conditions are    #
+# met:                                                                      #
+#                                                                           #
+# 1. Redistributions of source code must retain the above copyright notice, #
+# this list of conditions and the following disclaimer.                     #
+#                                                                           #
+# 2. Redistributions in binary form must reproduce the above copyright      #
+# notice, this list of conditions and the following disclaimer in the       #
+# documentation and/or other materials provided with the distribution.      #
+#                                                                           #
+# 3. Neither the name of the copyright holder nor the names of its          #
+# contributors may be used to endorse or promote products derived from this #
+# software without specific prior written permission.                       #
+#                                                                           #
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS       #
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED #
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A           #
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER #
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,  #
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,       #
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR        #
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF    #
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING      #
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS        #
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.              #
+#                                                                           #
+#############################################################################
+*/
+
+/* 
+   Micro-benchmark of the z-sweep of the 3D LOD solver (the sweep whose lines 
+   are a full z-plane apart in memory). For n^3 meshes with 2 substrates in the 
+   voxel-major layout, it times one thread doing: 
+   
+   line-at-a-time : thomas_solve_line on each of the n^2 z-lines 
+   x-row batched  : thomas_solve_rows on all lines of an x-row at once 
+   tiles          : thomas_solve_rows on tiles of consecutive voxels of the first 
+                    z-plane (the solver uses 16) 
+   
+   and prints ns per (voxel, substrate) entry. The coefficients are fixed, so 
+   the values being solved converge; only the timing matters. 
+   
+   build and run with: make -f Makefile-immune z-sweep-benchmark 
+   or: ./z_sweep_benchmark [mesh size] ... 
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <omp.h>
+
+#include "../BioFVM/BioFVM.h"
+
+using namespace BioFVM; 
+
+int main( int argc, char* argv[] )
+{
+	std::vector<int> mesh_sizes; 
+	for( int i=1; i < argc ; i++ )
+	{ mesh_sizes.push_back( atoi( argv[i] ) ); }
+	if( mesh_sizes.size() == 0 )
+	{
+		mesh_sizes.push_back( 32 ); 
+		mesh_sizes.push_back( 66 ); 
+		mesh_sizes.push_back( 100 ); 
+		mesh_sizes.push_back( 200 ); 
+	}
+	const int tile_sizes[] = { 4 , 8 , 16 , 32 }; 
+	const int number_of_densities = 2; 
+	
+	omp_set_num_threads( 1 ); 
+	batched_thomas_kernel kernel = select_batched_thomas_kernel(); 
+	std::cout << "z-sweep, " << number_of_densities << " substrates, voxel-major layout, " 
+		<< batched_thomas_kernel_name() << " kernel, one thread (ns per entry)" << std::endl << std::endl; 
+	
+	std::vector<int> substrates; 
+	for( int q=0; q < number_of_densities ; q++ )
+	{ substrates.push_back( q ); }
+	
+	for( int m=0; m < mesh_sizes.size() ; m++ )
+	{
+		int n = mesh_sizes[m]; 
+		long number_of_entries = (long) n*n*n*number_of_densities; 
+		
+		Density_Storage D; 
+		D.set_layout( density_layout_voxel_major ); 
+		D.assign( n*n*n , std::vector<double>( number_of_densities , 1.0 ) ); 
+		for( long i=0; i < number_of_entries ; i++ )
+		{ D.pointer()[i] = 0.01 * ( i % 97 ); }
+		
+		// LOD-type coefficients (as set up by the solver for D*dt/dz^2 = 0.4) 
+		std::vector<double> constant1( number_of_densities , 0.4 ); 
+		std::vector< std::vector<double> > constant1_table( 1 , constant1 ); 
+		std::vector< std::vector<double> > denom( n , std::vector<double>( number_of_densities , 1.8 ) ); 
+		std::vector< std::vector<double> > c( n , std::vector<double>( number_of_densities , -0.3 ) ); 
+		
+		std::vector<double> scratch( thomas_scratch_size( n , n*number_of_densities ) ); 
+		long vs = D.voxel_stride(); 
+		long k_jump = (long) n*n*vs; 
+		int repetitions = 200000000 / ( n*n*n ) + 1; 
+		
+		BioFVM::TIC(); 
+		for( int r=0; r < repetitions ; r++ )
+		{
+			for( int v=0; v < n*n ; v++ )
+			{ thomas_solve_line( D.pointer() + v*vs , k_jump , D.substrate_stride() , n , constant1 , denom , c , scratch.data() , substrates ); }
+		}
+		BioFVM::TOC(); 
+		printf( "n = %3d  line-at-a-time : %6.3f\n" , n , BioFVM::stopwatch_value() / repetitions / number_of_entries * 1e9 ); 
+		
+		aligned_vector row_constant1; 
+		aligned_vector row_denom; 
+		aligned_vector row_c; 
+		expand_thomas_coefficients_to_lanes( constant1_table , n , density_layout_voxel_major , row_constant1 ); 
+		expand_thomas_coefficients_to_lanes( denom , n , density_layout_voxel_major , row_denom ); 
+		expand_thomas_coefficients_to_lanes( c , n , density_layout_voxel_major , row_c ); 
+		
+		BioFVM::TIC(); 
+		for( int r=0; r < repetitions ; r++ )
+		{
+			for( int j=0; j < n ; j++ )
+			{
+				thomas_solve_rows( kernel , D , D.pointer() + (long) j*n*vs , k_jump , n , 0 , n , n , 
+					row_constant1 , row_denom , row_c , scratch.data() , substrates ); 
+			}
+		}
+		BioFVM::TOC(); 
+		printf( "n = %3d  x-row batched  : %6.3f\n" , n , BioFVM::stopwatch_value() / repetitions / number_of_entries * 1e9 ); 
+		
+		for( int b=0; b < 4 ; b++ )
+		{
+			int tile_size = tile_sizes[b]; 
+			aligned_vector tile_constant1; 
+			aligned_vector tile_denom; 
+			aligned_vector tile_c; 
+			expand_thomas_coefficients_to_lanes( constant1_table , tile_size , density_layout_voxel_major , tile_constant1 ); 
+			expand_thomas_coefficients_to_lanes( denom , tile_size , density_layout_voxel_major , tile_denom ); 
+			expand_thomas_coefficients_to_lanes( c , tile_size , density_layout_voxel_major , tile_c ); 
+			
+			int plane_size = n*n; 
+			int number_of_tiles = ( plane_size + tile_size - 1 ) / tile_size; 
+			BioFVM::TIC(); 
+			for( int r=0; r < repetitions ; r++ )
+			{
+				for( int t=0; t < number_of_tiles ; t++ )
+				{
+					int n_start = t*tile_size; 
+					int n_end = n_start + tile_size; 
+					if( n_end > plane_size )
+					{ n_end = plane_size; }
+					thomas_solve_rows( kernel , D , D.pointer() + (long) n_start*vs , k_jump , tile_size , 0 , n_end-n_start , n , 
+						tile_constant1 , tile_denom , tile_c , scratch.data() , substrates ); 
+				}
+			}
+			BioFVM::TOC(); 
+			printf( "n = %3d  %2d-voxel tiles : %6.3f\n" , n , tile_size , BioFVM::stopwatch_value() / repetitions / number_of_entries * 1e9 ); 
+		}
+		std::cout << std::endl; 
+	}
+	
+	return 0; 
+}